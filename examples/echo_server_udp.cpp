@@ -1,33 +1,26 @@
 #include "basic/address.h"
 #include "basic/iomanager.h"
 #include "basic/log.h"
-#include "basic/socket.h"
-#include "http/http_server.h"
+#include "basic/udp_server.h"
 
 using namespace Basic;
 
 void run() {
   IPAddress::ptr addr = Address::LookupAnyIPAddress("0.0.0.0:8020");
 
-  Socket::ptr sock = Socket::CreateUDP(addr);
-  if (sock->bind(addr)) {
-    LOG_INFO_STREAM << "udp bind : " << *addr;
-  } else {
-    LOG_ERROR_STREAM << "udp bind : " << *addr << "fail";
-    return;
-  }
-
-  http::HttpServer::ptr http_server(new http::HttpServer(true));
-  while (!http_server->bind(addr, false)) {
-    LOG_ERROR_STREAM << "bind " << *addr << " fail";
+  UdpServer::ptr udp_server(new UdpServer);
+  udp_server->setHandler([](const UdpServer::Packet& packet, UdpServer::Reply& reply) {
+    reply.send(packet.data, packet.size);
+  });
+  while (!udp_server->bind(addr)) {
+    LOG_ERROR_STREAM << "udp bind " << *addr << " fail";
     sleep(1);
   }
-
-  http_server->start();
+  udp_server->start();
 }
 
 int main(int argc, char* argv[]) {
-  Basic::IOManager iom(1);
+  Basic::IOManager iom(2);
   iom.schedule(run);
   return 0;
 }
@@ -7,7 +7,10 @@
 #include <cstring>
 #include <sstream>
 
+#include "basic/dns.h"
 #include "basic/endian.h"
+#include "basic/hook.h"
+#include "basic/iomanager.h"
 #include "basic/log.h"
 
 namespace Basic {
@@ -80,6 +83,23 @@ bool Address::Lookup(std::vector<Address::ptr>& result, const std::string& host,
 
   if (node.empty()) { node = host; }
 
+  // 协程中走 DnsResolver, 避免 getaddrinfo 阻塞IO线程; 非数字端口仍交给 getaddrinfo
+  if (is_hook_enable() && IOManager::GetThis() &&
+      (family == AF_UNSPEC || family == AF_INET || family == AF_INET6) &&
+      (!service || (*service && strspn(service, "0123456789") == strlen(service)))) {
+    std::vector<IPAddress::ptr> addrs;
+    if (!DnsMgr::GetInstance()->resolve(addrs, node, family)) {
+      LOG_ERROR("Address::Lookup resolve(%s, %d) fail", host.c_str(), family);
+      return false;
+    }
+    uint16_t port = service ? atoi(service) : 0;
+    for (auto& i : addrs) {
+      i->setPort(port);
+      result.push_back(i);
+    }
+    return true;
+  }
+
   int error = getaddrinfo(node.c_str(), service, &hints, &results);
   if (error) {
     LOG_ERROR("Parser Error: %s, Address::Lookup getaddress(%s, %d, %d) err=%d errstr=%s",
@@ -450,6 +470,14 @@ void UnixAddress::setAddrLen(uint32_t v) {
   m_length = v;
 }
 
+std::string UnixAddress::getPath() const {
+  if (m_length <= offsetof(sockaddr_un, sun_path)) { return ""; }
+  size_t len = m_length - offsetof(sockaddr_un, sun_path);
+  // 抽象命名空间的地址以'\0'开头, 长度由 m_length 决定
+  if (m_addr.sun_path[0] == '\0') { return std::string(m_addr.sun_path, len); }
+  return std::string(m_addr.sun_path, strnlen(m_addr.sun_path, len));
+}
+
 std::ostream& UnixAddress::insert(std::ostream& os) const {
   if (m_length > offsetof(sockaddr_un, sun_path) && m_addr.sun_path[0] == '\0') {
     return os << "\\0"
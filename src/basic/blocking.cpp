@@ -0,0 +1,151 @@
+#include "basic/blocking.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <sstream>
+
+#include "basic/config.h"
+#include "basic/hook.h"
+#include "basic/log.h"
+#include "basic/scheduler.h"
+#include "basic/thread.h"
+
+namespace Basic {
+
+static ConfigVar<uint32_t>::ptr g_blocking_threads =
+    Config::Lookup("blocking.threads", (uint32_t)4, "阻塞调用线程池线程数");
+
+namespace {
+
+class BlockingPool {
+public:
+  BlockingPool() {
+    uint32_t count = std::max(g_blocking_threads->getValue(), (uint32_t)1);
+    for (uint32_t i = 0; i < count; ++i) {
+      m_threads.push_back(std::make_shared<Thread>(std::bind(&BlockingPool::run, this),
+                                                   "blocking_" + std::to_string(i)));
+    }
+  }
+
+  ~BlockingPool() {
+    {
+      Mutex::Lock lock(m_mutex);
+      m_stop = true;
+    }
+    for (size_t i = 0; i < m_threads.size(); ++i) {
+      m_sem.notify();
+    }
+    for (auto& i : m_threads) {
+      i->join();
+    }
+  }
+
+  void submit(TaskFunc&& task) {
+    {
+      Mutex::Lock lock(m_mutex);
+      m_tasks.push_back(Item{std::move(task), get_current_us()});
+      ++m_submitted;
+    }
+    m_sem.notify();
+  }
+
+  Blocking::Stats getStats() {
+    Blocking::Stats stats;
+    {
+      Mutex::Lock lock(m_mutex);
+      stats.queued = m_tasks.size();
+    }
+    stats.running   = m_running;
+    stats.submitted = m_submitted;
+    stats.completed = m_completed;
+    stats.waitUs    = m_waitUs;
+    stats.maxWaitUs = m_maxWaitUs;
+    return stats;
+  }
+
+private:
+  struct Item {
+    TaskFunc task;
+    uint64_t submitUs;
+  };
+
+  void run() {
+    while (true) {
+      m_sem.wait();
+      TaskFunc task;
+      uint64_t wait = 0;
+      {
+        Mutex::Lock lock(m_mutex);
+        if (m_tasks.empty()) {
+          if (m_stop) { return; }
+          continue;
+        }
+        task = std::move(m_tasks.front().task);
+        wait = get_current_us() - m_tasks.front().submitUs;
+        m_tasks.pop_front();
+      }
+      m_waitUs += wait;
+      for (uint64_t old = m_maxWaitUs; old < wait && !m_maxWaitUs.compare_exchange_weak(old, wait);) {}
+
+      ++m_running;
+      task();
+      --m_running;
+      ++m_completed;
+    }
+  }
+
+private:
+  Mutex                    m_mutex;
+  Semaphore                m_sem;
+  std::deque<Item>         m_tasks;
+  std::vector<Thread::ptr> m_threads;
+  bool                     m_stop = false;
+
+  std::atomic<uint64_t> m_running   = {0};
+  std::atomic<uint64_t> m_submitted = {0};
+  std::atomic<uint64_t> m_completed = {0};
+  std::atomic<uint64_t> m_waitUs    = {0};
+  std::atomic<uint64_t> m_maxWaitUs = {0};
+};
+
+typedef Singleton<BlockingPool> BlockingPoolMgr;
+
+}  // namespace
+
+bool Blocking::CanSuspend() {
+  return is_hook_enable() && Scheduler::GetThis() && Scheduler::IsRunningTask();
+}
+
+void Blocking::Execute(TaskFunc task) {
+  Scheduler* scheduler = Scheduler::GetThis();
+  Fiber::ptr fiber     = Fiber::GetThis();
+  int        thread    = get_thread_id();
+  // 挂起期间调度器看不到本协程, 计数不为0时调度器不会停止, 线程池唤醒时调度器仍然有效
+  ++scheduler->m_offloadCount;
+  BlockingPoolMgr::GetInstance()->submit(
+      [task = std::move(task), scheduler, fiber = std::move(fiber), thread]() mutable {
+        task();
+        // 在 Yield2Hold 之前完成时, 调度器会等协程切出后再切入
+        scheduler->schedule(std::move(fiber), thread);
+      });
+  Fiber::Yield2Hold();
+  // 回到调度线程后再减, 协程作为任务执行期间调度器同样不会停止
+  --scheduler->m_offloadCount;
+}
+
+Blocking::Stats Blocking::GetStats() {
+  return BlockingPoolMgr::GetInstance()->getStats();
+}
+
+std::string Blocking::ToString() {
+  Stats             stats = GetStats();
+  std::stringstream ss;
+  ss << "[Blocking queued=" << stats.queued << " running=" << stats.running
+     << " submitted=" << stats.submitted << " completed=" << stats.completed
+     << " avg_wait_us=" << (stats.completed ? stats.waitUs / stats.completed : 0)
+     << " max_wait_us=" << stats.maxWaitUs << "]";
+  return ss.str();
+}
+
+}  // namespace Basic
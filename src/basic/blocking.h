@@ -0,0 +1,69 @@
+/**
+ * 阻塞调用卸载
+ * 协程中调用会阻塞线程的函数(文件操作, getaddrinfo, 大量计算等)时, 挂起当前协程,
+ * 在有界线程池(blocking.threads)中执行, 完成后回到原来的调度线程继续
+ */
+#pragma once
+
+#include <exception>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "basic/task.h"
+
+namespace Basic {
+
+class Blocking {
+public:
+  struct Stats {
+    uint64_t queued    = 0;  // 排队中的任务数
+    uint64_t running   = 0;  // 执行中的任务数
+    uint64_t submitted = 0;  // 累计提交数
+    uint64_t completed = 0;  // 累计完成数
+    uint64_t waitUs    = 0;  // 累计排队时间
+    uint64_t maxWaitUs = 0;  // 最长排队时间
+  };
+
+  /**
+   * @brief 在线程池中执行 fn 并返回其结果, fn 抛出的异常在调用方重新抛出
+   * @details 不在开启hook的调度器协程中时直接在当前线程执行
+   */
+  template <class F>
+  static auto run(F&& fn) -> decltype(fn()) {
+    typedef decltype(fn()) R;
+    static_assert(!std::is_reference<R>::value, "Blocking::run can not return reference");
+    if (!CanSuspend()) { return fn(); }
+
+    std::exception_ptr ex;
+    if constexpr (std::is_void<R>::value) {
+      Execute([&fn, &ex]() {
+        try {
+          fn();
+        } catch (...) { ex = std::current_exception(); }
+      });
+      if (ex) { std::rethrow_exception(ex); }
+    } else {
+      std::optional<R> rt;
+      Execute([&fn, &ex, &rt]() {
+        try {
+          rt.emplace(fn());
+        } catch (...) { ex = std::current_exception(); }
+      });
+      if (ex) { std::rethrow_exception(ex); }
+      return std::move(*rt);
+    }
+  }
+
+  /// 当前线程是否可以挂起协程等待线程池
+  static bool CanSuspend();
+
+  static Stats       GetStats();
+  static std::string ToString();
+
+private:
+  /// 挂起当前协程直到task在线程池中执行完
+  static void Execute(TaskFunc task);
+};
+
+}  // namespace Basic
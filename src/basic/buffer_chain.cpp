@@ -0,0 +1,209 @@
+#include "basic/buffer_chain.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Basic {
+
+BufferChain::BufferChain(size_t base_size) : m_baseSize(base_size) {}
+
+BufferChain::NodePtr BufferChain::newNode() const {
+  return NodePtr(ByteArray::AllocNode(m_baseSize), ByteArray::FreeNode);
+}
+
+size_t BufferChain::tailSpace() const {
+  if (m_slices.empty()) { return 0; }
+  const Slice& back = m_slices.back();
+  // 节点被其他链引用时不能写, 其他链可能引用了尾部之后的数据
+  if (back.node.use_count() != 1) { return 0; }
+  return back.node->size - back.offset - back.size;
+}
+
+void BufferChain::checkWritable(const char* fun) const {
+  // 读取协程挂起期间追加数据会写进已交给 recvmsg 的空间, 或排在之后收到的数据前面
+  if (m_pendingTail.node || !m_pending.empty()) {
+    throw std::logic_error(std::string(fun) + " while getWriteBuffers is not committed");
+  }
+}
+
+void BufferChain::append(const void* buf, size_t size) {
+  checkWritable("BufferChain::append");
+  const char* p = (const char*)buf;
+  m_size += size;
+
+  size_t space = std::min(tailSpace(), size);
+  if (space > 0) {
+    Slice& back = m_slices.back();
+    memcpy(back.node->ptr + back.offset + back.size, p, space);
+    back.size += space;
+    p += space;
+    size -= space;
+  }
+  while (size > 0) {
+    NodePtr node = newNode();
+    size_t  len  = std::min(node->size, size);
+    memcpy(node->ptr, p, len);
+    m_slices.push_back({std::move(node), 0, len});
+    p += len;
+    size -= len;
+  }
+}
+
+void BufferChain::append(const BufferChain& chain) {
+  checkWritable("BufferChain::append");
+  // chain 可能是自身, 先复制段描述
+  std::deque<Slice> slices = chain.m_slices;
+  for (auto& i : slices) {
+    // 同一节点上相邻的段合并
+    if (!m_slices.empty()) {
+      Slice& back = m_slices.back();
+      if (back.node == i.node && back.offset + back.size == i.offset) {
+        back.size += i.size;
+        m_size += i.size;
+        continue;
+      }
+    }
+    m_size += i.size;
+    m_slices.push_back(std::move(i));
+  }
+}
+
+BufferChain BufferChain::slice(size_t offset, size_t size) const {
+  if (offset > m_size || size > m_size - offset) {
+    throw std::out_of_range("BufferChain::slice out of range");
+  }
+  BufferChain chain(m_baseSize);
+  chain.m_size = size;
+  for (auto it = m_slices.begin(); size > 0; ++it) {
+    if (offset >= it->size) {
+      offset -= it->size;
+      continue;
+    }
+    size_t len = std::min(it->size - offset, size);
+    chain.m_slices.push_back({it->node, it->offset + offset, len});
+    offset = 0;
+    size -= len;
+  }
+  return chain;
+}
+
+BufferChain BufferChain::cut(size_t size) {
+  BufferChain chain = slice(0, size);
+  consume(size);
+  return chain;
+}
+
+void BufferChain::consume(size_t size) {
+  if (size > m_size) { throw std::out_of_range("BufferChain::consume out of range"); }
+  m_size -= size;
+  while (size > 0) {
+    Slice& front = m_slices.front();
+    if (front.size > size) {
+      front.offset += size;
+      front.size -= size;
+      break;
+    }
+    size -= front.size;
+    m_slices.pop_front();
+  }
+}
+
+void BufferChain::clear() {
+  m_size = 0;
+  m_slices.clear();
+}
+
+void BufferChain::copyOut(void* buf, size_t size, size_t offset) const {
+  if (offset > m_size || size > m_size - offset) {
+    throw std::out_of_range("BufferChain::copyOut out of range");
+  }
+  char* p = (char*)buf;
+  for (auto it = m_slices.begin(); size > 0; ++it) {
+    if (offset >= it->size) {
+      offset -= it->size;
+      continue;
+    }
+    size_t len = std::min(it->size - offset, size);
+    memcpy(p, it->node->ptr + it->offset + offset, len);
+    p += len;
+    offset = 0;
+    size -= len;
+  }
+}
+
+std::string BufferChain::to_string() const {
+  std::string str;
+  str.resize(m_size);
+  if (!str.empty()) { copyOut(&str[0], str.size()); }
+  return str;
+}
+
+uint64_t BufferChain::getReadBuffers(std::vector<iovec>& buffers, uint64_t len) const {
+  len           = std::min<uint64_t>(len, m_size);
+  uint64_t size = len;
+  for (auto it = m_slices.begin(); len > 0; ++it) {
+    struct iovec iov;
+    iov.iov_base = it->node->ptr + it->offset;
+    iov.iov_len  = std::min<uint64_t>(it->size, len);
+    len -= iov.iov_len;
+    buffers.push_back(iov);
+  }
+  return size;
+}
+
+void BufferChain::clearPending() {
+  m_pending.clear();
+  m_pendingTail = Slice();
+}
+
+uint64_t BufferChain::getWriteBuffers(std::vector<iovec>& buffers, uint64_t len) {
+  checkWritable("BufferChain::getWriteBuffers");
+  uint64_t     size = len;
+  struct iovec iov;
+
+  size_t space = std::min<uint64_t>(tailSpace(), len);
+  if (space > 0) {
+    const Slice& back = m_slices.back();
+    m_pendingTail     = {back.node, back.offset + back.size, space};
+    iov.iov_base      = back.node->ptr + m_pendingTail.offset;
+    iov.iov_len       = space;
+    len -= space;
+    buffers.push_back(iov);
+  }
+  while (len > 0) {
+    NodePtr node = newNode();
+    iov.iov_base = node->ptr;
+    iov.iov_len  = std::min<uint64_t>(node->size, len);
+    len -= iov.iov_len;
+    buffers.push_back(iov);
+    m_pending.push_back(std::move(node));
+  }
+  return size;
+}
+
+void BufferChain::commit(size_t size) {
+  m_size += size;
+  // 按 getWriteBuffers 交出的空间记账, 读取时协程挂起, 期间链尾可能被 slice/cut 改变
+  size_t space = std::min(m_pendingTail.size, size);
+  if (space > 0) {
+    Slice* back = m_slices.empty() ? nullptr : &m_slices.back();
+    if (back && back->node == m_pendingTail.node &&
+        back->offset + back->size == m_pendingTail.offset) {
+      back->size += space;
+    } else {
+      m_slices.push_back({m_pendingTail.node, m_pendingTail.offset, space});
+    }
+    size -= space;
+  }
+  for (auto& i : m_pending) {
+    if (size == 0) { break; }
+    size_t len = std::min(i->size, size);
+    m_slices.push_back({std::move(i), 0, len});
+    size -= len;
+  }
+  clearPending();
+}
+
+}  // namespace Basic
@@ -0,0 +1,85 @@
+/**
+ * 引用计数的缓冲区链
+ * 由 ByteArray::Node 组成, 每一段引用一个节点中的一段数据. slice/append(chain)/cut 只复制
+ * 段描述并增加节点引用计数, 不复制数据, 代理和协议解析可以把收到的数据原样转发到其他 socket.
+ * 节点被多个链共享时只读, 追加数据写入新节点
+ */
+#pragma once
+
+#include <sys/uio.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "basic/bytearray.h"
+
+namespace Basic {
+
+class BufferChain {
+public:
+  typedef std::shared_ptr<BufferChain> ptr;
+
+  /// @param[in] base_size 新节点的大小
+  explicit BufferChain(size_t base_size = 4096);
+
+  size_t getSize() const { return m_size; }
+  bool   empty() const { return m_size == 0; }
+  size_t getBaseSize() const { return m_baseSize; }
+  /// 引用的节点段数
+  size_t getBlockCount() const { return m_slices.size(); }
+
+  /// 复制数据到链尾
+  void append(const void* buf, size_t size);
+  void append(const std::string& value) { append(value.c_str(), value.size()); }
+  /// 共享 chain 的节点追加到链尾, 不复制数据
+  void append(const BufferChain& chain);
+
+  /// [offset, offset + size) 的共享视图, 超出范围时抛出 out_of_range
+  BufferChain slice(size_t offset, size_t size) const;
+  /// 从链头取下 size 字节作为新链返回, 超出范围时抛出 out_of_range
+  BufferChain cut(size_t size);
+  /// 丢弃链头 size 字节
+  void        consume(size_t size);
+  void        clear();
+
+  /// 从 offset 开始复制 size 字节到 buf, 超出范围时抛出 out_of_range
+  void        copyOut(void* buf, size_t size, size_t offset = 0) const;
+  std::string to_string() const;
+
+  /// 链头开始最多 len 字节的 iovec, 用于 writev/sendmsg
+  uint64_t getReadBuffers(std::vector<iovec>& buffers, uint64_t len = ~0ull) const;
+  /**
+   * @brief 链尾 len 字节的可写空间, 用于 readv/recvmsg, 写入后用 commit 提交
+   * @details 一个链同时只有一个写入方, commit 之前 append/getWriteBuffers 抛出 logic_error,
+   *          期间可以 slice/cut/consume/clear 已有的数据
+   */
+  uint64_t getWriteBuffers(std::vector<iovec>& buffers, uint64_t len);
+  /// 提交 getWriteBuffers 之后写入的 size 字节
+  void     commit(size_t size);
+
+private:
+  typedef std::shared_ptr<ByteArray::Node> NodePtr;
+
+  struct Slice {
+    NodePtr node;
+    size_t  offset = 0;
+    size_t  size   = 0;
+  };
+
+  NodePtr newNode() const;
+  /// 链尾节点只被当前链引用时返回其后剩余的空间
+  size_t  tailSpace() const;
+  void    clearPending();
+  void    checkWritable(const char* fun) const;
+
+private:
+  size_t               m_baseSize;
+  size_t               m_size = 0;
+  std::deque<Slice>    m_slices;
+  std::vector<NodePtr> m_pending;      // getWriteBuffers 分配还未提交的节点
+  Slice                m_pendingTail;  // getWriteBuffers 交出的链尾节点空间
+};
+
+}  // namespace Basic
@@ -1,12 +1,20 @@
 #include "basic/bytearray.h"
 
-#include <math.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
+#include <map>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 
+#include "basic/config.h"
 #include "basic/endian.h"
 #include "basic/log.h"
 
@@ -28,6 +36,98 @@ static int32_t DecodeZigzag32(const uint32_t& v) {
   return (v >> 1) ^ -(int32_t)(v & 1);
 }
 
+// varint 编码到 p, 返回长度
+template <class T>
+static inline size_t EncodeVarint(T value, uint8_t* p) {
+  size_t i = 0;
+  while (value >= 0x80) {
+    p[i++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  p[i++] = value;
+  return i;
+}
+
+/**
+ * 从 p 解码一个 uint32 varint, p 之后至少有8字节可读
+ * 一次读入8字节, 由第一个最高位为0的字节得到长度(最多5字节), 再分三步把各字节的低7位拼起来,
+ * 没有逐字节的分支
+ */
+static inline uint32_t DecodeVarint32(const uint8_t* p, size_t& len) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  v = byteswapOnBigEndian(v);
+
+  uint64_t stop = (~v & 0x8080808080808080ull) | 0x8000000000ull;
+  len           = (__builtin_ctzll(stop) >> 3) + 1;
+  v &= ((1ull << (len << 3)) - 1) & 0x7f7f7f7f7f7f7f7full;
+  v = ((v & 0x7f007f007f007f00ull) >> 1) | (v & 0x007f007f007f007full);
+  v = ((v & 0x3fff00003fff0000ull) >> 2) | (v & 0x00003fff00003fffull);
+  v = ((v & 0x0fffffff00000000ull) >> 4) | (v & 0x000000000fffffffull);
+  return (uint32_t)v;
+}
+
+static ConfigVar<uint64_t>::ptr g_node_cache_size =
+    Config::Lookup("bytearray.node_cache_size", (uint64_t)(4 * 1024 * 1024),
+                   "每个线程缓存的空闲ByteArray节点总大小");
+
+struct NodeCache;
+static thread_local NodeCache* t_node_cache        = nullptr;
+static thread_local bool       t_node_cache_exited = false;
+
+/**
+ * 线程内空闲节点缓存, 按节点大小分组
+ * clear/析构释放的节点放回缓存, 扩容时优先复用, 长期使用的连接缓冲区不再反复申请内存
+ */
+struct NodeCache {
+  std::map<size_t, std::vector<ByteArray::Node*>> nodes;
+  uint64_t                                        bytes = 0;
+
+  ~NodeCache() {
+    for (auto& i : nodes) {
+      for (auto n : i.second) {
+        delete n;
+      }
+    }
+    // 线程退出后释放的节点直接 delete
+    t_node_cache        = nullptr;
+    t_node_cache_exited = true;
+  }
+};
+
+static NodeCache* GetNodeCache() {
+  if (!t_node_cache && !t_node_cache_exited) {
+    static thread_local NodeCache cache;
+    t_node_cache = &cache;
+  }
+  return t_node_cache;
+}
+
+ByteArray::Node* ByteArray::AllocNode(size_t size) {
+  NodeCache* cache = t_node_cache;
+  if (cache) {
+    auto it = cache->nodes.find(size);
+    if (it != cache->nodes.end() && !it->second.empty()) {
+      ByteArray::Node* node = it->second.back();
+      it->second.pop_back();
+      cache->bytes -= size;
+      return node;
+    }
+  }
+  return new ByteArray::Node(size);
+}
+
+void ByteArray::FreeNode(Node* node) {
+  node->next       = nullptr;
+  NodeCache* cache = GetNodeCache();
+  if (!cache || cache->bytes + node->size > g_node_cache_size->getValue()) {
+    delete node;
+    return;
+  }
+  cache->nodes[node->size].push_back(node);
+  cache->bytes += node->size;
+}
+
 ByteArray::Node::Node(size_t s) : ptr(new char[s]), next(nullptr), size(s) {}
 
 ByteArray::Node::Node() : ptr(nullptr), next(nullptr), size(0) {}
@@ -42,15 +142,89 @@ ByteArray::ByteArray(size_t base_size)
       m_capacity(base_size),
       m_size(0),
       m_endian(BASIC_BIG_ENDIAN),
-      m_root(new Node(base_size)),
-      m_cur(m_root) {}
+      m_root(AllocNode(base_size)),
+      m_cur(m_root),
+      m_tail(m_root),
+      m_mapped(false),
+      m_readonly(false),
+      m_fd(-1) {}
+
+ByteArray::ptr ByteArray::MapFile(const std::string& name, bool writable, bool populate,
+                                  bool sequential) {
+  int fd = open(name.c_str(), writable ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    LOG_ERROR_STREAM << "MapFile open name=" << name << " error, errno=" << errno
+                     << " errstr=" << strerror(errno);
+    return nullptr;
+  }
+  struct stat st;
+  size_t      size = 0;
+  size_t      len  = 0;
+  void*       addr = MAP_FAILED;
+  if (fstat(fd, &st) == 0) {
+    size = st.st_size;
+    len  = size;
+    if (writable) {
+      // 预留一些空间, 之后按倍数扩大
+      size_t page = sysconf(_SC_PAGESIZE);
+      len         = std::max((size + page - 1) / page * page, page * 16);
+    }
+    // 空文件只读映射一个字节, 不会被访问
+    len = std::max<size_t>(len, 1);
+    if (!writable || ftruncate(fd, len) == 0) {
+      addr = mmap(nullptr, len, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                  MAP_SHARED | (populate ? MAP_POPULATE : 0), fd, 0);
+    }
+  }
+  if (addr == MAP_FAILED) {
+    LOG_ERROR_STREAM << "MapFile name=" << name << " error, errno=" << errno
+                     << " errstr=" << strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+  if (sequential) { madvise(addr, len, MADV_SEQUENTIAL); }
+
+  ByteArray::ptr ba(new ByteArray(1));
+  FreeNode(ba->m_root);
+  Node* node     = new Node();
+  node->ptr      = (char*)addr;
+  node->size     = len;
+  ba->m_root     = node;
+  ba->m_cur      = node;
+  ba->m_tail     = node;
+  ba->m_baseSize = len;
+  ba->m_capacity = writable ? len : size;
+  ba->m_size     = size;
+  ba->m_mapped   = true;
+  ba->m_readonly = !writable;
+  if (writable) {
+    ba->m_fd = fd;
+  } else {
+    close(fd);
+  }
+  return ba;
+}
 
 ByteArray::~ByteArray() {
+  if (m_mapped) {
+    munmap(m_root->ptr, m_root->size);
+    m_root->ptr = nullptr;
+    delete m_root;
+    if (m_fd >= 0) {
+      // 去掉扩容时多出的部分
+      if (ftruncate(m_fd, m_size)) {
+        LOG_ERROR_STREAM << "ByteArray ftruncate fd=" << m_fd << " error, errno=" << errno
+                         << " errstr=" << strerror(errno);
+      }
+      close(m_fd);
+    }
+    return;
+  }
   Node* tmp = m_root;
   while (tmp) {
     m_cur = tmp;
     tmp   = tmp->next;
-    delete m_cur;
+    FreeNode(m_cur);
   }
 }
 
@@ -66,41 +240,49 @@ void ByteArray::setIsLittleEndian(bool val) {
   }
 }
 
+template <class T>
+void ByteArray::writeFixed(T value) {
+  if constexpr (sizeof(T) > 1) {
+    if (m_endian != BASIC_BYTE_ORDER) { value = byteswap(value); }
+  }
+  if (char* p = writePtr(sizeof(value))) {
+    memcpy(p, &value, sizeof(value));
+    forward(p, sizeof(value));
+  } else {
+    write(&value, sizeof(value));
+  }
+}
+
 void ByteArray::writeFint8(int8_t value) {
-  write(&value, sizeof(value));
+  writeFixed(value);
 }
 
 void ByteArray::writeFuint8(uint8_t value) {
-  write(&value, sizeof(value));
+  writeFixed(value);
 }
 
 void ByteArray::writeFint16(int16_t value) {
-  if (m_endian != BASIC_BYTE_ORDER) { value = byteswap(value); }
-  write(&value, sizeof(value));
+  writeFixed(value);
 }
 
 void ByteArray::writeFuint16(uint16_t value) {
-  if (m_endian != BASIC_BYTE_ORDER) { value = byteswap(value); }
-  write(&value, sizeof(value));
+  writeFixed(value);
 }
+
 void ByteArray::writeFint32(int32_t value) {
-  if (m_endian != BASIC_BYTE_ORDER) { value = byteswap(value); }
-  write(&value, sizeof(value));
+  writeFixed(value);
 }
 
 void ByteArray::writeFuint32(uint32_t value) {
-  if (m_endian != BASIC_BYTE_ORDER) { value = byteswap(value); }
-  write(&value, sizeof(value));
+  writeFixed(value);
 }
 
 void ByteArray::writeFint64(int64_t value) {
-  if (m_endian != BASIC_BYTE_ORDER) { value = byteswap(value); }
-  write(&value, sizeof(value));
+  writeFixed(value);
 }
 
 void ByteArray::writeFuint64(uint64_t value) {
-  if (m_endian != BASIC_BYTE_ORDER) { value = byteswap(value); }
-  write(&value, sizeof(value));
+  writeFixed(value);
 }
 
 void ByteArray::writeInt32(int32_t value) {
@@ -108,14 +290,12 @@ void ByteArray::writeInt32(int32_t value) {
 }
 
 void ByteArray::writeUint32(uint32_t value) {
-  uint8_t tmp[5];
-  uint8_t i = 0;
-  while (value >= 0x80) {
-    tmp[i++] = (value & 0x7F) | 0x80;
-    value >>= 7;
+  if (char* p = writePtr(5)) {
+    forward(p, EncodeVarint(value, (uint8_t*)p));
+    return;
   }
-  tmp[i++] = value;
-  write(tmp, i);
+  uint8_t tmp[5];
+  write(tmp, EncodeVarint(value, tmp));
 }
 
 void ByteArray::writeInt64(int64_t value) {
@@ -123,14 +303,12 @@ void ByteArray::writeInt64(int64_t value) {
 }
 
 void ByteArray::writeUint64(uint64_t value) {
-  uint8_t tmp[10];
-  uint8_t i = 0;
-  while (value >= 0x80) {
-    tmp[i++] = (value & 0x7F) | 0x80;
-    value >>= 7;
+  if (char* p = writePtr(10)) {
+    forward(p, EncodeVarint(value, (uint8_t*)p));
+    return;
   }
-  tmp[i++] = value;
-  write(tmp, i);
+  uint8_t tmp[10];
+  write(tmp, EncodeVarint(value, tmp));
 }
 
 void ByteArray::writeFloat(float value) {
@@ -169,57 +347,83 @@ void ByteArray::writeStringWithoutLength(const std::string& value) {
   write(value.c_str(), value.size());
 }
 
-int8_t ByteArray::readFint8() {
-  int8_t v;
-  read(&v, sizeof(v));
-  return v;
+void ByteArray::writeUint32Array(const uint32_t* values, size_t count) {
+  size_t i = 0;
+  while (i < count) {
+    char* p = writePtr(5);
+    if (!p) {
+      // 跨节点的一个按原来的方式写
+      writeUint32(values[i++]);
+      continue;
+    }
+    // 当前节点剩余空间内连续编码, 最后统一移动位置
+    uint8_t*       cur = (uint8_t*)p;
+    const uint8_t* end = (const uint8_t*)m_cur->ptr + m_cur->size - 5;
+    while (i < count && cur <= end) {
+      cur += EncodeVarint(values[i++], cur);
+    }
+    forward(p, cur - (uint8_t*)p);
+  }
 }
 
-uint8_t ByteArray::readFuint8() {
-  uint8_t v;
-  read(&v, sizeof(v));
+template <class T>
+T ByteArray::readFixed() {
+  T v;
+  if (const char* p = readPtr(sizeof(v))) {
+    memcpy(&v, p, sizeof(v));
+    forward(p, sizeof(v));
+  } else {
+    read(&v, sizeof(v));
+  }
+  if constexpr (sizeof(T) > 1) {
+    if (m_endian != BASIC_BYTE_ORDER) { v = byteswap(v); }
+  }
   return v;
 }
 
-#define XX(type)                      \
-  type v;                             \
-  read(&v, sizeof(v));                \
-  if (m_endian == BASIC_BYTE_ORDER) { \
-    return v;                         \
-  } else {                            \
-    return byteswap(v);               \
-  }
+int8_t ByteArray::readFint8() {
+  return readFixed<int8_t>();
+}
+
+uint8_t ByteArray::readFuint8() {
+  return readFixed<uint8_t>();
+}
 
 int16_t ByteArray::readFint16() {
-  XX(int16_t);
+  return readFixed<int16_t>();
 }
+
 uint16_t ByteArray::readFuint16() {
-  XX(uint16_t);
+  return readFixed<uint16_t>();
 }
 
 int32_t ByteArray::readFint32() {
-  XX(int32_t);
+  return readFixed<int32_t>();
 }
 
 uint32_t ByteArray::readFuint32() {
-  XX(uint32_t);
+  return readFixed<uint32_t>();
 }
 
 int64_t ByteArray::readFint64() {
-  XX(int64_t);
+  return readFixed<int64_t>();
 }
 
 uint64_t ByteArray::readFuint64() {
-  XX(uint64_t);
+  return readFixed<uint64_t>();
 }
 
-#undef XX
-
 int32_t ByteArray::readInt32() {
   return DecodeZigzag32(readUint32());
 }
 
 uint32_t ByteArray::readUint32() {
+  if (const char* p = readPtr(8)) {
+    size_t   len;
+    uint32_t v = DecodeVarint32((const uint8_t*)p, len);
+    forward(p, len);
+    return v;
+  }
   uint32_t result = 0;
   for (int i = 0; i < 32; i += 7) {
     uint8_t b = readFuint8();
@@ -238,6 +442,17 @@ int64_t ByteArray::readInt64() {
 }
 
 uint64_t ByteArray::readUint64() {
+  if (const char* p = readPtr(10)) {
+    const uint8_t* cur    = (const uint8_t*)p;
+    uint64_t       result = 0;
+    for (int i = 0; i < 64; i += 7) {
+      uint8_t b = *cur++;
+      result |= ((uint64_t)(b & 0x7f)) << i;
+      if (b < 0x80) { break; }
+    }
+    forward(p, cur - (const uint8_t*)p);
+    return result;
+  }
   uint64_t result = 0;
   for (int i = 0; i < 64; i += 7) {
     uint8_t b = readFuint8();
@@ -297,6 +512,28 @@ std::string ByteArray::readStringVint() {
   return buff;
 }
 
+void ByteArray::readUint32Array(uint32_t* values, size_t count) {
+  size_t i = 0;
+  while (i < count) {
+    const char* p = readPtr(8);
+    if (!p) {
+      // 节点末尾或数据末尾不足8字节, 逐字节读
+      values[i++] = readUint32();
+      continue;
+    }
+    // 能一次读入8字节的范围内批量解码
+    size_t         avail = std::min<size_t>(m_cur->ptr + m_cur->size - p, m_size - m_position);
+    const uint8_t* cur   = (const uint8_t*)p;
+    const uint8_t* end   = cur + avail - 8;
+    while (i < count && cur <= end) {
+      size_t len;
+      values[i++] = DecodeVarint32(cur, len);
+      cur += len;
+    }
+    forward(p, cur - (const uint8_t*)p);
+  }
+}
+
 void ByteArray::clear() {
   m_position = m_size = 0;
 
@@ -306,14 +543,20 @@ void ByteArray::clear() {
   while (tmp) {
     m_cur = tmp;
     tmp   = tmp->next;
-    delete m_cur;
+    FreeNode(m_cur);
   }
   m_cur        = m_root;
+  m_tail       = m_root;
   m_root->next = NULL;
 }
 
+void ByteArray::reserve(size_t size) {
+  addCapacity(size);
+}
+
 void ByteArray::write(const void* buf, size_t size) {
   if (size == 0) { return; }
+  if (m_readonly) { throw std::logic_error("write to read-only mapped ByteArray"); }
   addCapacity(size);
 
   size_t npos = m_position % m_baseSize;
@@ -408,6 +651,16 @@ void ByteArray::setPosition(size_t v) {
   if (v == m_cur->size) { m_cur = m_cur->next; }
 }
 
+bool ByteArray::sync() {
+  if (!m_mapped || m_readonly) { return true; }
+  if (msync(m_root->ptr, m_root->size, MS_SYNC)) {
+    LOG_ERROR_STREAM << "ByteArray msync fd=" << m_fd << " error, errno=" << errno
+                     << " errstr=" << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
 bool ByteArray::writeToFile(const std::string& name) const {
   std::ofstream ofs;
   ofs.open(name, std::ios::trunc | std::ios::binary);
@@ -455,18 +708,36 @@ void ByteArray::addCapacity(size_t size) {
   size_t old_cap = getCapacity();
   if (old_cap >= size) { return; }
 
-  size         = size - old_cap;
-  size_t count = ceil(1.0 * size / m_baseSize);
-  Node*  tmp   = m_root;
-  while (tmp->next) {
-    tmp = tmp->next;
+  if (m_mapped) {
+    // 只有一个节点, 扩大文件后重新映射
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t cap  = std::max(m_capacity * 2, m_position + size);
+    cap         = (cap + page - 1) / page * page;
+    void* addr  = MAP_FAILED;
+    if (ftruncate(m_fd, cap) == 0) {
+      addr = mremap(m_root->ptr, m_root->size, cap, MREMAP_MAYMOVE);
+    }
+    if (addr == MAP_FAILED) {
+      LOG_ERROR_STREAM << "ByteArray remap fd=" << m_fd << " size=" << cap
+                       << " error, errno=" << errno << " errstr=" << strerror(errno);
+      throw std::bad_alloc();
+    }
+    m_root->ptr  = (char*)addr;
+    m_root->size = cap;
+    m_baseSize   = cap;
+    m_capacity   = cap;
+    m_cur        = m_root;
+    return;
   }
 
+  size         = size - old_cap;
+  size_t count = (size + m_baseSize - 1) / m_baseSize;
+
   Node* first = NULL;
   for (size_t i = 0; i < count; ++i) {
-    tmp->next = new Node(m_baseSize);
-    if (first == NULL) { first = tmp->next; }
-    tmp = tmp->next;
+    m_tail->next = AllocNode(m_baseSize);
+    if (first == NULL) { first = m_tail->next; }
+    m_tail = m_tail->next;
     m_capacity += m_baseSize;
   }
 
@@ -559,6 +830,7 @@ uint64_t ByteArray::getReadBuffers(std::vector<iovec>& buffers, uint64_t len,
 
 uint64_t ByteArray::getWriteBuffers(std::vector<iovec>& buffers, uint64_t len) {
   if (len == 0) { return 0; }
+  if (m_readonly) { throw std::logic_error("write to read-only mapped ByteArray"); }
   addCapacity(len);
   uint64_t size = len;
 
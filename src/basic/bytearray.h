@@ -24,6 +24,23 @@ public:
     size_t size;
   };
 
+  // 从线程缓存申请/归还节点
+  static Node* AllocNode(size_t size);
+  static void  FreeNode(Node* node);
+
+  /**
+   * @brief 用 mmap 映射文件, 读写和 position 接口不变, 数据不复制到堆上的节点
+   * @param[in] name 文件名
+   * @param[in] writable false 只读映射, 写入抛出 logic_error;
+   *                     true 以 MAP_SHARED 映射(文件不存在时创建), 写入直接修改文件, 空间不足时
+   *                     扩大文件重新映射, 析构时文件截断到 getSize()
+   * @param[in] populate 使用 MAP_POPULATE 预先读入页面
+   * @param[in] sequential madvise(MADV_SEQUENTIAL), 顺序解析大文件时加大预读
+   * @return 失败返回nullptr
+   */
+  static ptr MapFile(const std::string& name, bool writable = false, bool populate = false,
+                     bool sequential = true);
+
   ByteArray(size_t base_size = 4096);
   ~ByteArray();
 
@@ -54,6 +71,8 @@ public:
   void writeStringVint(const std::string& value);
   // data
   void writeStringWithoutLength(const std::string& value);
+  // 批量写入 varint 编码的 uint32, 与逐个 writeUint32 的结果相同
+  void writeUint32Array(const uint32_t* values, size_t count);
 
   // read
   int8_t   readFint8();
@@ -81,9 +100,14 @@ public:
   std::string readStringF64();
   // length:varint , data
   std::string readStringVint();
+  // 批量读取 writeUint32Array/writeUint32 写入的 uint32, 数据不足时抛出 out_of_range
+  void        readUint32Array(uint32_t* values, size_t count);
 
   // 内部操作
+  // 清空数据, 除第一个以外的节点放回线程缓存
   void clear();
+  // 预留 size 字节的写入空间, 不修改position
+  void reserve(size_t size);
 
   void write(const void* buf, size_t size);
   void read(void* buf, size_t size);
@@ -112,10 +136,36 @@ public:
 
   size_t getSize() const { return m_size; }
 
+  bool isMapped() const { return m_mapped; }
+  // 映射的文件写回磁盘
+  bool sync();
+
 private:
   void   addCapacity(size_t size);
   size_t getCapacity() const { return m_capacity - m_position; }
 
+  template <class T>
+  void writeFixed(T value);
+  template <class T>
+  T readFixed();
+
+  // 当前节点内有 size 字节连续空间时返回其位置, 否则返回nullptr
+  char* nodePtr(size_t size) const {
+    if (!m_cur) { return nullptr; }
+    size_t npos = m_position % m_baseSize;
+    return m_cur->size - npos >= size ? m_cur->ptr + npos : nullptr;
+  }
+  char*       writePtr(size_t size) const { return m_readonly ? nullptr : nodePtr(size); }
+  const char* readPtr(size_t size) const {
+    return m_size - m_position >= size ? nodePtr(size) : nullptr;
+  }
+  // 直接读写当前节点 p 开始的 size 字节后移动位置
+  void forward(const char* p, size_t size) {
+    m_position += size;
+    if (p + size == m_cur->ptr + m_cur->size) { m_cur = m_cur->next; }
+    if (m_position > m_size) { m_size = m_position; }
+  }
+
 private:
   size_t m_baseSize;
   size_t m_position;
@@ -124,6 +174,11 @@ private:
   int8_t m_endian;
   Node*  m_root;
   Node*  m_cur;
+  Node*  m_tail;
+  // mmap 模式只有一个节点, 指向整个映射
+  bool   m_mapped;
+  bool   m_readonly;
+  int    m_fd;
 };
 
 }  // namespace Basic
\ No newline at end of file
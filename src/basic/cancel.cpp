@@ -0,0 +1,137 @@
+#include "basic/cancel.h"
+
+#include <errno.h>
+
+#include <algorithm>
+
+#include "basic/fiber_local.h"
+#include "basic/utils.h"
+
+namespace Basic {
+
+static FiberLocal<CancelToken::ptr> s_token;
+
+void CancelToken::Waiter::resume() {
+  if (!resumed.exchange(true)) { iom->schedule(std::move(fiber)); }
+}
+
+CancelToken::ptr CancelToken::Create(uint64_t timeout_ms, ptr parent) {
+  uint64_t deadline = timeout_ms == (uint64_t)-1 ? (uint64_t)-1 : get_current_ms() + timeout_ms;
+  if (parent) { deadline = std::min(deadline, parent->m_deadline); }
+  ptr token(new CancelToken(deadline));
+  if (parent) {
+    LockType::Lock lock(parent->m_mutex);
+    token->m_error = parent->m_error.load();
+    auto& children = parent->m_children;
+    children.erase(std::remove_if(children.begin(), children.end(),
+                                  [](const std::weak_ptr<CancelToken>& i) { return i.expired(); }),
+                   children.end());
+    children.push_back(token);
+  }
+  return token;
+}
+
+CancelToken::ptr CancelToken::GetThis() {
+  // 避免为没有令牌的协程分配槽位存储
+  return s_token.has() ? *s_token : nullptr;
+}
+
+void CancelToken::SetThis(ptr token) {
+  if (token) {
+    *s_token = std::move(token);
+  } else {
+    s_token.reset();
+  }
+}
+
+uint64_t CancelToken::Remaining() {
+  if (!s_token.has() || !*s_token) { return -1; }
+  return (*s_token)->getRemaining();
+}
+
+int CancelToken::Check() {
+  if (!s_token.has() || !*s_token) { return 0; }
+  return (*s_token)->getError();
+}
+
+CancelToken::CancelToken(uint64_t deadline) : m_deadline(deadline) {}
+
+CancelToken::~CancelToken() {
+  if (m_timer) { m_timer->cancel(); }
+}
+
+uint64_t CancelToken::getRemaining() const {
+  if (m_error) { return 0; }
+  if (m_deadline == (uint64_t)-1) { return -1; }
+  uint64_t now = get_current_ms();
+  return m_deadline > now ? m_deadline - now : 0;
+}
+
+int CancelToken::getError() const {
+  int error = m_error;
+  if (error) { return error; }
+  if (m_deadline != (uint64_t)-1 && get_current_ms() >= m_deadline) { return ETIMEDOUT; }
+  return 0;
+}
+
+void CancelToken::cancel(int error) {
+  std::vector<std::weak_ptr<CancelToken>> children;
+  {
+    LockType::Lock lock(m_mutex);
+    int            expected = 0;
+    if (!m_error.compare_exchange_strong(expected, error)) { return; }
+    // 持有锁唤醒, 等待者在 delWaiter 之前不会离开等待, fd 不会被复用
+    for (auto w : m_waiters) {
+      if (w->fd == -1) {
+        w->resume();
+      } else {
+        w->iom->cancelEvent(w->fd, w->event);
+      }
+    }
+    children.swap(m_children);
+    if (m_timer) {
+      m_timer->cancel();
+      m_timer.reset();
+    }
+  }
+  for (auto& i : children) {
+    if (auto child = i.lock()) { child->cancel(error); }
+  }
+}
+
+bool CancelToken::addWaiter(Waiter* waiter) {
+  LockType::Lock lock(m_mutex);
+  if (getError()) { return false; }
+  // 定时器在第一次挂起时创建, 之后所有挂起共用
+  if (m_deadline != (uint64_t)-1 && !m_timer) {
+    std::weak_ptr<CancelToken> weak(shared_from_this());
+    m_timer = waiter->iom->addConditionTimer(
+        getRemaining(),
+        [weak]() {
+          if (auto token = weak.lock()) { token->cancel(ETIMEDOUT); }
+        },
+        weak);
+  }
+  m_waiters.push_back(waiter);
+  return true;
+}
+
+void CancelToken::delWaiter(Waiter* waiter) {
+  LockType::Lock lock(m_mutex);
+  auto           it = std::find(m_waiters.begin(), m_waiters.end(), waiter);
+  if (it != m_waiters.end()) { m_waiters.erase(it); }
+}
+
+CancelScope::CancelScope(uint64_t timeout_ms)
+    : CancelScope(CancelToken::Create(timeout_ms, CancelToken::GetThis())) {}
+
+CancelScope::CancelScope(CancelToken::ptr token)
+    : m_token(std::move(token)), m_prev(CancelToken::GetThis()) {
+  CancelToken::SetThis(m_token);
+}
+
+CancelScope::~CancelScope() {
+  CancelToken::SetThis(std::move(m_prev));
+}
+
+}  // namespace Basic
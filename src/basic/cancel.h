@@ -0,0 +1,96 @@
+/**
+ * 协程截止时间与取消
+ * hook 的阻塞调用(read/write/connect/accept/sleep 等)除了 fd 上的 SO_RCVTIMEO/SO_SNDTIMEO 外,
+ * 还受当前协程的 CancelToken 约束: 截止时间到达或被取消时挂起的调用立即返回 -1,
+ * errno 为 ETIMEDOUT 或 ECANCELED. 每个令牌只在第一次挂起时创建一个定时器
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "basic/iomanager.h"
+#include "basic/mutex.h"
+#include "basic/noncopyable.h"
+
+namespace Basic {
+
+class CancelToken : public std::enable_shared_from_this<CancelToken>, NonCopyable {
+public:
+  typedef std::shared_ptr<CancelToken> ptr;
+  typedef Mutex                        LockType;
+
+  /// 挂起在 hook 调用中的协程
+  struct Waiter {
+    IOManager*        iom   = nullptr;
+    int               fd    = -1;  // 等待fd事件时取消事件, -1 表示 sleep
+    IOManager::Event  event = IOManager::NONE;
+    Fiber::ptr        fiber;  // sleep 时直接恢复, 与定时器竞争 resumed
+    std::atomic<bool> resumed{false};
+
+    void resume();
+  };
+
+  /**
+   * @brief 创建令牌
+   * @param[in] timeout_ms 超时时间, -1 表示没有
+   * @param[in] parent 父令牌取消时一起取消, 截止时间不晚于父令牌
+   */
+  static ptr Create(uint64_t timeout_ms = -1, ptr parent = GetThis());
+
+  /// 当前协程的令牌, 没有时返回nullptr
+  static ptr  GetThis();
+  static void SetThis(ptr token);
+
+  /// 当前协程剩余时间(ms), 没有截止时间返回 -1, 已取消返回0
+  static uint64_t Remaining();
+  /// 当前协程已取消时返回错误码(ETIMEDOUT/ECANCELED), 否则返回0
+  static int      Check();
+
+  ~CancelToken();
+
+  uint64_t getDeadline() const { return m_deadline; }
+  uint64_t getRemaining() const;
+  /// 截止时间已到但定时器还没触发时也返回 ETIMEDOUT
+  int      getError() const;
+  bool     isCancelled() const { return getError() != 0; }
+
+  /// 取消令牌及其子令牌, 唤醒挂起的协程
+  void cancel(int error = ECANCELED);
+
+  /// hook 挂起前登记, 已经取消时返回false
+  bool addWaiter(Waiter* waiter);
+  void delWaiter(Waiter* waiter);
+
+private:
+  explicit CancelToken(uint64_t deadline);
+
+private:
+  LockType                                m_mutex;
+  std::atomic<int>                        m_error = {0};
+  uint64_t                                m_deadline;
+  Timer::ptr                              m_timer;
+  std::vector<Waiter*>                    m_waiters;
+  std::vector<std::weak_ptr<CancelToken>> m_children;
+};
+
+/**
+ * @brief 在作用域内为当前协程设置令牌, 析构时恢复之前的令牌
+ */
+class CancelScope : NonCopyable {
+public:
+  /// 当前协程需要在 timeout_ms 内完成, 与已有的截止时间取较早者
+  explicit CancelScope(uint64_t timeout_ms);
+  /// 使用已有令牌, 例如在新协程中继承调用方的截止时间
+  explicit CancelScope(CancelToken::ptr token);
+  ~CancelScope();
+
+  const CancelToken::ptr& getToken() const { return m_token; }
+
+private:
+  CancelToken::ptr m_token;
+  CancelToken::ptr m_prev;
+};
+
+}  // namespace Basic
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "basic/fiber_sync.h"
+#include "basic/noncopyable.h"
+
+namespace Basic {
+
+/**
+ * @brief 协程间的有界通道, 类似 Go 的 chan
+ * @details 数据存放在无锁有界环形队列中(容量向上取整为2的幂), 队列满时 send 挂起协程,
+ *          队列空时 recv 挂起协程; 不在调度器中时阻塞线程.
+ *          close 之后 send 返回false, recv 取完剩余数据后返回false.
+ *          close 与 send 并发时可能有数据留在通道中, 应由发送方在最后一次 send 之后 close
+ */
+template <class T>
+class Channel : NonCopyable {
+public:
+  typedef std::shared_ptr<Channel> ptr;
+
+  Channel(size_t capacity = 1) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    m_mask = size - 1;
+    m_cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief 发送, 队列满时挂起等待
+   * @return 通道已关闭返回false
+   */
+  template <class U>
+  bool send(U&& v) {
+    while (true) {
+      if (m_closed) { return false; }
+      if (push(std::forward<U>(v))) {
+        notifyRecv();
+        return true;
+      }
+
+      SpinLock::Lock lock(m_sendQueue.getMutex());
+      // 先登记再重试, 与 notifySend 的先出队再检查等待者配合, 不会丢失唤醒
+      ++m_sendWaiting;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (m_closed) {
+        --m_sendWaiting;
+        return false;
+      }
+      if (push(std::forward<U>(v))) {
+        --m_sendWaiting;
+        lock.unlock();
+        notifyRecv();
+        return true;
+      }
+      m_sendQueue.wait(lock);
+      --m_sendWaiting;
+    }
+  }
+
+  /**
+   * @brief 接收, 队列空时挂起等待
+   * @return 通道已关闭且没有剩余数据返回false
+   */
+  bool recv(T& out) {
+    while (true) {
+      if (tryRecv(out)) { return true; }
+
+      SpinLock::Lock lock(m_recvQueue.getMutex());
+      ++m_recvWaiting;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      bool closed = m_closed;
+      if (pop(out)) {
+        --m_recvWaiting;
+        lock.unlock();
+        notifySend();
+        return true;
+      }
+      if (closed) {
+        --m_recvWaiting;
+        return false;
+      }
+      m_recvQueue.wait(lock);
+      --m_recvWaiting;
+    }
+  }
+
+  template <class U>
+  bool trySend(U&& v) {
+    if (m_closed || !push(std::forward<U>(v))) { return false; }
+    notifyRecv();
+    return true;
+  }
+
+  bool tryRecv(T& out) {
+    if (!pop(out)) { return false; }
+    notifySend();
+    return true;
+  }
+
+  /// 关闭通道, 唤醒所有等待的发送方和接收方
+  void close() {
+    m_closed = true;
+    wakeAll(m_sendQueue);
+    wakeAll(m_recvQueue);
+    for (auto& i : getSelectors()) {
+      i->notify();
+    }
+  }
+
+  bool   isClosed() const { return m_closed; }
+  size_t getCapacity() const { return m_mask + 1; }
+  size_t getSize() const {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+  }
+
+  /**
+   * @brief 从多个通道中接收一个数据, 都没有数据时挂起直到任一通道可读
+   * @return 收到数据的通道下标, 全部通道关闭且没有剩余数据时返回-1
+   */
+  static int Select(const std::vector<ptr>& chans, T& out) {
+    static thread_local size_t s_start = 0;
+    size_t                     start   = s_start++;
+
+    std::shared_ptr<FiberSemaphore> sem;
+    int                             rt = -1;
+    while (true) {
+      size_t closed = 0;
+      for (size_t n = 0; n < chans.size(); ++n) {
+        size_t i        = (start + n) % chans.size();
+        bool   is_close = chans[i]->m_closed;
+        if (chans[i]->tryRecv(out)) {
+          rt = i;
+          break;
+        }
+        if (is_close) { ++closed; }
+      }
+      if (rt >= 0 || closed == chans.size()) { break; }
+      if (!sem) {
+        // 登记后再检查一次, 登记之前到达的数据不会唤醒sem
+        sem.reset(new FiberSemaphore);
+        for (auto& i : chans) {
+          i->addSelector(sem);
+        }
+        continue;
+      }
+      sem->wait();
+    }
+    if (sem) {
+      for (auto& i : chans) {
+        i->delSelector(sem);
+      }
+    }
+    return rt;
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T                   data;
+  };
+
+  // Vyukov 有界 MPMC 队列
+  template <class U>
+  bool push(U&& v) {
+    size_t pos = m_head.load(std::memory_order_relaxed);
+    while (true) {
+      Cell&    cell = m_cells[pos & m_mask];
+      size_t   seq  = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.data = std::forward<U>(v);
+          cell.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool pop(T& out) {
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    while (true) {
+      Cell&    cell = m_cells[pos & m_mask];
+      size_t   seq  = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          out = std::move(cell.data);
+          cell.seq.store(pos + m_mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void notifyRecv() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_recvWaiting == 0 && m_selectWaiting == 0) { return; }
+
+    FiberWaitQueue::Waiter::ptr waiter;
+    std::vector<std::shared_ptr<FiberSemaphore>> selectors;
+    {
+      SpinLock::Lock lock(m_recvQueue.getMutex());
+      waiter    = m_recvQueue.pop();
+      selectors = m_selectors;
+    }
+    if (waiter) { waiter->notify(); }
+    for (auto& i : selectors) {
+      i->notify();
+    }
+  }
+
+  void notifySend() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sendWaiting == 0) { return; }
+
+    FiberWaitQueue::Waiter::ptr waiter;
+    {
+      SpinLock::Lock lock(m_sendQueue.getMutex());
+      waiter = m_sendQueue.pop();
+    }
+    if (waiter) { waiter->notify(); }
+  }
+
+  void wakeAll(FiberWaitQueue& queue) {
+    std::vector<FiberWaitQueue::Waiter::ptr> waiters;
+    {
+      SpinLock::Lock lock(queue.getMutex());
+      while (auto waiter = queue.pop()) {
+        waiters.push_back(waiter);
+      }
+    }
+    for (auto& i : waiters) {
+      i->notify();
+    }
+  }
+
+  void addSelector(std::shared_ptr<FiberSemaphore> sem) {
+    SpinLock::Lock lock(m_recvQueue.getMutex());
+    m_selectors.push_back(sem);
+    ++m_selectWaiting;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void delSelector(std::shared_ptr<FiberSemaphore> sem) {
+    SpinLock::Lock lock(m_recvQueue.getMutex());
+    for (auto it = m_selectors.begin(); it != m_selectors.end(); ++it) {
+      if (*it == sem) {
+        m_selectors.erase(it);
+        --m_selectWaiting;
+        break;
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<FiberSemaphore>> getSelectors() {
+    SpinLock::Lock lock(m_recvQueue.getMutex());
+    return m_selectors;
+  }
+
+private:
+  std::unique_ptr<Cell[]> m_cells;
+  size_t                  m_mask;
+
+  alignas(64) std::atomic<size_t> m_head = {0};
+  alignas(64) std::atomic<size_t> m_tail = {0};
+
+  alignas(64) std::atomic<bool> m_closed = {false};
+  std::atomic<uint32_t> m_sendWaiting   = {0};
+  std::atomic<uint32_t> m_recvWaiting   = {0};
+  std::atomic<uint32_t> m_selectWaiting = {0};
+
+  FiberWaitQueue                               m_sendQueue;
+  FiberWaitQueue                               m_recvQueue;
+  std::vector<std::shared_ptr<FiberSemaphore>> m_selectors;
+};
+
+}  // namespace Basic
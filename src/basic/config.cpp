@@ -6,6 +6,10 @@
 
 #include <string>
 
+#include "basic/blocking.h"
+#include "basic/env.h"
+#include "basic/fiber_sync.h"
+
 namespace Basic {
 
 ConfigVarBase::ptr Config::LookupBase(const std::string& name) {
@@ -29,7 +33,10 @@ static void ListAllMember(const std::string& prefix, const YAML::Node& node,
   }
 }
 
-void Config::LoadFromYaml(const YAML::Node& root) {
+typedef std::map<std::string, std::string> ValueMap;
+
+// 已注册配置项的文本值
+static void CollectValues(const YAML::Node& root, ValueMap& values) {
   std::list<std::pair<std::string, const YAML::Node> > all_nodes;
   ListAllMember("", root, all_nodes);
 
@@ -38,41 +45,123 @@ void Config::LoadFromYaml(const YAML::Node& root) {
     if (key.empty()) { continue; }
 
     std::transform(key.begin(), key.end(), key.begin(), ::tolower);
-    ConfigVarBase::ptr var = LookupBase(key);
-
-    if (var) {
-      if (i.second.IsScalar()) {
-        var->from_string(i.second.Scalar());
-      } else {
-        std::stringstream ss;
-        ss << i.second;
-        var->from_string(ss.str());
-      }
+    if (!Config::LookupBase(key)) { continue; }
+
+    if (i.second.IsScalar()) {
+      values[key] = i.second.Scalar();
+    } else {
+      std::stringstream ss;
+      ss << i.second;
+      values[key] = ss.str();
     }
   }
 }
 
-static std::map<std::string, uint64_t> s_file2modifytime;
+// 应用与 old 不同的配置项
+static void ApplyValues(const ValueMap& values, const ValueMap* old,
+                        std::vector<std::string>& changed) {
+  for (auto& i : values) {
+    if (old) {
+      auto it = old->find(i.first);
+      if (it != old->end() && it->second == i.second) { continue; }
+    }
+    ConfigVarBase::ptr var = Config::LookupBase(i.first);
+    if (var && var->from_string(i.second)) { changed.push_back(i.first); }
+  }
+}
+
+namespace {
+
+struct FileState {
+  uint64_t mtime = 0;  // ns
+  ValueMap values;
+};
+
+struct ReloadState {
+  // 串行化文件加载, 持锁期间会在 Blocking::run 中挂起, 不能用阻塞线程的锁
+  FiberMutex                               mutex;
+  std::map<std::string, FileState>         files;
+  RWMutex                                  cbMutex;
+  std::map<uint64_t, Config::on_reload_cb> cbs;
+  uint64_t                                 cbId = 0;
+};
+
+ReloadState& GetReloadState() {
+  static ReloadState s_state;
+  return s_state;
+}
+
+}  // namespace
+
+static void NotifyReload(const std::vector<std::string>& keys) {
+  if (keys.empty()) { return; }
+  ReloadState&      state = GetReloadState();
+  RWMutex::ReadLock lock(state.cbMutex);
+  for (auto& i : state.cbs) {
+    i.second(keys);
+  }
+}
+
+void Config::LoadFromYaml(const YAML::Node& root) {
+  ValueMap values;
+  CollectValues(root, values);
+  std::vector<std::string> changed;
+  ApplyValues(values, nullptr, changed);
+  NotifyReload(changed);
+}
 
-void Config::LoadFromDir(const std::string& path, bool force) {
-  std::string              absoulte_path = "./config";
+std::vector<std::string> Config::LoadFromDir(const std::string& path, bool force) {
+  std::string absoulte_path = path.empty() ? EnvMgr::GetInstance()->getConfigPath()
+                                           : EnvMgr::GetInstance()->getAbsolutePath(path);
   std::vector<std::string> files;
-  // FSUtil::ListAllFile(files, absoulte_path, ".yaml");
-  files.push_back("/home/abc/server/bin/config/log.yaml");
+  list_all_file(files, absoulte_path, ".yaml");
+  return LoadFromFiles(files, force);
+}
 
+std::vector<std::string> Config::LoadFromFiles(const std::vector<std::string>& files, bool force) {
+  ReloadState&             state = GetReloadState();
+  std::vector<std::string> changed;
+  FiberMutex::Lock         lock(state.mutex);
   for (auto& i : files) {
-    {
-      struct stat st;
-      lstat(i.c_str(), &st);
-      if (!force && s_file2modifytime[i] == (uint64_t)st.st_mtime) { continue; }
-      s_file2modifytime[i] = st.st_mtime;
+    struct stat st;
+    if (stat(i.c_str(), &st)) {
+      state.files.erase(i);
+      continue;
     }
+    FileState& file  = state.files[i];
+    uint64_t   mtime = st.st_mtim.tv_sec * 1000000000ul + st.st_mtim.tv_nsec;
+    if (!force && file.mtime == mtime) { continue; }
+    file.mtime = mtime;
+
+    ValueMap values;
     try {
-      YAML::Node root = YAML::LoadFile(i);
-      LoadFromYaml(root);
-      LOG_INFO("LoadConfFile file=%s ok", i.c_str());
-    } catch (...) { LOG_ERROR("LoadConfFile file=%s failed", i.c_str()); }
+      YAML::Node root = Blocking::run([&i]() { return YAML::LoadFile(i); });
+      CollectValues(root, values);
+    } catch (...) {
+      LOG_ERROR("LoadConfFile file=%s failed", i.c_str());
+      continue;
+    }
+    size_t count = changed.size();
+    ApplyValues(values, &file.values, changed);
+    file.values.swap(values);
+    LOG_INFO("LoadConfFile file=%s ok, changed=%lu", i.c_str(), changed.size() - count);
   }
+  lock.unlock();
+  NotifyReload(changed);
+  return changed;
+}
+
+uint64_t Config::AddReloadListener(on_reload_cb cb) {
+  ReloadState&       state = GetReloadState();
+  RWMutex::WriteLock lock(state.cbMutex);
+  state.cbs[++state.cbId] = cb;
+  return state.cbId;
+}
+
+void Config::DelReloadListener(uint64_t key) {
+  ReloadState&       state = GetReloadState();
+  RWMutex::WriteLock lock(state.cbMutex);
+  state.cbs.erase(key);
 }
 
 void Config::Visit(std::function<void(ConfigVarBase::ptr)> cb) {
@@ -3,6 +3,7 @@
 #include <yaml-cpp/yaml.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <exception>
 #include <functional>
@@ -11,6 +12,7 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "basic/lexical_cast.h"
 #include "basic/log.h"
@@ -52,15 +54,14 @@ public:
   typedef RWMutex                                                     LockType;
 
   ConfigVar(const std::string& name, const T& default_value, const std::string& desc = "")
-      : ConfigVarBase(name, desc), m_val(default_value) {}
+      : ConfigVarBase(name, desc), m_val(std::make_shared<const T>(default_value)) {}
 
   std::string to_string() override {
     try {
-      LockType::ReadLock lock(m_lock);
-      return ToStr()(m_val);
+      return ToStr()(*getSnapshot());
     } catch (std::exception& e) {
       LOG_ERROR("ConfigVar::toString exception:%s, convert:%s, name=%s", e.what(),
-                type_name(m_val).c_str(), m_name.c_str());
+                type_name<T>().c_str(), m_name.c_str());
       return "";
     }
   }
@@ -79,19 +80,27 @@ public:
   void setValue(const T& v) {
     {
       LockType::ReadLock lock(m_lock);
-      if (v == m_val) return;
+      if (v == *m_val) return;
       for (auto& i : m_cbs) {
-        i.second(m_val, v);
+        i.second(*m_val, v);
       }
     }
+    auto                val = std::make_shared<const T>(v);
     LockType::WriteLock lock(m_lock);
-    m_val = v;
+    m_val = val;
+    m_version.fetch_add(1, std::memory_order_release);
   }
 
-  const T getValue() {
-    LockType::ReadLock lock(m_lock);
-    return m_val;
-  }
+  /**
+   * @brief 返回当前值的只读快照, 不加锁也不拷贝值
+   * @details 每次修改发布一个新的快照, 每个线程缓存最近读到的快照指针, 版本号未变化时
+   *          直接返回缓存, 只在值被修改后的第一次读取时加锁取新指针. 快照在持有期间不会变化,
+   *          可以跨越协程切换和线程迁移
+   */
+  std::shared_ptr<const T> getSnapshot() { return cachedSnapshot(); }
+
+  /// 返回当前值的拷贝, 容器类型在热路径上应使用 getSnapshot
+  T getValue() { return *cachedSnapshot(); }
 
   std::string getTypeName() const override { return type_name<T>(); }
 
@@ -119,16 +128,52 @@ public:
     m_cbs.clear();
   }
 
+private:
+  struct Cache {
+    uint64_t                 version = 0;
+    std::shared_ptr<const T> value;
+  };
+
+  // 返回本线程缓存中的指针, 调用方在下一次读取本变量前使用或拷贝
+  const std::shared_ptr<const T>& cachedSnapshot() {
+    Cache&   cache   = threadCache();
+    uint64_t version = m_version.load(std::memory_order_acquire);
+    if (cache.version != version) {
+      LockType::ReadLock lock(m_lock);
+      cache.value   = m_val;
+      cache.version = m_version.load(std::memory_order_relaxed);
+    }
+    return cache.value;
+  }
+
+  Cache& threadCache() {
+    // 线程退出时随线程释放
+    static thread_local std::unique_ptr<std::vector<std::unique_ptr<Cache>>> t_caches;
+    if (!t_caches) { t_caches.reset(new std::vector<std::unique_ptr<Cache>>); }
+    auto& caches = *t_caches;
+    if (m_index >= caches.size()) { caches.resize(m_index + 1); }
+    if (!caches[m_index]) { caches[m_index].reset(new Cache); }
+    return *caches[m_index];
+  }
+
+  static size_t NextIndex() {
+    static std::atomic<size_t> s_index{0};
+    return s_index++;
+  }
+
 private:
   LockType                         m_lock;
-  T                                m_val;
+  std::shared_ptr<const T>         m_val;  // 当前值的快照, 修改时整体替换
   std::map<uint64_t, on_change_cb> m_cbs;
+  std::atomic<uint64_t>            m_version = {1};  // 每次修改加一, 线程缓存据此判断是否过期
+  const size_t                     m_index   = NextIndex();  // 同类型变量在线程缓存中的下标
 };
 
 class Config {
 public:
-  typedef std::unordered_map<std::string, ConfigVarBase::ptr> ConfigVarMap;
-  typedef RWMutex                                             LockType;
+  typedef std::unordered_map<std::string, ConfigVarBase::ptr>        ConfigVarMap;
+  typedef RWMutex                                                    LockType;
+  typedef std::function<void(const std::vector<std::string>& keys)> on_reload_cb;
 
   template <class T>
   static typename ConfigVar<T>::ptr Lookup(const std::string& name, const T& default_value,
@@ -168,7 +213,26 @@ public:
   static void               Visit(std::function<void(ConfigVarBase::ptr)> cb);
 
   static void LoadFromYaml(const YAML::Node& root);
-  static void LoadFromDir(const std::string& path, bool force = false);
+
+  /**
+   * @brief 加载目录(为空时使用 Env 的配置目录)下的所有 .yaml 文件
+   * @return 值发生变化的配置名
+   */
+  static std::vector<std::string> LoadFromDir(const std::string& path, bool force = false);
+
+  /**
+   * @brief 加载配置文件
+   * @details 文件修改时间未变时跳过(force 除外); 只应用与该文件上次加载内容不同的配置项,
+   *          没有变化的配置不会重新解析也不会触发监听. 全部文件加载完后, 有变化时通知一次
+   *          ReloadListener. 在协程中时文件解析交给阻塞线程池
+   * @return 值发生变化的配置名
+   */
+  static std::vector<std::string> LoadFromFiles(const std::vector<std::string>& files,
+                                                bool                            force = false);
+
+  /// 每次加载后以变化的配置名批量通知
+  static uint64_t AddReloadListener(on_reload_cb cb);
+  static void     DelReloadListener(uint64_t key);
 
 private:
   static ConfigVarMap& GetDatas() {
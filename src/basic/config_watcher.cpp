@@ -0,0 +1,158 @@
+#include "basic/config_watcher.h"
+
+#include <string.h>
+#include <sys/inotify.h>
+
+#include <vector>
+
+#include "basic/config.h"
+#include "basic/env.h"
+#include "basic/hook.h"
+#include "basic/log.h"
+
+namespace Basic {
+
+static ConfigVar<uint32_t>::ptr g_reload_delay =
+    Config::Lookup("config.reload_delay_ms", (uint32_t)10, "配置文件变化后合并事件的等待时间");
+
+static const uint32_t s_watch_mask =
+    IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_DELETE_SELF;
+
+static bool is_yaml(const std::string& name) {
+  static const std::string subfix = ".yaml";
+  return name.size() >= subfix.size() &&
+         name.compare(name.size() - subfix.size(), subfix.size(), subfix) == 0;
+}
+
+ConfigWatcher::ConfigWatcher(const std::string& path, IOManager* iom) : m_iom(iom) {
+  m_path = path.empty() ? EnvMgr::GetInstance()->getConfigPath()
+                        : EnvMgr::GetInstance()->getAbsolutePath(path);
+}
+
+ConfigWatcher::~ConfigWatcher() {
+  stop();
+}
+
+bool ConfigWatcher::start() {
+  if (!m_stop) { return true; }
+  if (!m_iom) {
+    LOG_ERROR("ConfigWatcher start without IOManager, path=%s", m_path.c_str());
+    return false;
+  }
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_fd < 0) {
+    LOG_ERROR("inotify_init1 error errno=%d errstr=%s", errno, strerror(errno));
+    return false;
+  }
+  std::vector<std::string> files;
+  list_all_file(files, m_path, ".yaml");
+  std::set<std::string> dirs = {m_path};
+  for (auto& i : files) {
+    dirs.insert(i.substr(0, i.rfind('/')));
+  }
+  for (auto& i : dirs) {
+    if (!addWatch(i) && i == m_path) {
+      close_f(m_fd);
+      m_fd = -1;
+      return false;
+    }
+  }
+  Config::LoadFromFiles(files);
+
+  m_stop = false;
+  m_running.add();
+  m_iom->schedule(std::bind(&ConfigWatcher::run, this));
+  return true;
+}
+
+void ConfigWatcher::stop() {
+  if (m_stop.exchange(true)) { return; }
+  m_iom->cancelEvent(m_fd, IOManager::READ);
+  m_running.wait();
+  close_f(m_fd);
+  m_fd = -1;
+  m_dirs.clear();
+}
+
+bool ConfigWatcher::addWatch(const std::string& dir) {
+  int wd = inotify_add_watch(m_fd, dir.c_str(), s_watch_mask);
+  if (wd < 0) {
+    LOG_ERROR("inotify_add_watch %s error errno=%d errstr=%s", dir.c_str(), errno,
+              strerror(errno));
+    return false;
+  }
+  m_dirs[wd] = dir;
+  return true;
+}
+
+bool ConfigWatcher::readEvents(std::set<std::string>& files) {
+  bool rescan = false;
+  alignas(struct inotify_event) char buf[4096];
+  while (true) {
+    // inotify fd 没有在 FdManager 中登记, 直接读
+    ssize_t n = read_f(m_fd, buf, sizeof(buf));
+    if (n <= 0) { break; }
+    for (char* p = buf; p < buf + n;) {
+      struct inotify_event* ev = (struct inotify_event*)p;
+      p += sizeof(struct inotify_event) + ev->len;
+      if (ev->mask & IN_Q_OVERFLOW) {
+        rescan = true;
+        continue;
+      }
+      auto it = m_dirs.find(ev->wd);
+      if (it == m_dirs.end()) { continue; }
+      if (ev->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+        m_dirs.erase(it);
+        continue;
+      }
+      std::string name = ev->len ? ev->name : "";
+      std::string path = it->second + "/" + name;
+      if (ev->mask & IN_ISDIR) {
+        // 新建或移入的子目录
+        if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+          addWatch(path);
+          rescan = true;
+        }
+      } else if (is_yaml(name)) {
+        files.insert(path);
+      }
+    }
+  }
+  return rescan;
+}
+
+void ConfigWatcher::run() {
+  while (true) {
+    if (m_iom->addEvent(m_fd, IOManager::READ)) {
+      LOG_ERROR("ConfigWatcher addEvent error fd=%d", m_fd);
+      break;
+    }
+    // stop 在 addEvent 之前调用时 cancelEvent 没有生效, 这里补上
+    if (m_stop) { m_iom->cancelEvent(m_fd, IOManager::READ); }
+    Fiber::Yield2Hold();
+    if (m_stop) { break; }
+
+    std::set<std::string> files;
+    bool                  rescan = readEvents(files);
+    // 编辑器保存一次文件往往产生多个事件, 等待一会一起处理
+    usleep(g_reload_delay->getValue() * 1000);
+    rescan |= readEvents(files);
+    if (m_stop) { break; }
+
+    std::vector<std::string> changed;
+    if (rescan) {
+      changed = Config::LoadFromDir(m_path);
+    } else if (!files.empty()) {
+      // inotify 已经确认文件有变化, 不再比较修改时间
+      changed = Config::LoadFromFiles(std::vector<std::string>(files.begin(), files.end()), true);
+    } else {
+      continue;
+    }
+    ++m_reloadCount;
+    LOG_INFO("ConfigWatcher reload path=%s files=%lu changed=%lu", m_path.c_str(), files.size(),
+             changed.size());
+  }
+  m_running.done();
+}
+
+}  // namespace Basic
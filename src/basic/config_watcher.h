@@ -0,0 +1,56 @@
+/**
+ * 配置目录热加载
+ * 在 IOManager 上用一个协程等待配置目录的 inotify 事件, 合并一小段时间(config.reload_delay_ms)
+ * 内的事件后只重新加载变化的 .yaml 文件, 由 Config::LoadFromFiles 只应用变化的配置项
+ */
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "basic/fiber_sync.h"
+#include "basic/iomanager.h"
+#include "basic/noncopyable.h"
+
+namespace Basic {
+
+class ConfigWatcher : NonCopyable {
+public:
+  typedef std::shared_ptr<ConfigWatcher> ptr;
+
+  /**
+   * @param[in] path 配置目录, 为空时使用 Env 的配置目录
+   * @param[in] iom 运行监听协程的IOManager
+   */
+  ConfigWatcher(const std::string& path = "", IOManager* iom = IOManager::GetThis());
+  ~ConfigWatcher();
+
+  /// 加载一次目录并开始监听, 失败返回false
+  bool start();
+  /// 停止监听, 等待监听协程退出
+  void stop();
+
+  const std::string& getPath() const { return m_path; }
+  /// 触发重新加载的次数
+  uint64_t           getReloadCount() const { return m_reloadCount; }
+
+private:
+  void run();
+  bool addWatch(const std::string& dir);
+  /// 读出所有事件, 变化的文件放入 files, 需要重新扫描目录时返回true
+  bool readEvents(std::set<std::string>& files);
+
+private:
+  std::string                m_path;
+  IOManager*                 m_iom;
+  int                        m_fd = -1;
+  std::map<int, std::string> m_dirs;  // watch descriptor -> 目录
+  std::atomic<bool>          m_stop        = {true};
+  std::atomic<uint64_t>      m_reloadCount = {0};
+  WaitGroup                  m_running;
+};
+
+}  // namespace Basic
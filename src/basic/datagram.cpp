@@ -0,0 +1,112 @@
+#include "basic/datagram.h"
+
+#include <netinet/udp.h>
+#include <string.h>
+
+namespace Basic {
+
+// 每个数据报一个控制消息: 接收 UDP_GRO(int) 或发送 UDP_SEGMENT(uint16_t)
+static const size_t s_control_size = CMSG_SPACE(sizeof(int));
+
+DatagramBatch::DatagramBatch(size_t capacity, size_t buf_size)
+    : m_capacity(capacity),
+      m_bufSize(buf_size),
+      m_buffer(capacity * buf_size),
+      m_iovs(capacity),
+      m_addrs(capacity),
+      m_control(capacity * s_control_size),
+      m_msgs(capacity) {
+  for (size_t i = 0; i < capacity; ++i) {
+    m_iovs[i].iov_base               = getData(i);
+    m_msgs[i].msg_hdr.msg_iov        = &m_iovs[i];
+    m_msgs[i].msg_hdr.msg_iovlen     = 1;
+    m_msgs[i].msg_hdr.msg_name       = &m_addrs[i];
+    m_msgs[i].msg_hdr.msg_namelen    = 0;
+    m_msgs[i].msg_hdr.msg_control    = nullptr;
+    m_msgs[i].msg_hdr.msg_controllen = 0;
+    m_msgs[i].msg_hdr.msg_flags      = 0;
+  }
+}
+
+uint16_t DatagramBatch::getSegmentSize(size_t i) const {
+  msghdr* hdr = (msghdr*)&m_msgs[i].msg_hdr;
+  if (!hdr->msg_control) { return 0; }
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+    if (cmsg->cmsg_level != SOL_UDP) { continue; }
+    if (cmsg->cmsg_type == UDP_GRO) {
+      int v;
+      memcpy(&v, CMSG_DATA(cmsg), sizeof(v));
+      return v;
+    }
+    if (cmsg->cmsg_type == UDP_SEGMENT) {
+      uint16_t v;
+      memcpy(&v, CMSG_DATA(cmsg), sizeof(v));
+      return v;
+    }
+  }
+  return 0;
+}
+
+bool DatagramBatch::add(const void* data, size_t len, const sockaddr* to, socklen_t tolen,
+                        uint16_t segment) {
+  if (m_size >= m_capacity || len > m_bufSize) { return false; }
+  memcpy(getData(m_size), data, len);
+  return commit(len, to, tolen, segment);
+}
+
+bool DatagramBatch::commit(size_t len, const sockaddr* to, socklen_t tolen, uint16_t segment) {
+  if (m_size >= m_capacity || len > m_bufSize || tolen > sizeof(sockaddr_storage)) {
+    return false;
+  }
+  size_t i         = m_size++;
+  m_iovs[i].iov_len = len;
+  memcpy(&m_addrs[i], to, tolen);
+  m_msgs[i].msg_hdr.msg_namelen = tolen;
+  m_msgs[i].msg_hdr.msg_flags   = 0;
+  setSegment(i, segment);
+  return true;
+}
+
+void DatagramBatch::reflect() {
+  for (size_t i = 0; i < m_size; ++i) {
+    // 先取出 GRO 的大小, 再改成发送用的控制消息
+    setSegment(i, getSegmentSize(i));
+    m_msgs[i].msg_hdr.msg_flags = 0;
+  }
+}
+
+void DatagramBatch::prepareRecv() {
+  m_size = 0;
+  for (size_t i = 0; i < m_capacity; ++i) {
+    m_iovs[i].iov_len                = m_bufSize;
+    m_msgs[i].msg_hdr.msg_namelen    = sizeof(sockaddr_storage);
+    m_msgs[i].msg_hdr.msg_control    = &m_control[i * s_control_size];
+    m_msgs[i].msg_hdr.msg_controllen = s_control_size;
+    m_msgs[i].msg_hdr.msg_flags      = 0;
+  }
+}
+
+void DatagramBatch::finishRecv(size_t count) {
+  m_size = count;
+  for (size_t i = 0; i < count; ++i) {
+    m_iovs[i].iov_len = m_msgs[i].msg_len;
+  }
+}
+
+void DatagramBatch::setSegment(size_t i, uint16_t segment) {
+  msghdr& hdr = m_msgs[i].msg_hdr;
+  if (segment == 0) {
+    hdr.msg_control    = nullptr;
+    hdr.msg_controllen = 0;
+    return;
+  }
+  hdr.msg_control    = &m_control[i * s_control_size];
+  hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+  cmsghdr* cmsg      = CMSG_FIRSTHDR(&hdr);
+  cmsg->cmsg_level   = SOL_UDP;
+  cmsg->cmsg_type    = UDP_SEGMENT;
+  cmsg->cmsg_len     = CMSG_LEN(sizeof(uint16_t));
+  memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+}
+
+}  // namespace Basic
@@ -0,0 +1,77 @@
+/**
+ * UDP 批量收发缓冲区
+ * 预先分配 capacity 个数据报的缓冲区/地址/控制消息, Socket::recvBatch/sendBatch 用 recvmmsg/sendmmsg
+ * 一次系统调用处理整批数据报, 收发过程中不再申请内存.
+ * 开启 UDP_GRO 时一个数据报可能是多个同样大小的报文合并的, getSegmentSize 返回合并前的大小;
+ * 发送时指定 segment 使用 UDP_SEGMENT(GSO), 由内核把一个大数据报切分成多个报文
+ */
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <memory>
+#include <vector>
+
+#include "basic/noncopyable.h"
+
+namespace Basic {
+
+class DatagramBatch : NonCopyable {
+public:
+  typedef std::shared_ptr<DatagramBatch> ptr;
+
+  /**
+   * @param[in] capacity 一批最多的数据报个数
+   * @param[in] buf_size 每个数据报的缓冲区大小, 开启 GRO 时应为 64KB
+   */
+  DatagramBatch(size_t capacity, size_t buf_size);
+
+  size_t getCapacity() const { return m_capacity; }
+  size_t getBufferSize() const { return m_bufSize; }
+  /// 当前有效的数据报个数
+  size_t size() const { return m_size; }
+  bool   empty() const { return m_size == 0; }
+  void   clear() { m_size = 0; }
+
+  /// 第 i 个数据报的内容
+  char*           getData(size_t i) { return m_buffer.data() + i * m_bufSize; }
+  size_t          getLength(size_t i) const { return m_iovs[i].iov_len; }
+  /// 收到时为来源地址, 发送时为目标地址
+  const sockaddr* getAddr(size_t i) const { return (const sockaddr*)&m_addrs[i]; }
+  socklen_t       getAddrLen(size_t i) const { return m_msgs[i].msg_hdr.msg_namelen; }
+  /// GRO 合并的数据报中每个报文的大小, 没有合并返回0
+  uint16_t        getSegmentSize(size_t i) const;
+
+  /**
+   * @brief 复制一个待发送的数据报
+   * @param[in] segment 大于0时使用 GSO 按该大小切分
+   * @return 批已满或数据超过缓冲区大小时返回false
+   */
+  bool add(const void* data, size_t len, const sockaddr* to, socklen_t tolen,
+           uint16_t segment = 0);
+  /// 在第 i 个缓冲区中直接写入 len 字节后提交, 缓冲区通过 getData(size()) 获得
+  bool commit(size_t len, const sockaddr* to, socklen_t tolen, uint16_t segment = 0);
+  /// 把收到的数据报原样发回来源地址, GRO 合并的数据报按原来的大小切分
+  void reflect();
+
+  /// Socket 使用
+  mmsghdr* getMsgs() { return m_msgs.data(); }
+  void     prepareRecv();
+  void     finishRecv(size_t count);
+
+private:
+  void setSegment(size_t i, uint16_t segment);
+
+private:
+  size_t                        m_capacity;
+  size_t                        m_bufSize;
+  size_t                        m_size = 0;
+  std::vector<char>             m_buffer;
+  std::vector<iovec>            m_iovs;
+  std::vector<sockaddr_storage> m_addrs;
+  std::vector<char>             m_control;
+  std::vector<mmsghdr>          m_msgs;
+};
+
+}  // namespace Basic
@@ -0,0 +1,404 @@
+#include "basic/dns.h"
+
+#include <netdb.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "basic/blocking.h"
+#include "basic/bytearray.h"
+#include "basic/config.h"
+#include "basic/hook.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/socket.h"
+
+namespace Basic {
+
+static ConfigVar<uint64_t>::ptr g_dns_negative_ttl =
+    Config::Lookup("dns.negative_ttl", (uint64_t)(5 * 1000), "dns解析失败缓存时间ms");
+
+static ConfigVar<uint64_t>::ptr g_dns_max_ttl =
+    Config::Lookup("dns.max_ttl", (uint64_t)(300 * 1000), "dns记录最长缓存时间ms");
+
+static const uint16_t DNS_TYPE_A    = 1;
+static const uint16_t DNS_TYPE_AAAA = 28;
+static const uint16_t DNS_CLASS_IN  = 1;
+
+static IPAddress::ptr CloneAddress(IPAddress::ptr addr) {
+  return std::dynamic_pointer_cast<IPAddress>(
+      Address::Create(addr->getAddr(), addr->getAddrLen()));
+}
+
+// IPAddress::Create 对非数字地址会打错误日志, 这里只做判断
+static IPAddress::ptr ParseNumeric(const std::string& host, uint16_t port = 0) {
+  in_addr  v4;
+  in6_addr v6;
+  if (inet_pton(AF_INET, host.c_str(), &v4) == 1) {
+    return std::make_shared<IPv4Address>(ntohl(v4.s_addr), port);
+  }
+  if (inet_pton(AF_INET6, host.c_str(), &v6) == 1) {
+    return std::make_shared<IPv6Address>(v6.s6_addr, port);
+  }
+  return nullptr;
+}
+
+static bool Getaddrinfo(std::vector<IPAddress::ptr>& result, const std::string& host, int family) {
+  addrinfo hints, *results = nullptr;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family   = family;
+  hints.ai_socktype = SOCK_STREAM;
+
+  int error = getaddrinfo(host.c_str(), nullptr, &hints, &results);
+  if (error) {
+    LOG_ERROR("DnsResolver getaddrinfo(%s, %d) err=%d errstr=%s", host.c_str(), family, error,
+              gai_strerror(error));
+    return false;
+  }
+  for (addrinfo* next = results; next; next = next->ai_next) {
+    auto addr = std::dynamic_pointer_cast<IPAddress>(
+        Address::Create(next->ai_addr, (socklen_t)next->ai_addrlen));
+    if (addr) { result.push_back(addr); }
+  }
+  freeaddrinfo(results);
+  return !result.empty();
+}
+
+DnsResolver::DnsResolver() {
+  loadHosts();
+  loadResolvConf();
+}
+
+bool DnsResolver::loadHosts(const std::string& path) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    LOG_WARN_STREAM << "DnsResolver loadHosts " << path << " fail";
+    return false;
+  }
+
+  std::multimap<std::string, IPAddress::ptr> hosts;
+  std::string                                line;
+  while (std::getline(ifs, line)) {
+    size_t pos = line.find('#');
+    if (pos != std::string::npos) { line.resize(pos); }
+
+    std::stringstream ss(line);
+    std::string       ip;
+    if (!(ss >> ip)) { continue; }
+    IPAddress::ptr addr = ParseNumeric(ip);
+    if (!addr) { continue; }
+
+    std::string name;
+    while (ss >> name) {
+      std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+      hosts.insert(std::make_pair(name, addr));
+    }
+  }
+
+  LockType::WriteLock lock(m_mutex);
+  m_hosts.swap(hosts);
+  return true;
+}
+
+bool DnsResolver::loadResolvConf(const std::string& path) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    LOG_WARN_STREAM << "DnsResolver loadResolvConf " << path << " fail";
+    return false;
+  }
+
+  std::vector<Address::ptr> servers;
+  uint64_t                  timeout  = 5000;
+  uint32_t                  attempts = 2;
+  std::string               line;
+  while (std::getline(ifs, line)) {
+    std::stringstream ss(line);
+    std::string       key;
+    if (!(ss >> key) || key[0] == '#' || key[0] == ';') { continue; }
+
+    if (key == "nameserver") {
+      std::string    ip;
+      IPAddress::ptr addr;
+      if ((ss >> ip) && (addr = ParseNumeric(ip, 53))) { servers.push_back(addr); }
+    } else if (key == "options") {
+      std::string opt;
+      while (ss >> opt) {
+        if (opt.compare(0, 8, "timeout:") == 0) {
+          timeout = std::max(atoi(opt.c_str() + 8), 1) * 1000;
+        } else if (opt.compare(0, 9, "attempts:") == 0) {
+          attempts = std::max(atoi(opt.c_str() + 9), 1);
+        }
+      }
+    }
+  }
+
+  LockType::WriteLock lock(m_mutex);
+  m_nameservers.swap(servers);
+  m_timeout  = timeout;
+  m_attempts = attempts;
+  return true;
+}
+
+void DnsResolver::setNameservers(const std::vector<Address::ptr>& v) {
+  LockType::WriteLock lock(m_mutex);
+  m_nameservers = v;
+}
+
+void DnsResolver::clearCache() {
+  LockType::WriteLock lock(m_mutex);
+  m_cache.clear();
+}
+
+bool DnsResolver::lookupHosts(std::vector<IPAddress::ptr>& result, const std::string& host,
+                              int family) {
+  LockType::ReadLock lock(m_mutex);
+  auto               its = m_hosts.equal_range(host);
+  for (; its.first != its.second; ++its.first) {
+    if (family == AF_UNSPEC || family == its.first->second->getFamily()) {
+      result.push_back(CloneAddress(its.first->second));
+    }
+  }
+  return !result.empty();
+}
+
+bool DnsResolver::lookupCache(std::vector<IPAddress::ptr>& result, const std::string& key) {
+  uint64_t           now_ms = get_current_ms();
+  LockType::ReadLock lock(m_mutex);
+  auto               it = m_cache.find(key);
+  if (it == m_cache.end() || it->second.expire <= now_ms) { return false; }
+  for (auto& i : it->second.addrs) {
+    result.push_back(CloneAddress(i));
+  }
+  return true;
+}
+
+void DnsResolver::insertCache(const std::string& key, const std::vector<IPAddress::ptr>& addrs,
+                              uint64_t ttl_ms) {
+  if (ttl_ms == 0) { return; }
+  uint64_t            now_ms = get_current_ms();
+  LockType::WriteLock lock(m_mutex);
+  for (auto it = m_cache.begin(); it != m_cache.end();) {
+    if (it->second.expire <= now_ms) {
+      it = m_cache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  CacheEntry& entry = m_cache[key];
+  entry.addrs       = addrs;
+  entry.expire      = now_ms + ttl_ms;
+}
+
+bool DnsResolver::resolve(std::vector<IPAddress::ptr>& result, const std::string& host,
+                          int family) {
+  if (host.empty()) { return false; }
+
+  IPAddress::ptr numeric = ParseNumeric(host);
+  if (numeric) {
+    if (family != AF_UNSPEC && family != numeric->getFamily()) { return false; }
+    result.push_back(numeric);
+    return true;
+  }
+
+  std::string name = host;
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  if (name.back() == '.') { name.pop_back(); }
+
+  if (lookupHosts(result, name, family)) { return true; }
+
+  std::string key = std::to_string(family) + ":" + name;
+  if (lookupCache(result, key)) {
+    ++m_hits;
+    return !result.empty();
+  }
+
+  std::vector<IPAddress::ptr> addrs;
+  uint32_t                    ttl      = ~0u;
+  bool                        failed   = false;
+  bool                        nxdomain = false;
+  if (IOManager::GetThis() && is_hook_enable()) {
+    if (family == AF_UNSPEC || family == AF_INET) {
+      int rt   = query(addrs, name, DNS_TYPE_A, ttl);
+      failed   = rt < 0;
+      nxdomain = rt > 0;
+    }
+    if (!failed && !nxdomain && (family == AF_UNSPEC || family == AF_INET6)) {
+      failed = query(addrs, name, DNS_TYPE_AAAA, ttl) < 0;
+    }
+  } else {
+    failed = true;
+  }
+
+  if (failed) {
+    addrs.clear();
+    Blocking::run([&addrs, &name, family]() { return Getaddrinfo(addrs, name, family); });
+    ttl = ~0u;
+    if (family == AF_UNSPEC) {
+      std::stable_sort(addrs.begin(), addrs.end(), [](IPAddress::ptr a, IPAddress::ptr b) {
+        return a->getFamily() == AF_INET && b->getFamily() != AF_INET;
+      });
+    }
+    // getaddrinfo 可能对同一地址返回多条
+    addrs.erase(std::unique(addrs.begin(), addrs.end(),
+                            [](IPAddress::ptr a, IPAddress::ptr b) { return *a == *b; }),
+                addrs.end());
+  }
+
+  uint64_t ttl_ms = addrs.empty() ? g_dns_negative_ttl->getValue()
+                                  : std::min((uint64_t)ttl * 1000, g_dns_max_ttl->getValue());
+  insertCache(key, addrs, ttl_ms);
+
+  for (auto& i : addrs) {
+    result.push_back(CloneAddress(i));
+  }
+  return !result.empty();
+}
+
+int DnsResolver::query(std::vector<IPAddress::ptr>& result, const std::string& host,
+                       uint16_t qtype, uint32_t& ttl) {
+  std::vector<Address::ptr> servers;
+  uint32_t                  attempts;
+  {
+    LockType::ReadLock lock(m_mutex);
+    servers  = m_nameservers;
+    attempts = m_attempts;
+  }
+  if (servers.empty()) { return -1; }
+
+  for (uint32_t i = 0; i < attempts; ++i) {
+    for (auto& server : servers) {
+      int rt = queryServer(result, server, host, qtype, ttl);
+      if (rt >= 0) { return rt; }
+    }
+  }
+  return -1;
+}
+
+// 跳过报文中的域名, 支持压缩指针
+static void SkipName(ByteArray& ba) {
+  while (true) {
+    uint8_t len = ba.readFuint8();
+    if (len == 0) { return; }
+    if ((len & 0xC0) == 0xC0) {
+      ba.readFuint8();
+      return;
+    }
+    ba.setPosition(ba.getPosition() + len);
+  }
+}
+
+int DnsResolver::queryServer(std::vector<IPAddress::ptr>& result, Address::ptr server,
+                             const std::string& host, uint16_t qtype, uint32_t& ttl) {
+  static std::atomic<uint16_t> s_id{(uint16_t)get_current_us()};
+  uint16_t                     id = ++s_id;
+
+  ByteArray req;
+  req.writeFuint16(id);
+  req.writeFuint16(0x0100);  // RD
+  req.writeFuint16(1);       // QDCOUNT
+  req.writeFuint16(0);
+  req.writeFuint16(0);
+  req.writeFuint16(0);
+  size_t begin = 0;
+  while (begin < host.size()) {
+    size_t end = host.find('.', begin);
+    if (end == std::string::npos) { end = host.size(); }
+    if (end - begin == 0 || end - begin > 63) { return -1; }
+    req.writeFuint8(end - begin);
+    req.write(host.c_str() + begin, end - begin);
+    begin = end + 1;
+  }
+  req.writeFuint8(0);
+  req.writeFuint16(qtype);
+  req.writeFuint16(DNS_CLASS_IN);
+  req.setPosition(0);
+  std::string data = req.to_string();
+
+  Socket::ptr sock = Socket::CreateUDP(server);
+  if (!sock->isValid()) { return -1; }
+  sock->setRecvTimeout(m_timeout);
+
+  ++m_queries;
+  if (sock->sendTo(data.c_str(), data.size(), server) != (int)data.size()) {
+    LOG_WARN_STREAM << "DnsResolver sendTo " << *server << " fail errno=" << errno;
+    return -1;
+  }
+
+  char buff[1500];
+  int  len = 0;
+  while (true) {
+    Address::ptr from = Address::Create(server->getAddr(), server->getAddrLen());
+    len               = sock->recvFrom(buff, sizeof(buff), from);
+    if (len <= 0) {
+      LOG_WARN_STREAM << "DnsResolver recvFrom " << *server << " host=" << host
+                      << " fail errno=" << errno;
+      return -1;
+    }
+    if (len >= 12 && *from == *server && (((uint8_t)buff[0] << 8) | (uint8_t)buff[1]) == id) {
+      break;
+    }
+  }
+
+  try {
+    ByteArray rsp;
+    rsp.write(buff, len);
+    rsp.setPosition(2);
+    uint16_t flags   = rsp.readFuint16();
+    uint16_t qdcount = rsp.readFuint16();
+    uint16_t ancount = rsp.readFuint16();
+    rsp.readFuint16();
+    rsp.readFuint16();
+
+    if (!(flags & 0x8000) || (flags & 0x0200)) { return -1; }  // 非应答或被截断
+    uint16_t rcode = flags & 0x000F;
+    if (rcode == 3) { return 1; }
+    if (rcode != 0) { return -1; }
+
+    for (uint16_t i = 0; i < qdcount; ++i) {
+      SkipName(rsp);
+      rsp.readFuint32();
+    }
+
+    for (uint16_t i = 0; i < ancount; ++i) {
+      SkipName(rsp);
+      uint16_t type  = rsp.readFuint16();
+      uint16_t cls   = rsp.readFuint16();
+      uint32_t rttl  = rsp.readFuint32();
+      uint16_t rdlen = rsp.readFuint16();
+      size_t   rdata = rsp.getPosition();
+      if (cls == DNS_CLASS_IN && type == DNS_TYPE_A && rdlen == 4) {
+        uint32_t ip = rsp.readFuint32();
+        result.push_back(std::make_shared<IPv4Address>(ip));
+        ttl = std::min(ttl, rttl);
+      } else if (cls == DNS_CLASS_IN && type == DNS_TYPE_AAAA && rdlen == 16) {
+        uint8_t ip[16];
+        rsp.read(ip, sizeof(ip));
+        result.push_back(std::make_shared<IPv6Address>(ip));
+        ttl = std::min(ttl, rttl);
+      }
+      rsp.setPosition(rdata + rdlen);
+    }
+  } catch (std::exception& e) {
+    LOG_WARN_STREAM << "DnsResolver parse response from " << *server << " error: " << e.what();
+    return -1;
+  }
+  return 0;
+}
+
+std::string DnsResolver::to_string() {
+  std::stringstream  ss;
+  LockType::ReadLock lock(m_mutex);
+  ss << "[DnsResolver timeout=" << m_timeout << " attempts=" << m_attempts
+     << " cache_size=" << m_cache.size() << " queries=" << m_queries << " hits=" << m_hits
+     << " nameservers=";
+  for (size_t i = 0; i < m_nameservers.size(); ++i) {
+    if (i) { ss << ","; }
+    ss << *m_nameservers[i];
+  }
+  ss << "]";
+  return ss.str();
+}
+
+}  // namespace Basic
@@ -0,0 +1,81 @@
+/**
+ * 协程友好的DNS解析
+ * 1. 先查 /etc/hosts, 再查缓存
+ * 2. 在IOManager中通过UDP向 resolv.conf 中的 nameserver 查询 A/AAAA 记录, 等待由hook接管
+ * 3. UDP查询失败(超时/截断)时调用 getaddrinfo, 在协程中通过 Blocking 交给线程池执行
+ * 结果按记录TTL缓存, 解析失败按 dns.negative_ttl 缓存
+ */
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "basic/address.h"
+#include "basic/mutex.h"
+#include "basic/singleton.h"
+
+namespace Basic {
+
+class DnsResolver {
+public:
+  typedef std::shared_ptr<DnsResolver> ptr;
+  typedef RWMutex                      LockType;
+
+  DnsResolver();
+
+  /**
+   * @brief 解析域名, 返回的地址端口为0
+   * @param[in] family AF_UNSPEC 时IPv4地址在前
+   * @return 是否解析到地址
+   */
+  bool resolve(std::vector<IPAddress::ptr>& result, const std::string& host,
+               int family = AF_UNSPEC);
+
+  bool loadHosts(const std::string& path = "/etc/hosts");
+  bool loadResolvConf(const std::string& path = "/etc/resolv.conf");
+
+  void setNameservers(const std::vector<Address::ptr>& v);
+  void setTimeout(uint64_t v) { m_timeout = v; }
+  void setAttempts(uint32_t v) { m_attempts = v; }
+
+  void clearCache();
+
+  uint64_t getQueryCount() const { return m_queries; }
+  uint64_t getCacheHitCount() const { return m_hits; }
+
+  std::string to_string();
+
+private:
+  struct CacheEntry {
+    std::vector<IPAddress::ptr> addrs;
+    uint64_t                    expire = 0;
+  };
+
+  bool lookupHosts(std::vector<IPAddress::ptr>& result, const std::string& host, int family);
+  bool lookupCache(std::vector<IPAddress::ptr>& result, const std::string& key);
+  void insertCache(const std::string& key, const std::vector<IPAddress::ptr>& addrs,
+                   uint64_t ttl_ms);
+
+  /// @return 0 成功, 1 域名不存在, -1 查询失败需要回退
+  int query(std::vector<IPAddress::ptr>& result, const std::string& host, uint16_t qtype,
+            uint32_t& ttl);
+  int queryServer(std::vector<IPAddress::ptr>& result, Address::ptr server,
+                  const std::string& host, uint16_t qtype, uint32_t& ttl);
+
+private:
+  LockType                                   m_mutex;
+  std::multimap<std::string, IPAddress::ptr> m_hosts;
+  std::vector<Address::ptr>                  m_nameservers;
+  std::map<std::string, CacheEntry>          m_cache;
+  uint64_t                                   m_timeout  = 5000;
+  uint32_t                                   m_attempts = 2;
+  std::atomic<uint64_t>                      m_queries  = {0};
+  std::atomic<uint64_t>                      m_hits     = {0};
+};
+
+typedef Singleton<DnsResolver> DnsMgr;
+
+}  // namespace Basic
@@ -72,7 +72,8 @@ void Env::del(const std::string& key) {
 
 std::string Env::get(const std::string& key, const std::string& default_value) {
   LockType::ReadLock lock(m_lock);
-  return m_args.find(key) != m_args.end() ? m_args[key] : default_value;
+  auto               it = m_args.find(key);
+  return it != m_args.end() ? it->second : default_value;
 }
 
 void Env::addHelp(const std::string& key, const std::string& desc) {
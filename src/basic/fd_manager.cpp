@@ -8,37 +8,46 @@
 
 namespace Basic {
 
-FdCtx::FdCtx(int fd)
+FdCtx::FdCtx(int fd, bool nonblock_socket)
     : m_isInit(false),
       m_isSocket(false),
+      m_isFile(false),
       m_sysNonblock(false),
       m_userNonblock(false),
       m_isClosed(false),
       m_fd(fd),
       m_recvTimeout(-1),
       m_sendTimeout(-1) {
-  init();
+  init(nonblock_socket);
 }
 
 FdCtx::~FdCtx() {}
 
-bool FdCtx::init() {
+bool FdCtx::init(bool nonblock_socket) {
   if (m_isInit) { return true; }
   m_recvTimeout = -1;
   m_sendTimeout = -1;
 
   struct stat fd_stat;
-  if (-1 == fstat(m_fd, &fd_stat)) {
+  if (nonblock_socket) {
+    m_isInit   = true;
+    m_isSocket = true;
+    m_isFile   = false;
+  } else if (-1 == fstat(m_fd, &fd_stat)) {
     m_isInit   = false;
     m_isSocket = false;
+    m_isFile   = false;
   } else {
     m_isInit   = true;
     m_isSocket = S_ISSOCK(fd_stat.st_mode);
+    m_isFile   = S_ISREG(fd_stat.st_mode);
   }
 
   if (m_isSocket) {
-    int flags = fcntl_f(m_fd, F_GETFL, 0);
-    if (!(flags & O_NONBLOCK)) { fcntl_f(m_fd, F_SETFL, flags | O_NONBLOCK); }
+    if (!nonblock_socket) {
+      int flags = fcntl_f(m_fd, F_GETFL, 0);
+      if (!(flags & O_NONBLOCK)) { fcntl_f(m_fd, F_SETFL, flags | O_NONBLOCK); }
+    }
     m_sysNonblock = true;
   } else {
     m_sysNonblock = false;
@@ -69,7 +78,7 @@ FdManager::FdManager() {
   m_datas.resize(64);
 }
 
-FdCtx::ptr FdManager::get(int fd, bool auto_create) {
+FdCtx::ptr FdManager::get(int fd, bool auto_create, bool nonblock_socket) {
   if (fd == -1) { return nullptr; }
   LockType::ReadLock lock(m_lock);
   if ((int)m_datas.size() <= fd) {
@@ -80,10 +89,10 @@ FdCtx::ptr FdManager::get(int fd, bool auto_create) {
   lock.unlock();
 
   LockType::WriteLock lock2(m_lock);
-  FdCtx::ptr          ctx(new FdCtx(fd));
   if (fd >= (int)m_datas.size()) { m_datas.resize(fd * 1.5); }
-  m_datas[fd] = ctx;
-  return ctx;
+  // 释放读锁期间可能已被其它线程创建
+  if (!m_datas[fd]) { m_datas[fd].reset(new FdCtx(fd, nonblock_socket)); }
+  return m_datas[fd];
 }
 
 void FdManager::del(int fd) {
@@ -12,12 +12,15 @@ class FdCtx : public std::enable_shared_from_this<FdCtx> {
 public:
   typedef std::shared_ptr<FdCtx> ptr;
 
-  FdCtx(int fd);
+  /// nonblock_socket: 已知是 SOCK_NONBLOCK 创建的socket(如 accept4), 省去 fstat 和 fcntl
+  FdCtx(int fd, bool nonblock_socket = false);
   ~FdCtx();
 
   bool isInit() const { return m_isInit; }
   bool isSocket() const { return m_isSocket; }
+  bool isFile() const { return m_isFile; }
   bool isClose() const { return m_isClosed; }
+  void setClose() { m_isClosed = true; }
 
   void setUserNonblock(bool v) { m_userNonblock = v; }
   bool getUserNonblock() const { return m_userNonblock; }
@@ -29,11 +32,12 @@ public:
   uint64_t getTimeout(int type);
 
 private:
-  bool init();
+  bool init(bool nonblock_socket);
 
 private:
   bool     m_isInit : 1;
   bool     m_isSocket : 1;
+  bool     m_isFile : 1;  // 普通文件
   bool     m_sysNonblock : 1;
   bool     m_userNonblock : 1;
   bool     m_isClosed : 1;
@@ -44,11 +48,11 @@ private:
 
 class FdManager {
 public:
-  typedef RWMutex LockType;
+  typedef ShardedRWMutex LockType;
 
   FdManager();
 
-  FdCtx::ptr get(int fd, bool auto_create = false);
+  FdCtx::ptr get(int fd, bool auto_create = false, bool nonblock_socket = false);
 
   void del(int fd);
 
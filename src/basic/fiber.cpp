@@ -17,12 +17,19 @@ namespace Basic {
 static std::atomic<uint64_t> s_fiber_id{0};
 static std::atomic<uint64_t> s_fiber_count{0};
 
-static thread_local Fiber*     t_fiber       = nullptr;  // 线程内部正在运行的协程
 static thread_local Fiber::ptr t_threadFiber = nullptr;  // 线程内部的调度协程
 
 static ConfigVar<uint32_t>::ptr g_fiber_static_siez =
     Config::Lookup<uint32_t>("fiber.stack_size", 1024 * 1024, "协程栈大小");
 
+static ConfigVar<uint32_t>::ptr g_fiber_run_budget =
+    Config::Lookup<uint32_t>("fiber.run_budget_ms", 10, "MaybeYield 让出前协程可连续运行的时间");
+
+static thread_local uint32_t t_yield_counter = 0;
+
+static std::atomic<size_t> s_local_count{0};
+static void (*s_local_dtors[Fiber::kMaxLocals])(void*);
+
 Fiber::Fiber() {
   m_state = EXEC;
 
@@ -55,6 +62,7 @@ Fiber::Fiber(std::function<void()> cb, size_t stacksize, bool use_caller)
 
 Fiber::~Fiber() {
   --s_fiber_count;
+  clearLocals();
   if (m_stack) {
     ASSERT2(m_state == TERM || m_state == INIT || m_state == EXCEPT,
             "State=" + std::string(Fiber::to_string(this->getState())));
@@ -73,6 +81,7 @@ Fiber::~Fiber() {
 void Fiber::reset(std::function<void()> cb) {
   ASSERT(m_stack);
   ASSERT(m_state == TERM || m_state == EXCEPT || m_state == INIT);
+  clearLocals();
   m_cb = cb;
   if (getcontext(&m_ctx)) { ASSERT2(false, "getcontext"); }
 
@@ -135,10 +144,43 @@ void Fiber::Yield2Ready() {
 void Fiber::Yield2Hold() {
   Fiber::ptr cur = GetThis();
   ASSERT(cur->m_state == EXEC);
-  cur->m_state = HOLD;
+  // 保持EXEC直到上下文保存完毕, 由Scheduler::run置为HOLD;
+  // 其它线程在切出前唤醒(schedule)该协程时, 调度器会跳过EXEC状态的协程, 不会提前切入
   cur->swapOut();
 }
 
+bool Fiber::MaybeYield() {
+  if ((++t_yield_counter & 63) != 0) { return false; }
+  Fiber* cur = t_fiber;
+  if (!cur || !cur->m_stack || !Scheduler::GetThis() || cur == Scheduler::GetMainFiber()) {
+    return false;
+  }
+  if (Scheduler::GetTaskRunMs() < g_fiber_run_budget->getValue()) { return false; }
+  cur->m_overBudget = true;
+  Yield2Ready();
+  return true;
+}
+
+size_t Fiber::AllocLocalSlot(void (*dtor)(void*)) {
+  size_t slot = s_local_count++;
+  ASSERT2(slot < kMaxLocals, "too many FiberLocal, max=" + std::to_string(kMaxLocals));
+  s_local_dtors[slot] = dtor;
+  return slot;
+}
+
+void Fiber::destroyLocal(size_t slot) {
+  if (!hasLocal(slot)) { return; }
+  m_localMask &= ~(1u << slot);
+  if (s_local_dtors[slot]) { s_local_dtors[slot](&m_locals[slot]); }
+}
+
+void Fiber::clearLocals() {
+  // 析构函数中可能再次访问其它 FiberLocal, 逐个取出直到清空
+  while (m_localMask) {
+    destroyLocal(__builtin_ctz(m_localMask));
+  }
+}
+
 uint64_t Fiber::TotalFibers() {
   return s_fiber_count;
 }
@@ -164,6 +206,7 @@ void Fiber::MainFunc() {
     cur->m_state = EXCEPT;
     LOG_ERROR("Fiber Except: %s, fiber_id=%d\n", cur->getId(), backtrace2string().c_str());
   }
+  cur->clearLocals();
 
   auto raw_ptr = cur.get();
   cur.reset();
@@ -189,6 +232,7 @@ void Fiber::CallerMainFunc() {
     cur->m_state = EXCEPT;
     LOG_ERROR("Fiber Except: %s, fiber_id=%d\n", cur->getId(), backtrace2string().c_str());
   }
+  cur->clearLocals();
 
   auto raw_ptr = cur.get();
   cur.reset();
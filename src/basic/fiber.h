@@ -39,12 +39,37 @@ public:
   uint64_t getId() const { return m_id; }
   State    getState() const { return m_state; }
 
+  /// 协程局部变量槽位数上限
+  static constexpr size_t kMaxLocals = 32;
+
+  /**
+   * @brief 分配协程局部变量槽位, 供 FiberLocal 使用
+   * @param[in] dtor 销毁槽位中的值, 为nullptr时不需要销毁
+   */
+  static size_t AllocLocalSlot(void (*dtor)(void*));
+
+  /// 槽位存储, 大小为一个指针
+  void* localData(size_t slot) { return &m_locals[slot]; }
+  bool  hasLocal(size_t slot) const { return m_localMask & (1u << slot); }
+  void  markLocal(size_t slot) { m_localMask |= 1u << slot; }
+  /// 销毁槽位中的值
+  void  destroyLocal(size_t slot);
+
 public:
   static void       SetThis(Fiber* f);
   static Fiber::ptr GetThis();
+  /// 当前正在运行的协程, 线程还没有主协程时返回nullptr
+  static Fiber*     Current() { return t_fiber; }
 
   static void     Yield2Ready();
   static void     Yield2Hold();
+  /**
+   * @brief 让出点, 供长时间计算的代码周期性调用
+   * @details 每 64 次调用检查一次当前任务的连续运行时间, 超过 fiber.run_budget_ms 时让出(READY);
+   *          所在调度器设置了cpu池时, 协程被转移到cpu池继续执行. 不在调度器协程中时什么也不做
+   * @return 是否让出过
+   */
+  static bool     MaybeYield();
   static uint64_t TotalFibers();
   static uint64_t GetFiberId();
 
@@ -54,16 +79,25 @@ public:
 private:
   Fiber();
 
+  /// 销毁所有协程局部变量, 在协程结束/reset/析构时调用
+  void clearLocals();
+
 private:
   uint64_t m_id = 0;
 
-  uint32_t m_stacksize = 0;
-  State    m_state     = INIT;
+  uint32_t m_stacksize  = 0;
+  State    m_state      = INIT;
+  bool     m_overBudget = false;  // 因超出运行预算而让出
 
   ucontext_t m_ctx;
   void*      m_stack = nullptr;
 
   std::function<void()> m_cb;
+
+  void*    m_locals[kMaxLocals];  // 协程局部变量, 按 m_localMask 判断是否已构造
+  uint32_t m_localMask = 0;
+
+  inline static thread_local Fiber* t_fiber = nullptr;  // 线程内部正在运行的协程
 };
 
 }  // namespace Basic
\ No newline at end of file
@@ -0,0 +1,73 @@
+/**
+ * 协程局部变量
+ * 协程会在调度器线程之间迁移, thread_local 不能保存请求上下文(trace id, 分配器, deadline 等).
+ * FiberLocal 在构造时分配槽位, 值保存在 Fiber 对象内的槽位数组中, 访问只需一次下标读取;
+ * 值在协程结束(TERM/EXCEPT), reset 或析构时销毁, 调度器复用的协程继续使用同一块槽位存储
+ */
+#pragma once
+
+#include <new>
+#include <type_traits>
+
+#include "basic/fiber.h"
+#include "basic/noncopyable.h"
+
+namespace Basic {
+
+/**
+ * @brief 协程局部变量, 一般定义为静态变量
+ * @details 不超过一个指针大小且可平凡析构的类型直接存放在槽位中, 其它类型在首次访问时 new
+ *          出来并在槽位中保存指针. 槽位数量上限为 Fiber::kMaxLocals, 不会回收.
+ *          在没有运行协程的线程中访问时使用线程的主协程
+ */
+template <class T>
+class FiberLocal : NonCopyable {
+public:
+  static constexpr bool kInline = sizeof(T) <= sizeof(void*) && alignof(T) <= alignof(void*) &&
+                                  std::is_trivially_destructible<T>::value;
+
+  FiberLocal() : m_slot(Fiber::AllocLocalSlot(kInline ? nullptr : &FiberLocal::Destroy)) {}
+
+  /// 返回当前协程中的值, 不存在时默认构造
+  T& get() {
+    Fiber* fiber = current();
+    void*  data  = fiber->localData(m_slot);
+    if (!fiber->hasLocal(m_slot)) {
+      if constexpr (kInline) {
+        new (data) T();
+      } else {
+        *static_cast<T**>(data) = new T();
+      }
+      fiber->markLocal(m_slot);
+    }
+    if constexpr (kInline) {
+      return *std::launder(static_cast<T*>(data));
+    } else {
+      return **static_cast<T**>(data);
+    }
+  }
+
+  void set(T v) { get() = std::move(v); }
+
+  /// 当前协程中是否已经有值
+  bool has() const { return current()->hasLocal(m_slot); }
+
+  /// 销毁当前协程中的值
+  void reset() { current()->destroyLocal(m_slot); }
+
+  T& operator*() { return get(); }
+  T* operator->() { return &get(); }
+
+private:
+  static Fiber* current() {
+    Fiber* fiber = Fiber::Current();
+    return fiber ? fiber : Fiber::GetThis().get();
+  }
+
+  static void Destroy(void* data) { delete *static_cast<T**>(data); }
+
+private:
+  size_t m_slot;
+};
+
+}  // namespace Basic
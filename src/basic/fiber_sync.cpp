@@ -0,0 +1,201 @@
+#include "basic/fiber_sync.h"
+
+#include <algorithm>
+
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+
+namespace Basic {
+
+bool FiberWaitQueue::Waiter::notify() {
+  int expect = WAITING;
+  if (!state.compare_exchange_strong(expect, NOTIFIED)) { return false; }
+  resume();
+  return true;
+}
+
+void FiberWaitQueue::Waiter::resume() {
+  if (scheduler) {
+    scheduler->schedule(fiber);
+  } else {
+    sem.notify();
+  }
+}
+
+bool FiberWaitQueue::wait(SpinLock::Lock& lock, uint64_t timeout_ms) {
+  Waiter::ptr waiter(new Waiter);
+  waiter->queue = this;
+  IOManager* iom      = IOManager::GetThis();
+  bool       in_fiber = Scheduler::GetThis() && (timeout_ms == (uint64_t)-1 || iom);
+  if (in_fiber) {
+    waiter->scheduler = Scheduler::GetThis();
+    waiter->fiber     = Fiber::GetThis();
+  }
+  m_waiters.push_back(waiter);
+
+  if (!in_fiber) {
+    lock.unlock();
+    if (timeout_ms == (uint64_t)-1) {
+      waiter->sem.wait();
+      return true;
+    }
+    if (waiter->sem.waitFor(timeout_ms)) { return true; }
+    int expect = Waiter::WAITING;
+    if (waiter->state.compare_exchange_strong(expect, Waiter::TIMEOUT)) {
+      erase(waiter);
+      return false;
+    }
+    // 超时的同时被唤醒, 消耗掉对应的notify
+    waiter->sem.wait();
+    return true;
+  }
+
+  Timer::ptr timer;
+  if (timeout_ms != (uint64_t)-1) {
+    std::weak_ptr<Waiter> wwaiter(waiter);
+    timer = iom->addConditionTimer(
+        timeout_ms,
+        [wwaiter]() {
+          auto w = wwaiter.lock();
+          if (!w) { return; }
+          int expect = Waiter::WAITING;
+          if (!w->state.compare_exchange_strong(expect, Waiter::TIMEOUT)) { return; }
+          w->queue->erase(w);
+          w->resume();
+        },
+        wwaiter);
+  }
+  lock.unlock();
+  Fiber::Yield2Hold();
+  if (timer) { timer->cancel(); }
+  return waiter->state == Waiter::NOTIFIED;
+}
+
+FiberWaitQueue::Waiter::ptr FiberWaitQueue::pop() {
+  if (m_waiters.empty()) { return nullptr; }
+  Waiter::ptr waiter = m_waiters.front();
+  m_waiters.pop_front();
+  return waiter;
+}
+
+void FiberWaitQueue::erase(Waiter::ptr waiter) {
+  SpinLock::Lock lock(m_mutex);
+  auto           it = std::find(m_waiters.begin(), m_waiters.end(), waiter);
+  if (it != m_waiters.end()) { m_waiters.erase(it); }
+}
+
+bool FiberMutex::tryLock() {
+  int expect = 0;
+  return m_state.compare_exchange_strong(expect, 1, std::memory_order_acquire);
+}
+
+void FiberMutex::lock() {
+  if (tryLock()) { return; }
+  SpinLock::Lock lock(m_queue.getMutex());
+  if (m_state.exchange(2, std::memory_order_acquire) == 0) { return; }
+  // 被唤醒时锁已经由unlock移交过来
+  m_queue.wait(lock);
+}
+
+void FiberMutex::unlock() {
+  int expect = 1;
+  if (m_state.compare_exchange_strong(expect, 0, std::memory_order_release)) { return; }
+  SpinLock::Lock lock(m_queue.getMutex());
+  auto           waiter = m_queue.pop();
+  if (!waiter) {
+    m_state.store(0, std::memory_order_release);
+    return;
+  }
+  lock.unlock();
+  bool notified = waiter->notify();
+  ASSERT(notified);
+}
+
+void FiberCondition::notifyOne() {
+  while (true) {
+    SpinLock::Lock lock(m_queue.getMutex());
+    auto           waiter = m_queue.pop();
+    lock.unlock();
+    // 跳过同时超时的等待者
+    if (!waiter || waiter->notify()) { return; }
+  }
+}
+
+void FiberCondition::notifyAll() {
+  std::vector<FiberWaitQueue::Waiter::ptr> waiters;
+  {
+    SpinLock::Lock lock(m_queue.getMutex());
+    while (auto waiter = m_queue.pop()) {
+      waiters.push_back(waiter);
+    }
+  }
+  for (auto& i : waiters) {
+    i->notify();
+  }
+}
+
+bool FiberSemaphore::tryWait() {
+  int64_t count = m_count.load();
+  while (count > 0) {
+    if (m_count.compare_exchange_weak(count, count - 1)) { return true; }
+  }
+  return false;
+}
+
+bool FiberSemaphore::waitFor(uint64_t timeout_ms) {
+  if (tryWait()) { return true; }
+  SpinLock::Lock lock(m_queue.getMutex());
+  // 先登记再检查计数, 与notify的先加计数再检查等待者配合, 不会丢失唤醒
+  ++m_waiting;
+  if (tryWait()) {
+    --m_waiting;
+    return true;
+  }
+  bool rt = m_queue.wait(lock, timeout_ms);
+  --m_waiting;
+  return rt;
+}
+
+void FiberSemaphore::notify(uint32_t n) {
+  m_count += n;
+  if (m_waiting == 0) { return; }
+
+  std::vector<FiberWaitQueue::Waiter::ptr> waiters;
+  {
+    SpinLock::Lock lock(m_queue.getMutex());
+    while (!m_queue.empty() && tryWait()) {
+      waiters.push_back(m_queue.pop());
+    }
+  }
+  for (auto& i : waiters) {
+    // 等待者已超时, 计数还回去
+    if (!i->notify()) { notify(1); }
+  }
+}
+
+void WaitGroup::add(int64_t n) {
+  int64_t count = m_count += n;
+  ASSERT2(count >= 0, "WaitGroup count=" << count);
+  if (count != 0) { return; }
+
+  std::vector<FiberWaitQueue::Waiter::ptr> waiters;
+  {
+    SpinLock::Lock lock(m_queue.getMutex());
+    while (auto waiter = m_queue.pop()) {
+      waiters.push_back(waiter);
+    }
+  }
+  for (auto& i : waiters) {
+    i->notify();
+  }
+}
+
+bool WaitGroup::waitFor(uint64_t timeout_ms) {
+  if (m_count == 0) { return true; }
+  SpinLock::Lock lock(m_queue.getMutex());
+  if (m_count == 0) { return true; }
+  return m_queue.wait(lock, timeout_ms);
+}
+
+}  // namespace Basic
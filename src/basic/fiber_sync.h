@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+
+#include "basic/fiber.h"
+#include "basic/mutex.h"
+#include "basic/noncopyable.h"
+#include "basic/scheduler.h"
+
+namespace Basic {
+
+/**
+ * @brief 协程等待队列
+ * @details 在协程中等待时挂起当前协程, 唤醒时通过 Scheduler::schedule 恢复;
+ *          不在调度器中(或需要超时但不在IOManager中)时退化为阻塞线程的信号量.
+ *          队列由 getMutex() 保护, wait/pop 需要持有该锁
+ */
+class FiberWaitQueue : NonCopyable {
+public:
+  struct Waiter {
+    typedef std::shared_ptr<Waiter> ptr;
+    enum State { WAITING, NOTIFIED, TIMEOUT };
+
+    Scheduler*       scheduler = nullptr;
+    Fiber::ptr       fiber;
+    Semaphore        sem;
+    std::atomic<int> state = {WAITING};
+    FiberWaitQueue*  queue = nullptr;
+
+    /// 状态从WAITING切换成功后恢复等待者, 与超时竞争失败返回false
+    bool notify();
+    void resume();
+  };
+
+  SpinLock& getMutex() { return m_mutex; }
+
+  /**
+   * @brief 挂起直到被唤醒或超时
+   * @param[in] lock 持有的 getMutex() 锁, 挂起前释放, 返回时仍是释放状态
+   * @return 超时返回false
+   */
+  bool wait(SpinLock::Lock& lock, uint64_t timeout_ms = -1);
+
+  /// 取出一个等待者, 需在释放锁后调用其 notify
+  Waiter::ptr pop();
+
+  bool empty() const { return m_waiters.empty(); }
+
+private:
+  void erase(Waiter::ptr waiter);
+
+private:
+  SpinLock               m_mutex;
+  std::list<Waiter::ptr> m_waiters;
+};
+
+/**
+ * @brief 协程互斥锁
+ * @details 无竞争时只有一次CAS; 竞争时挂起协程, unlock 直接把锁交给队首的等待者
+ */
+class FiberMutex : NonCopyable {
+public:
+  typedef ScopedLock<FiberMutex> Lock;
+
+  void lock();
+  bool tryLock();
+  void unlock();
+
+private:
+  /// 0: 未加锁, 1: 加锁无等待者, 2: 加锁且可能有等待者(只在持有队列锁时变化)
+  std::atomic<int> m_state = {0};
+  FiberWaitQueue   m_queue;
+};
+
+/**
+ * @brief 协程条件变量, 可与任意提供 lock/unlock 的局部锁配合
+ */
+class FiberCondition : NonCopyable {
+public:
+  template <class LockType>
+  void wait(LockType& lock) {
+    waitFor(lock, -1);
+  }
+
+  /**
+   * @brief 释放lock并挂起, 被唤醒或超时后重新加锁
+   * @return 超时返回false
+   */
+  template <class LockType>
+  bool waitFor(LockType& lock, uint64_t timeout_ms) {
+    SpinLock::Lock qlock(m_queue.getMutex());
+    lock.unlock();
+    bool rt = m_queue.wait(qlock, timeout_ms);
+    lock.lock();
+    return rt;
+  }
+
+  void notifyOne();
+  void notifyAll();
+
+private:
+  FiberWaitQueue m_queue;
+};
+
+/**
+ * @brief 协程信号量
+ * @details 有可用计数时 wait 只做CAS; 没有等待者时 notify 只做原子加
+ */
+class FiberSemaphore : NonCopyable {
+public:
+  FiberSemaphore(uint32_t count = 0) : m_count(count) {}
+
+  void wait() { waitFor(-1); }
+  /// 超时返回false
+  bool waitFor(uint64_t timeout_ms);
+  bool tryWait();
+  void notify(uint32_t n = 1);
+
+  uint32_t getCount() const { return m_count; }
+
+private:
+  std::atomic<int64_t>  m_count;
+  std::atomic<uint32_t> m_waiting = {0};
+  FiberWaitQueue        m_queue;
+};
+
+/**
+ * @brief 等待一组任务完成, 类似 Go 的 sync.WaitGroup
+ */
+class WaitGroup : NonCopyable {
+public:
+  void add(int64_t n = 1);
+  void done() { add(-1); }
+
+  void wait() { waitFor(-1); }
+  /// 超时返回false
+  bool waitFor(uint64_t timeout_ms);
+
+  int64_t getCount() const { return m_count; }
+
+private:
+  std::atomic<int64_t> m_count = {0};
+  FiberWaitQueue       m_queue;
+};
+
+}  // namespace Basic
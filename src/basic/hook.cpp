@@ -4,11 +4,14 @@
 #include <stdarg.h>
 #include <unistd.h>
 
+#include "basic/blocking.h"
+#include "basic/cancel.h"
 #include "basic/config.h"
 #include "basic/fd_manager.h"
 #include "basic/fiber.h"
 #include "basic/iomanager.h"
 #include "basic/log.h"
+#include "basic/macro.h"
 
 namespace Basic {
 
@@ -17,6 +20,9 @@ static thread_local bool t_hook_enable = false;
 static ConfigVar<int>::ptr g_tcp_connect_timeout =
     Config::Lookup("tcp.connect.timeout", 5000, "tcp连接超时时间");
 
+static ConfigVar<bool>::ptr g_hook_file_io =
+    Config::Lookup("hook.file_io", true, "协程中的文件操作交给阻塞线程池执行");
+
 #define HOOK_FUN(XX) \
   XX(sleep)          \
   XX(usleep)         \
@@ -24,21 +30,50 @@ static ConfigVar<int>::ptr g_tcp_connect_timeout =
   XX(socket)         \
   XX(connect)        \
   XX(accept)         \
+  XX(accept4)        \
   XX(read)           \
   XX(readv)          \
   XX(recv)           \
   XX(recvfrom)       \
   XX(recvmsg)        \
+  XX(recvmmsg)       \
   XX(write)          \
   XX(writev)         \
   XX(send)           \
   XX(sendto)         \
   XX(sendmsg)        \
+  XX(sendmmsg)       \
+  XX(sendfile)       \
   XX(close)          \
   XX(fcntl)          \
   XX(ioctl)          \
   XX(getsockopt)     \
-  XX(setsockopt)
+  XX(setsockopt)     \
+  XX(open)           \
+  XX(openat)         \
+  XX(stat)           \
+  XX(lstat)          \
+  XX(fsync)          \
+  XX(fdatasync)      \
+  XX(pread)          \
+  XX(pwrite)         \
+  XX(unlink)         \
+  XX(rename)
+
+#ifdef _STAT_VER
+// glibc 2.33 之前 stat/lstat 不是导出符号, 由 __xstat/__lxstat 实现
+typedef int (*xstat_fun)(int ver, const char* pathname, struct stat* statbuf);
+static xstat_fun s_xstat_f  = nullptr;
+static xstat_fun s_lxstat_f = nullptr;
+
+static int xstat(const char* pathname, struct stat* statbuf) {
+  return s_xstat_f(_STAT_VER, pathname, statbuf);
+}
+
+static int lxstat(const char* pathname, struct stat* statbuf) {
+  return s_lxstat_f(_STAT_VER, pathname, statbuf);
+}
+#endif
 
 void hook_init() {
   static bool is_inited = false;
@@ -46,6 +81,11 @@ void hook_init() {
 #define XX(name) name##_f = (name##_fun)dlsym(RTLD_NEXT, #name);
   HOOK_FUN(XX);
 #undef XX
+#ifdef _STAT_VER
+  if (!stat_f && (s_xstat_f = (xstat_fun)dlsym(RTLD_NEXT, "__xstat"))) { stat_f = xstat; }
+  if (!lstat_f && (s_lxstat_f = (xstat_fun)dlsym(RTLD_NEXT, "__lxstat"))) { lstat_f = lxstat; }
+#endif
+  ASSERT2(stat_f && lstat_f, "stat/lstat not found in libc");
 }
 
 static uint64_t s_connect_timeout = -1;
@@ -77,6 +117,29 @@ struct timer_info {
   int cancelled = 0;
 };
 
+// 在阻塞线程池中执行文件操作, errno 带回调用方
+template <typename OriginFun, typename... Args>
+static auto do_file(OriginFun& fun, Args... args) -> decltype(fun(args...)) {
+  // 文件操作可能在 s_hook_initer 构造之前的静态初始化中被调用
+  if (!fun) { Basic::hook_init(); }
+  if (!Basic::t_hook_enable || !Basic::g_hook_file_io->getValue() ||
+      !Basic::Blocking::CanSuspend()) {
+    return fun(args...);
+  }
+  if (int error = Basic::CancelToken::Check()) {
+    errno = error;
+    return -1;
+  }
+  int  error = 0;
+  auto rt    = Basic::Blocking::run([&]() {
+    auto n = fun(args...);
+    error  = errno;
+    return n;
+  });
+  errno      = error;
+  return rt;
+}
+
 template <typename OriginFun, typename... Args>
 static ssize_t do_io(int fd, OriginFun fun, const char* hook_fun_name, uint32_t event,
                      int timeout_so, Args&&... args) {
@@ -90,6 +153,7 @@ static ssize_t do_io(int fd, OriginFun fun, const char* hook_fun_name, uint32_t
     return -1;
   }
 
+  if (ctx->isFile()) { return do_file(fun, fd, args...); }
   if (!ctx->isSocket() || ctx->getUserNonblock()) { return fun(fd, std::forward<Args>(args)...); }
 
   uint64_t                    to = ctx->getTimeout(timeout_so);
@@ -101,9 +165,22 @@ retry:
     n = fun(fd, std::forward<Args>(args)...);
   }
   if (n == -1 && errno == EAGAIN) {
-    Basic::IOManager*         iom = Basic::IOManager::GetThis();
-    Basic::Timer::ptr         timer;
-    std::weak_ptr<timer_info> winfo(tinfo);
+    Basic::IOManager*          iom = Basic::IOManager::GetThis();
+    Basic::Timer::ptr          timer;
+    std::weak_ptr<timer_info>  winfo(tinfo);
+    Basic::CancelToken::ptr    token = Basic::CancelToken::GetThis();
+    Basic::CancelToken::Waiter waiter;
+    waiter.iom   = iom;
+    waiter.fd    = fd;
+    waiter.event = (Basic::IOManager::Event)(event);
+    if (token) {
+      if (int error = token->getError()) {
+        errno = error;
+        return -1;
+      }
+      // 协程截止时间更早时由令牌的定时器负责, 不再为这次调用创建定时器
+      if (token->getRemaining() <= to) { to = -1; }
+    }
 
     if (to != (uint64_t)-1) {
       timer = iom->addConditionTimer(
@@ -123,18 +200,54 @@ retry:
       if (timer) { timer->cancel(); }
       return -1;
     } else {
+      if (ctx->isClose() || (token && !token->addWaiter(&waiter))) {
+        iom->cancelEvent(fd, (Basic::IOManager::Event)(event));
+      }
       Basic::Fiber::Yield2Hold();
+      if (token) { token->delWaiter(&waiter); }
       if (timer) { timer->cancel(); }
       if (tinfo->cancelled) {
         errno = tinfo->cancelled;
         return -1;
       }
+      if (int error = token ? token->getError() : 0) {
+        errno = error;
+        return -1;
+      }
+      if (ctx->isClose()) {
+        errno = EBADF;
+        return -1;
+      }
       goto retry;
     }
   }
 
   return n;
 }
+
+// 挂起当前协程 ms 毫秒, 被协程的令牌提前唤醒时返回错误码
+static int do_sleep(uint64_t ms) {
+  Basic::Fiber::ptr       fiber = Basic::Fiber::GetThis();
+  Basic::IOManager*       iom   = Basic::IOManager::GetThis();
+  Basic::CancelToken::ptr token = Basic::CancelToken::GetThis();
+  if (!token) {
+    iom->addTimer(ms, [iom, fiber]() { iom->schedule(fiber); });
+    Basic::Fiber::Yield2Hold();
+    return 0;
+  }
+  if (int error = token->getError()) { return error; }
+
+  std::shared_ptr<Basic::CancelToken::Waiter> waiter(new Basic::CancelToken::Waiter);
+  waiter->iom   = iom;
+  waiter->fiber = fiber;
+  Basic::Timer::ptr timer = iom->addTimer(ms, [waiter]() { waiter->resume(); });
+  if (!token->addWaiter(waiter.get())) { waiter->resume(); }
+  Basic::Fiber::Yield2Hold();
+  token->delWaiter(waiter.get());
+  timer->cancel();
+  return token->getError();
+}
+
 extern "C" {
 
 #define XX(name) name##_fun name##_f = nullptr;
@@ -143,38 +256,26 @@ HOOK_FUN(XX);
 
 unsigned int sleep(unsigned int seconds) {
   if (!Basic::t_hook_enable) { return sleep_f(seconds); }
-
-  Basic::Fiber::ptr fiber = Basic::Fiber::GetThis();
-  Basic::IOManager* iom   = Basic::IOManager::GetThis();
-  iom->addTimer(seconds * 1000,
-                std::bind((void(Basic::Scheduler::*)(Basic::Fiber::ptr, int thread)) &
-                              Basic::IOManager::schedule,
-                          iom, fiber, -1));
-  Basic::Fiber::Yield2Hold();
-  return 0;
+  return do_sleep(seconds * 1000) ? seconds : 0;
 }
 
 int usleep(useconds_t usec) {
   if (!Basic::t_hook_enable) { return usleep_f(usec); }
-  Basic::Fiber::ptr fiber = Basic::Fiber::GetThis();
-  Basic::IOManager* iom   = Basic::IOManager::GetThis();
-  iom->addTimer(usec / 1000, std::bind((void(Basic::Scheduler::*)(Basic::Fiber::ptr, int thread)) &
-                                           Basic::IOManager::schedule,
-                                       iom, fiber, -1));
-  Basic::Fiber::Yield2Hold();
+  if (int error = do_sleep(usec / 1000)) {
+    errno = error;
+    return -1;
+  }
   return 0;
 }
 
 int nanosleep(const struct timespec* req, struct timespec* rem) {
   if (!Basic::t_hook_enable) { return nanosleep_f(req, rem); }
 
-  int               timeout_ms = req->tv_sec * 1000 + req->tv_nsec / 1000 / 1000;
-  Basic::Fiber::ptr fiber      = Basic::Fiber::GetThis();
-  Basic::IOManager* iom        = Basic::IOManager::GetThis();
-  iom->addTimer(timeout_ms, std::bind((void(Basic::Scheduler::*)(Basic::Fiber::ptr, int thread)) &
-                                          Basic::IOManager::schedule,
-                                      iom, fiber, -1));
-  Basic::Fiber::Yield2Hold();
+  uint64_t timeout_ms = req->tv_sec * 1000 + req->tv_nsec / 1000 / 1000;
+  if (int error = do_sleep(timeout_ms)) {
+    errno = error;
+    return -1;
+  }
   return 0;
 }
 
@@ -210,6 +311,18 @@ int connect_with_timeout(int fd, const struct sockaddr* addr, socklen_t addrlen,
   Basic::Timer::ptr           timer;
   std::shared_ptr<timer_info> tinfo(new timer_info);
   std::weak_ptr<timer_info>   winfo(tinfo);
+  Basic::CancelToken::ptr     token = Basic::CancelToken::GetThis();
+  Basic::CancelToken::Waiter  waiter;
+  waiter.iom   = iom;
+  waiter.fd    = fd;
+  waiter.event = Basic::IOManager::WRITE;
+  if (token) {
+    if (int error = token->getError()) {
+      errno = error;
+      return -1;
+    }
+    if (token->getRemaining() <= timeout_ms) { timeout_ms = -1; }
+  }
 
   if (timeout_ms != (uint64_t)-1) {
     timer = iom->addConditionTimer(
@@ -225,12 +338,18 @@ int connect_with_timeout(int fd, const struct sockaddr* addr, socklen_t addrlen,
 
   int rt = iom->addEvent(fd, Basic::IOManager::WRITE);
   if (rt == 0) {
+    if (token && !token->addWaiter(&waiter)) { iom->cancelEvent(fd, Basic::IOManager::WRITE); }
     Basic::Fiber::Yield2Hold();
+    if (token) { token->delWaiter(&waiter); }
     if (timer) { timer->cancel(); }
     if (tinfo->cancelled) {
       errno = tinfo->cancelled;
       return -1;
     }
+    if (int error = token ? token->getError() : 0) {
+      errno = error;
+      return -1;
+    }
   } else {
     if (timer) { timer->cancel(); }
     LOG_ERROR("connect addEvent(%d, WRITE) error", fd);
@@ -257,6 +376,14 @@ int accept(int s, struct sockaddr* addr, socklen_t* addrlen) {
   return fd;
 }
 
+int accept4(int s, struct sockaddr* addr, socklen_t* addrlen, int flags) {
+  int fd =
+      do_io(s, accept4_f, "accept4", Basic::IOManager::READ, SO_RCVTIMEO, addr, addrlen, flags);
+  // SOCK_NONBLOCK 创建的fd不需要 FdCtx 再 fstat/fcntl, 在协程中仍按阻塞语义挂起
+  if (fd >= 0) { Basic::FdMgr::GetInstance()->get(fd, true, flags & SOCK_NONBLOCK); }
+  return fd;
+}
+
 ssize_t read(int fd, void* buf, size_t count) {
   return do_io(fd, read_f, "read", Basic::IOManager::READ, SO_RCVTIMEO, buf, count);
 }
@@ -279,6 +406,12 @@ ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags) {
   return do_io(sockfd, recvmsg_f, "recvmsg", Basic::IOManager::READ, SO_RCVTIMEO, msg, flags);
 }
 
+int recvmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags,
+             struct timespec* timeout) {
+  return do_io(sockfd, recvmmsg_f, "recvmmsg", Basic::IOManager::READ, SO_RCVTIMEO, msgvec, vlen,
+               flags, timeout);
+}
+
 ssize_t write(int fd, const void* buf, size_t count) {
   return do_io(fd, write_f, "write", Basic::IOManager::WRITE, SO_SNDTIMEO, buf, count);
 }
@@ -301,11 +434,23 @@ ssize_t sendmsg(int s, const struct msghdr* msg, int flags) {
   return do_io(s, sendmsg_f, "sendmsg", Basic::IOManager::WRITE, SO_SNDTIMEO, msg, flags);
 }
 
+int sendmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+  return do_io(sockfd, sendmmsg_f, "sendmmsg", Basic::IOManager::WRITE, SO_SNDTIMEO, msgvec, vlen,
+               flags);
+}
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+  return do_io(out_fd, sendfile_f, "sendfile", Basic::IOManager::WRITE, SO_SNDTIMEO, in_fd, offset,
+               count);
+}
+
 int close(int fd) {
   if (!Basic::t_hook_enable) { return close_f(fd); }
 
   Basic::FdCtx::ptr ctx = Basic::FdMgr::GetInstance()->get(fd);
   if (ctx) {
+    // 先标记关闭再唤醒等待的协程, 避免其在 close_f 之前重新注册事件后永远等待
+    ctx->setClose();
     auto iom = Basic::IOManager::GetThis();
     if (iom) { iom->cancelAll(fd); }
     Basic::FdMgr::GetInstance()->del(fd);
@@ -418,4 +563,64 @@ int setsockopt(int sockfd, int level, int optname, const void* optval, socklen_t
   }
   return setsockopt_f(sockfd, level, optname, optval, optlen);
 }
+
+int open(const char* pathname, int flags, ...) {
+  mode_t mode = 0;
+  // O_TMPFILE 包含 O_DIRECTORY 位, 要完整匹配, 否则 O_DIRECTORY 打开时会读取不存在的参数
+  if ((flags & O_CREAT) || (flags & O_TMPFILE) == O_TMPFILE) {
+    va_list va;
+    va_start(va, flags);
+    mode = va_arg(va, mode_t);
+    va_end(va);
+  }
+  int fd = do_file(open_f, pathname, flags, mode);
+  // 登记后 read/write 能识别出普通文件
+  if (fd >= 0 && Basic::t_hook_enable) { Basic::FdMgr::GetInstance()->get(fd, true); }
+  return fd;
+}
+
+int openat(int dirfd, const char* pathname, int flags, ...) {
+  mode_t mode = 0;
+  if ((flags & O_CREAT) || (flags & O_TMPFILE) == O_TMPFILE) {
+    va_list va;
+    va_start(va, flags);
+    mode = va_arg(va, mode_t);
+    va_end(va);
+  }
+  int fd = do_file(openat_f, dirfd, pathname, flags, mode);
+  if (fd >= 0 && Basic::t_hook_enable) { Basic::FdMgr::GetInstance()->get(fd, true); }
+  return fd;
+}
+
+int stat(const char* pathname, struct stat* statbuf) {
+  return do_file(stat_f, pathname, statbuf);
+}
+
+int lstat(const char* pathname, struct stat* statbuf) {
+  return do_file(lstat_f, pathname, statbuf);
+}
+
+int fsync(int fd) {
+  return do_file(fsync_f, fd);
+}
+
+int fdatasync(int fd) {
+  return do_file(fdatasync_f, fd);
+}
+
+ssize_t pread(int fd, void* buf, size_t count, off_t offset) {
+  return do_file(pread_f, fd, buf, count, offset);
+}
+
+ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) {
+  return do_file(pwrite_f, fd, buf, count, offset);
+}
+
+int unlink(const char* pathname) {
+  return do_file(unlink_f, pathname);
+}
+
+int rename(const char* oldpath, const char* newpath) {
+  return do_file(rename_f, oldpath, newpath);
+}
 }
@@ -3,7 +3,9 @@
 #include <fcntl.h>
 #include <stdint.h>
 #include <sys/ioctl.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
@@ -35,6 +37,9 @@ extern connect_fun connect_f;
 using accept_fun = int (*)(int s, struct sockaddr* addr, socklen_t* addrlen);
 extern accept_fun accept_f;
 
+using accept4_fun = int (*)(int s, struct sockaddr* addr, socklen_t* addrlen, int flags);
+extern accept4_fun accept4_f;
+
 // read
 using read_fun = ssize_t (*)(int fd, void* buf, size_t count);
 extern read_fun read_f;
@@ -52,6 +57,10 @@ extern recvfrom_fun recvfrom_f;
 using recvmsg_fun = ssize_t (*)(int sockfd, struct msghdr* msg, int flags);
 extern recvmsg_fun recvmsg_f;
 
+using recvmmsg_fun = int (*)(int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags,
+                             struct timespec* timeout);
+extern recvmmsg_fun recvmmsg_f;
+
 // write
 using write_fun = ssize_t (*)(int fd, const void* buf, size_t count);
 extern write_fun write_f;
@@ -69,6 +78,12 @@ extern sendto_fun sendto_f;
 using sendmsg_fun = ssize_t (*)(int s, const struct msghdr* msg, int flags);
 extern sendmsg_fun sendmsg_f;
 
+using sendmmsg_fun = int (*)(int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+extern sendmmsg_fun sendmmsg_f;
+
+using sendfile_fun = ssize_t (*)(int out_fd, int in_fd, off_t* offset, size_t count);
+extern sendfile_fun sendfile_f;
+
 using close_fun = int (*)(int fd);
 extern close_fun close_f;
 
@@ -86,6 +101,37 @@ using setsockopt_fun = int (*)(int sockfd, int level, int optname, const void* o
                                socklen_t optlen);
 extern setsockopt_fun setsockopt_f;
 
+// file, 在协程中交给阻塞线程池执行
+using open_fun = int (*)(const char* pathname, int flags, ...);
+extern open_fun open_f;
+
+using openat_fun = int (*)(int dirfd, const char* pathname, int flags, ...);
+extern openat_fun openat_f;
+
+using stat_fun = int (*)(const char* pathname, struct stat* statbuf);
+extern stat_fun stat_f;
+
+using lstat_fun = int (*)(const char* pathname, struct stat* statbuf);
+extern lstat_fun lstat_f;
+
+using fsync_fun = int (*)(int fd);
+extern fsync_fun fsync_f;
+
+using fdatasync_fun = int (*)(int fd);
+extern fdatasync_fun fdatasync_f;
+
+using pread_fun = ssize_t (*)(int fd, void* buf, size_t count, off_t offset);
+extern pread_fun pread_f;
+
+using pwrite_fun = ssize_t (*)(int fd, const void* buf, size_t count, off_t offset);
+extern pwrite_fun pwrite_f;
+
+using unlink_fun = int (*)(const char* pathname);
+extern unlink_fun unlink_f;
+
+using rename_fun = int (*)(const char* oldpath, const char* newpath);
+extern rename_fun rename_f;
+
 extern int connect_with_timeout(int fd, const struct sockaddr* addr, socklen_t addrlen,
                                 uint64_t timeout_ms);
 }
\ No newline at end of file
@@ -27,12 +27,19 @@ void IOManager::FdContext::resetContext(EventContext& ctx) {
   ctx.cb = nullptr;
 }
 
-void IOManager::FdContext::triggerEvent(IOManager::Event event) {
+void IOManager::FdContext::triggerEvent(IOManager::Event event, Scheduler* owner, Batch* batch) {
   LOG_INFO("fd=%d, triggerEvent event=%d, events=%d", fd, event, events);
   ASSERT(events & event);
   events            = (Event)(events & ~event);
   EventContext& ctx = getContext(event);
-  if (ctx.cb) {
+  if (batch && ctx.scheduler == owner) {
+    if (ctx.cb) {
+      batch->cbs.push_back(std::move(ctx.cb));
+      ctx.cb = nullptr;
+    } else {
+      batch->fibers.push_back(std::move(ctx.fiber));
+    }
+  } else if (ctx.cb) {
     ctx.scheduler->schedule(&ctx.cb);
   } else {
     ctx.scheduler->schedule(&ctx.fiber);
@@ -105,7 +112,7 @@ int IOManager::addEvent(int fd, Event event, std::function<void()> cb) {
   } else {
     lock.unlock();
     LockType::WriteLock lock2(m_lock);
-    contextResize(fd * 1.5);
+    if ((int)m_fdContexts.size() <= fd) { contextResize(fd * 1.5); }
     fd_ctx = m_fdContexts[fd];
   }
 
@@ -253,6 +260,8 @@ void IOManager::idle() {
   const uint64_t               MAX_EVNETS = 256;
   epoll_event*                 events     = new epoll_event[MAX_EVNETS]();
   std::shared_ptr<epoll_event> shared_events(events, [](epoll_event* ptr) { delete[] ptr; });
+  // 一轮epoll_wait就绪的协程和超时的定时器回调, 最后一次性入队
+  Batch batch;
 
   while (true) {
     uint64_t next_timeout = 0;
@@ -276,13 +285,8 @@ void IOManager::idle() {
       }
     } while (true);
 
-    std::vector<std::function<void()> > cbs;
-    listExpiredCb(cbs);
-    if (!cbs.empty()) {
-      LOG_DEBUG("on timer cbs.size=%d", cbs.size());
-      schedule(cbs.begin(), cbs.end());
-      cbs.clear();
-    }
+    listExpiredCb(batch.cbs);
+    if (!batch.cbs.empty()) { LOG_DEBUG("on timer cbs.size=%d", batch.cbs.size()); }
 
     for (int i = 0; i < rt; ++i) {
       epoll_event& event = events[i];
@@ -295,7 +299,10 @@ void IOManager::idle() {
 
       FdContext*                fd_ctx = (FdContext*)event.data.ptr;
       FdContext::LockType::Lock lock(fd_ctx->lock);
-      if (event.events & (EPOLLERR | EPOLLHUP)) { event.events |= EPOLLIN | EPOLLOUT; }
+      // 出错或挂断时唤醒已注册的读写事件, 没有注册的事件不能触发
+      if (event.events & (EPOLLERR | EPOLLHUP)) {
+        event.events |= (EPOLLIN | EPOLLOUT) & fd_ctx->events;
+      }
       int real_events = NONE;
       if (event.events & EPOLLIN) { real_events |= READ; }
       if (event.events & EPOLLOUT) { real_events |= WRITE; }
@@ -314,14 +321,15 @@ void IOManager::idle() {
       }
 
       if (real_events & READ) {
-        fd_ctx->triggerEvent(READ);
+        fd_ctx->triggerEvent(READ, this, &batch);
         --m_pendingEventCount;
       }
       if (real_events & WRITE) {
-        fd_ctx->triggerEvent(WRITE);
+        fd_ctx->triggerEvent(WRITE, this, &batch);
         --m_pendingEventCount;
       }
     }
+    scheduleBatch(batch);
 
     Fiber::ptr cur     = Fiber::GetThis();
     auto       raw_ptr = cur.get();
@@ -30,7 +30,8 @@ private:
 
     EventContext& getContext(Event event);
     void          resetContext(EventContext& ctx);
-    void          triggerEvent(Event event);
+    /// batch不为空且事件属于owner时放入batch, 由调用方统一提交
+    void          triggerEvent(Event event, Scheduler* owner = nullptr, Batch* batch = nullptr);
 
     EventContext read;           // 读事件
     EventContext write;          // 写事件
@@ -1,7 +1,12 @@
 #include "basic/mutex.h"
 
+#include <sched.h>
 #include <semaphore.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
 
+#include <cerrno>
 #include <stdexcept>
 
 namespace Basic {
@@ -17,8 +22,72 @@ void Semaphore::wait() {
   if (sem_wait(&m_sem)) { throw std::logic_error("sem_wait error"); }
 }
 
+bool Semaphore::waitFor(uint64_t timeout_ms) {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec  += timeout_ms / 1000 + (ts.tv_nsec + timeout_ms % 1000 * 1000000) / 1000000000;
+  ts.tv_nsec = (ts.tv_nsec + timeout_ms % 1000 * 1000000) % 1000000000;
+  while (sem_timedwait(&m_sem, &ts)) {
+    if (errno == ETIMEDOUT) { return false; }
+    if (errno != EINTR) { throw std::logic_error("sem_timedwait error"); }
+  }
+  return true;
+}
+
 void Semaphore::notify() {
   if (sem_post(&m_sem)) { throw std::logic_error("sem_post error"); }
 }
 
-}  // namespace Basic
\ No newline at end of file
+static thread_local int   t_shard_index = -1;
+static thread_local pid_t t_thread_id   = 0;
+
+static pid_t GetCachedThreadId() {
+  if (!t_thread_id) { t_thread_id = (pid_t)syscall(SYS_gettid); }
+  return t_thread_id;
+}
+
+ShardedRWMutex::ShardedRWMutex() {
+  long cpus = sysconf(_SC_NPROCESSORS_CONF);
+  m_shards.resize(cpus > 0 ? cpus : 1);
+  for (auto& i : m_shards) {
+    pthread_rwlock_init(&i.lock, nullptr);
+  }
+}
+
+ShardedRWMutex::~ShardedRWMutex() {
+  for (auto& i : m_shards) {
+    pthread_rwlock_destroy(&i.lock);
+  }
+}
+
+ShardedRWMutex::Shard& ShardedRWMutex::getShard() {
+  if (t_shard_index < 0) {
+    int cpu       = sched_getcpu();
+    t_shard_index = cpu >= 0 ? cpu : GetCachedThreadId();
+  }
+  return m_shards[t_shard_index % m_shards.size()];
+}
+
+void ShardedRWMutex::rdlock() {
+  pthread_rwlock_rdlock(&getShard().lock);
+}
+
+void ShardedRWMutex::wrlock() {
+  for (auto& i : m_shards) {
+    pthread_rwlock_wrlock(&i.lock);
+  }
+  m_writer.store(GetCachedThreadId(), std::memory_order_relaxed);
+}
+
+void ShardedRWMutex::unlock() {
+  if (m_writer.load(std::memory_order_relaxed) == GetCachedThreadId()) {
+    m_writer.store(0, std::memory_order_relaxed);
+    for (auto it = m_shards.rbegin(); it != m_shards.rend(); ++it) {
+      pthread_rwlock_unlock(&it->lock);
+    }
+  } else {
+    pthread_rwlock_unlock(&getShard().lock);
+  }
+}
+
+}  // namespace Basic
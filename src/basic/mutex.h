@@ -4,6 +4,7 @@
 #include <semaphore.h>
 
 #include <atomic>
+#include <vector>
 
 namespace Basic {
 
@@ -14,6 +15,9 @@ public:
 
   void wait();
 
+  /// 超时返回false
+  bool waitFor(uint64_t timeout_ms);
+
   void notify();
 
 private:
@@ -51,7 +55,6 @@ private:
 
 template <typename T>
 struct ReadScopedLock {
-public:
 public:
   ReadScopedLock(T& mutex) : m_mutex(mutex) {
     m_mutex.rdlock();
@@ -143,7 +146,7 @@ class NullMutex {
 class RWMutex {
 public:
   /// 局部读锁
-  typedef WriteScopedLock<RWMutex> ReadLock;
+  typedef ReadScopedLock<RWMutex> ReadLock;
 
   /// 局部写锁
   typedef WriteScopedLock<RWMutex> WriteLock;
@@ -159,6 +162,42 @@ private:
   pthread_rwlock_t m_lock;
 };
 
+/**
+ * @brief 按CPU分片的读写锁(big-reader lock)
+ * @details 每个分片独占一个cache line, 读锁只锁当前线程所属的分片, 读者之间不争用同一cache line;
+ *          写锁按顺序锁住全部分片, 代价随CPU数增长, 只适合读远多于写的场景.
+ *          线程第一次加读锁时按所在CPU确定分片, 之后固定不变, 保证加锁与解锁是同一分片
+ */
+class ShardedRWMutex {
+public:
+  /// 局部读锁
+  typedef ReadScopedLock<ShardedRWMutex> ReadLock;
+
+  /// 局部写锁
+  typedef WriteScopedLock<ShardedRWMutex> WriteLock;
+
+  ShardedRWMutex();
+  ~ShardedRWMutex();
+
+  void rdlock();
+  void wrlock();
+  void unlock();
+
+  size_t getShardCount() const { return m_shards.size(); }
+
+private:
+  struct alignas(64) Shard {
+    pthread_rwlock_t lock;
+  };
+
+  Shard& getShard();
+
+private:
+  std::vector<Shard> m_shards;
+  /// 持有写锁的线程id, 用于unlock区分读写
+  std::atomic<pid_t> m_writer = {0};
+};
+
 class SpinLock {
 public:
   /// 局部锁
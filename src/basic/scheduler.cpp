@@ -1,14 +1,58 @@
 #include "basic/scheduler.h"
 
+#include "basic/config.h"
 #include "basic/hook.h"
+#include "basic/iomanager.h"
 #include "basic/log.h"
 #include "basic/macro.h"
 #include "basic/utils.h"
+#include "basic/watchdog.h"
 
 namespace Basic {
 
 static thread_local Scheduler* t_scheduler       = nullptr;
 static thread_local Fiber*     t_scheduler_fiber = nullptr;
+static thread_local uint64_t   t_task_start      = 0;  // 当前任务本次开始执行的时间, 0表示没有
+
+static ConfigVar<uint32_t>::ptr g_task_pool_size =
+    Config::Lookup<uint32_t>("scheduler.task_pool_size", 4096, "每个调度器缓存的空闲任务节点数");
+
+static ConfigVar<std::map<std::string, std::string>>::ptr g_scheduler_affinity =
+    Config::Lookup("scheduler.affinity", std::map<std::string, std::string>(),
+                   "调度器线程绑核, key为调度器名称, value为cpu列表(如0-3,8)或node:N");
+
+/**
+ * @brief 计算每个工作线程绑定的cpu集合
+ * @details cpu列表: 第i个线程绑定到第 i % n 个cpu;
+ *          node:列表: 第i个线程绑定到第 i % n 个节点的全部cpu, 线程可在节点内迁移;
+ *          未配置或配置错误返回空, 不绑核
+ */
+static std::vector<std::vector<int>> GetThreadAffinity(const std::string& name, size_t threads) {
+  auto conf = g_scheduler_affinity->getSnapshot();
+  auto it   = conf->find(name);
+  if (it == conf->end() || threads == 0) { return {}; }
+
+  std::vector<std::vector<int>> rt;
+  const std::string&            value = it->second;
+  if (value.compare(0, 5, "node:") == 0) {
+    std::vector<int> nodes = parse_cpu_list(value.substr(5));
+    for (size_t i = 0; i < threads && !nodes.empty(); ++i) {
+      rt.push_back(get_numa_node_cpus(nodes[i % nodes.size()]));
+      if (rt.back().empty()) {
+        LOG_ERROR("scheduler %s affinity node=%d has no cpu", name.c_str(),
+                  nodes[i % nodes.size()]);
+        return {};
+      }
+    }
+  } else {
+    std::vector<int> cpus = parse_cpu_list(value);
+    for (size_t i = 0; i < threads && !cpus.empty(); ++i) {
+      rt.push_back({cpus[i % cpus.size()]});
+    }
+  }
+  if (rt.empty()) { LOG_ERROR("scheduler %s invalid affinity=%s", name.c_str(), value.c_str()); }
+  return rt;
+}
 
 Scheduler::Scheduler(size_t threads, const std::string& name, bool use_caller) : m_name(name) {
   ASSERT(threads > 0);
@@ -35,6 +79,64 @@ Scheduler::Scheduler(size_t threads, const std::string& name, bool use_caller) :
 Scheduler::~Scheduler() {
   ASSERT(m_stopping);
   if (GetThis() == this) { t_scheduler = nullptr; }
+  for (Task* lists : {m_taskHead, m_freeTasks}) {
+    while (lists) {
+      Task* next = lists->next;
+      delete lists;
+      lists = next;
+    }
+  }
+}
+
+Scheduler::Task* Scheduler::allocTask() {
+  if (!m_freeTasks) { return new Task; }
+  Task* task  = m_freeTasks;
+  m_freeTasks = task->next;
+  task->next  = nullptr;
+  --m_freeTaskCount;
+  return task;
+}
+
+void Scheduler::freeTask(Task* task) {
+  task->fiber.reset();
+  task->cb.reset();
+  task->thread = -1;
+  if (m_freeTaskCount >= g_task_pool_size->getValue()) {
+    delete task;
+    return;
+  }
+  task->next  = m_freeTasks;
+  m_freeTasks = task;
+  ++m_freeTaskCount;
+}
+
+bool Scheduler::pushTask(Task* task) {
+  bool need_tickle = m_taskHead == nullptr;
+  task->next       = nullptr;
+  if (m_taskTail) {
+    m_taskTail->next = task;
+  } else {
+    m_taskHead = task;
+  }
+  m_taskTail = task;
+  return need_tickle;
+}
+
+void Scheduler::scheduleBatch(Batch& batch) {
+  size_t count = batch.size();
+  if (count == 0) { return; }
+  {
+    LockType::Lock lock(m_lock);
+    for (auto& i : batch.fibers) {
+      scheduleNoLock(&i, -1);
+    }
+    for (auto& i : batch.cbs) {
+      scheduleNoLock(&i, -1);
+    }
+  }
+  batch.clear();
+  // 当前线程也计在空闲线程里
+  if (count > 1 && m_idleThreadCount > 1) { tickle(); }
 }
 
 Scheduler* Scheduler::GetThis() {
@@ -45,16 +147,31 @@ Fiber* Scheduler::GetMainFiber() {
   return t_scheduler_fiber;
 }
 
+uint64_t Scheduler::GetTaskRunMs() {
+  return t_task_start ? get_coarse_ms() - t_task_start : 0;
+}
+
+bool Scheduler::IsRunningTask() {
+  return t_task_start != 0;
+}
+
 void Scheduler::start() {
   LockType::Lock lock(m_lock);
   if (!m_stopping) { return; }
   m_stopping = false;
   ASSERT(m_threads.empty());
 
+  // 先绑核再进入run, 之后协程栈和线程内分配的内存按首次访问落在本地节点上
+  auto affinity = GetThreadAffinity(m_name, m_threadCount);
   m_threads.resize(m_threadCount);
   for (size_t i = 0; i < m_threadCount; ++i) {
-    m_threads[i].reset(
-        new Thread(std::bind(&Scheduler::run, this), m_name + "_" + std::to_string(i)));
+    std::vector<int> cpus = affinity.empty() ? std::vector<int>() : affinity[i];
+    m_threads[i].reset(new Thread(
+        [this, cpus]() {
+          if (!cpus.empty()) { set_thread_affinity(cpus); }
+          run();
+        },
+        m_name + "_" + std::to_string(i)));
     m_threadIds.push_back(m_threads[i]->getId());
   }
   lock.unlock();
@@ -116,61 +233,86 @@ void Scheduler::run() {
   Fiber::ptr idle_fiber(new Fiber(std::bind(&Scheduler::idle, this)));
   Fiber::ptr cb_fiber;
 
-  FiberAndThread ft;
+  FiberWatchdog::Slot* watchdog = FiberWatchdog::RegisterThread();
+
+  Task* task = nullptr;
   while (true) {
-    ft.reset();
     bool tickle_me = false;
     bool is_active = false;
     {
       LockType::Lock lock(m_lock);
-      auto           it = m_fibers.begin();
-      while (it != m_fibers.end()) {
+      // 上一轮执行完的节点在这里回收, 不再单独加锁
+      if (task) {
+        freeTask(task);
+        task = nullptr;
+      }
+      Task* prev = nullptr;
+      Task* it   = m_taskHead;
+      while (it) {
         if (it->thread != -1 && it->thread != get_thread_id()) {
-          ++it;
+          prev      = it;
+          it        = it->next;
           tickle_me = true;
           continue;
         }
 
         ASSERT(it->fiber || it->cb);
         if (it->fiber && it->fiber->getState() == Fiber::EXEC) {
-          ++it;
+          prev = it;
+          it   = it->next;
           continue;
         }
 
-        ft = *it;
-        m_fibers.erase(it++);
+        task = it;
+        it   = it->next;
+        if (prev) {
+          prev->next = it;
+        } else {
+          m_taskHead = it;
+        }
+        if (m_taskTail == task) { m_taskTail = prev; }
         ++m_activeThreadCount;
         is_active = true;
         break;
       }
-      tickle_me |= it != m_fibers.end();
+      tickle_me |= it != nullptr;
     }
 
     if (tickle_me) { tickle(); }
 
-    if (ft.fiber &&
-        (ft.fiber->getState() != Fiber::TERM && ft.fiber->getState() != Fiber::EXCEPT)) {
-      ft.fiber->swapIn();
+    if (task && task->fiber &&
+        (task->fiber->getState() != Fiber::TERM && task->fiber->getState() != Fiber::EXCEPT)) {
+      Fiber::ptr fiber = std::move(task->fiber);
+      beginTask(watchdog, fiber->getId());
+      fiber->swapIn();
+      endTask(watchdog);
       --m_activeThreadCount;
 
-      if (ft.fiber->getState() == Fiber::READY) {
-        schedule(ft.fiber);
-      } else if (ft.fiber->getState() != Fiber::TERM && ft.fiber->getState() != Fiber::EXCEPT) {
-        ft.fiber->m_state = Fiber::HOLD;
+      if (fiber->getState() == Fiber::READY) {
+        scheduleReady(std::move(fiber));
+      } else if (fiber->getState() != Fiber::TERM && fiber->getState() != Fiber::EXCEPT) {
+        fiber->m_state = Fiber::HOLD;
       }
-      ft.reset();
-    } else if (ft.cb) {
+    } else if (task && task->cb) {
+      // 协程开始执行时把任务函数移到自己的栈上, 节点随后即可回收, 不依赖协程是否执行完
+      TaskFunc* cb = &task->cb;
       if (cb_fiber) {
-        cb_fiber->reset(ft.cb);
+        cb_fiber->reset([cb]() {
+          TaskFunc func(std::move(*cb));
+          func();
+        });
       } else {
-        cb_fiber.reset(new Fiber(ft.cb));
+        cb_fiber.reset(new Fiber([cb]() {
+          TaskFunc func(std::move(*cb));
+          func();
+        }));
       }
-      ft.reset();
+      beginTask(watchdog, cb_fiber->getId());
       cb_fiber->swapIn();
+      endTask(watchdog);
       --m_activeThreadCount;
       if (cb_fiber->getState() == Fiber::READY) {
-        schedule(cb_fiber);
-        cb_fiber.reset();
+        scheduleReady(std::move(cb_fiber));
       } else if (cb_fiber->getState() == Fiber::EXCEPT || cb_fiber->getState() == Fiber::TERM) {
         cb_fiber->reset(nullptr);
       } else {  // if(cb_fiber->getState() != Fiber::TERM) {
@@ -195,6 +337,34 @@ void Scheduler::run() {
       }
     }
   }
+  if (task) {
+    LockType::Lock lock(m_lock);
+    freeTask(task);
+  }
+  FiberWatchdog::UnregisterThread(watchdog);
+  // use_caller 时 run 在调用线程上执行, 调度器停止后该线程不再有IOManager, 关闭hook
+  set_hook_enable(false);
+}
+
+void Scheduler::beginTask(FiberWatchdog::Slot* watchdog, uint64_t fiber_id) {
+  t_task_start = get_coarse_ms();
+  FiberWatchdog::Begin(watchdog, fiber_id, t_task_start);
+}
+
+void Scheduler::endTask(FiberWatchdog::Slot* watchdog) {
+  t_task_start = 0;
+  FiberWatchdog::End(watchdog);
+}
+
+void Scheduler::scheduleReady(Fiber::ptr&& fiber) {
+  if (fiber->m_overBudget) {
+    fiber->m_overBudget = false;
+    if (m_cpuPool && m_cpuPool != this) {
+      m_cpuPool->schedule(std::move(fiber));
+      return;
+    }
+  }
+  schedule(std::move(fiber));
 }
 
 void Scheduler::tickle() {
@@ -203,7 +373,8 @@ void Scheduler::tickle() {
 
 bool Scheduler::stopping() {
   LockType::Lock lock(m_lock);
-  return m_autoStop && m_stopping && m_fibers.empty() && m_activeThreadCount == 0;
+  return m_autoStop && m_stopping && !m_taskHead && m_activeThreadCount == 0 &&
+         m_offloadCount == 0;
 }
 
 void Scheduler::idle() {
@@ -3,15 +3,20 @@
 #include <iostream>
 #include <memory>
 #include <vector>
-#include <list>
 
 #include "basic/fiber.h"
 #include "basic/mutex.h"
+#include "basic/task.h"
 #include "basic/thread.h"
+#include "basic/watchdog.h"
 
 namespace Basic {
 
+class IOManager;
+
 class Scheduler {
+  friend class Blocking;
+
 public:
   typedef std::shared_ptr<Scheduler> ptr;
   typedef Mutex                      LockType;
@@ -20,15 +25,31 @@ public:
   virtual ~Scheduler();
 
   const std::string& getName() const { return m_name; }
+  /// 执行任务的线程数, 包括 use_caller 的线程
+  size_t getThreadCount() const { return m_threadCount + (m_rootThread == -1 ? 0 : 1); }
+  /// 执行任务的线程id, 包括 use_caller 的线程, 可作为 schedule 的 thread 参数
+  const std::vector<int>& getThreadIds() const { return m_threadIds; }
 
 public:
   static Scheduler* GetThis();
   void              setThis();
   static Fiber*     GetMainFiber();
+  /// 当前线程正在执行的任务本次已连续运行的时间(ms), 不在执行任务时返回0
+  static uint64_t   GetTaskRunMs();
+  /// 当前线程是否正在执行调度器中的任务(而不是调度协程或idle)
+  static bool       IsRunningTask();
 
+  /// 启动工作线程, 按配置 scheduler.affinity 中本调度器名称对应的项绑核
   void start();
   void stop();
 
+  /**
+   * @brief 设置cpu池, 本调度器中调用 Fiber::MaybeYield 超出运行预算的协程转移到cpu池执行,
+   *        避免长时间计算占住IO线程
+   * @details 转移后的协程仍会调用hook的IO函数, cpu池必须是 IOManager
+   */
+  void setCpuPool(IOManager* pool) { m_cpuPool = pool; }
+
   void switchTo(int thread);
   std::ostream& dump(std::ostream& os = std::cout);
 
@@ -40,66 +61,118 @@ protected:
   bool         hasIdleThreads() { return m_idleThreadCount > 0; }
 
 public:
+  /**
+   * @brief 添加任务
+   * @param[in] fc Fiber::ptr, Fiber::ptr*, std::function<void()>* (取走其内容) 或任意可调用对象,
+   *               可调用对象可以只能移动
+   * @param[in] thread 指定执行的线程id, -1为任意线程
+   */
   template <typename FiberOrCb>
-  void schedule(FiberOrCb fc, int thread = -1) {
+  void schedule(FiberOrCb&& fc, int thread = -1) {
     bool need_tickle = false;
     {
       LockType::Lock lock(m_lock);
-      need_tickle = scheduleNoLock(fc, thread);
+      need_tickle = scheduleNoLock(std::forward<FiberOrCb>(fc), thread);
     }
 
     if (need_tickle) { tickle(); }
   }
 
+  /**
+   * @brief 批量添加任务, 只加一次锁, 最多唤醒一次
+   * @details 元素按 *begin 的值类别拷贝或移动, 需要移走元素时传入 std::make_move_iterator
+   */
   template <typename InputIterator>
   void schedule(InputIterator begin, InputIterator end) {
     bool need_tickle = false;
     {
       LockType::Lock lock(m_lock);
       while (begin != end) {
-        need_tickle = scheduleNoLock(&*begin, -1) || need_tickle;
+        need_tickle = scheduleNoLock(*begin, -1) || need_tickle;
         ++begin;
       }
     }
     if (need_tickle) { tickle(); }
   }
 
+protected:
+  /// 一轮事件循环中收集的待执行任务
+  struct Batch {
+    std::vector<Fiber::ptr>            fibers;
+    std::vector<std::function<void()>> cbs;
+
+    size_t size() const { return fibers.size() + cbs.size(); }
+    void   clear() {
+      fibers.clear();
+      cbs.clear();
+    }
+  };
+
+  /**
+   * @brief 由idle协程提交一批任务, 提交后batch被清空(保留容量)
+   * @details 一次加锁入队; 当前线程切回run后会取走一个任务,
+   *          只有多于一个任务且还有其它空闲线程时才唤醒一次
+   */
+  void scheduleBatch(Batch& batch);
+
 private:
+  /// 任务队列节点, 执行完后回收到空闲链表复用
+  struct Task {
+    Task*      next = nullptr;
+    Fiber::ptr fiber;
+    TaskFunc   cb;
+    int        thread = -1;
+  };
+
   template <typename FiberOrCb>
-  bool scheduleNoLock(FiberOrCb fc, int thread) {
-    bool           need_tickle = m_fibers.empty();
-    FiberAndThread ft(fc, thread);
-    if (ft.fiber || ft.cb) { m_fibers.push_back(ft); }
-    return need_tickle;
+  bool scheduleNoLock(FiberOrCb&& fc, int thread) {
+    Task* task = allocTask();
+    if (!SetTask(task, std::forward<FiberOrCb>(fc))) {
+      freeTask(task);
+      return false;
+    }
+    task->thread = thread;
+    return pushTask(task);
   }
 
-  struct FiberAndThread {
-    Fiber::ptr            fiber;
-    std::function<void()> cb;
-    int                   thread;
-
-    FiberAndThread(Fiber::ptr f, int thr) : fiber(f), thread(thr) {}
+  static bool SetTask(Task* task, Fiber::ptr fiber) {
+    task->fiber = std::move(fiber);
+    return task->fiber != nullptr;
+  }
 
-    FiberAndThread(Fiber::ptr* f, int thr) : thread(thr) { fiber.swap(*f); }
+  static bool SetTask(Task* task, Fiber::ptr* fiber) {
+    task->fiber.swap(*fiber);
+    return task->fiber != nullptr;
+  }
 
-    FiberAndThread(std::function<void()> f, int thr) : cb(f), thread(thr) {}
+  static bool SetTask(Task* task, std::function<void()>* cb) {
+    task->cb.assign(std::move(*cb));
+    *cb = nullptr;
+    return (bool)task->cb;
+  }
 
-    FiberAndThread(std::function<void()>* f, int thr) : thread(thr) { cb.swap(*f); }
+  template <typename Cb>
+  static bool SetTask(Task* task, Cb&& cb) {
+    task->cb.assign(std::forward<Cb>(cb));
+    return (bool)task->cb;
+  }
 
-    FiberAndThread() : thread(-1) {}
+  void beginTask(FiberWatchdog::Slot* watchdog, uint64_t fiber_id);
+  void endTask(FiberWatchdog::Slot* watchdog);
+  /// 重新调度让出的READY协程
+  void scheduleReady(Fiber::ptr&& fiber);
 
-    void reset() {
-      fiber  = nullptr;
-      cb     = nullptr;
-      thread = -1;
-    }
-  };
+  /// 以下需持有m_lock
+  Task* allocTask();
+  void  freeTask(Task* task);
+  bool  pushTask(Task* task);
 
 protected:
   std::vector<int>    m_threadIds;
   size_t              m_threadCount = 0;
   std::atomic<size_t> m_activeThreadCount{0};
   std::atomic<size_t> m_idleThreadCount{0};
+  std::atomic<size_t> m_offloadCount{0};  // 在 Blocking 线程池中执行, 等待被唤醒的协程数
 
   bool m_stopping   = true;
   bool m_autoStop   = false;
@@ -109,9 +182,16 @@ private:
   LockType    m_lock;
   std::string m_name;
 
-  Fiber::ptr                  m_rootFiber;
-  std::vector<Thread::ptr>    m_threads;
-  std::list<FiberAndThread> m_fibers;
+  Fiber::ptr               m_rootFiber;
+  std::vector<Thread::ptr> m_threads;
+  IOManager*               m_cpuPool = nullptr;
+
+  /// 待执行任务链表
+  Task* m_taskHead = nullptr;
+  Task* m_taskTail = nullptr;
+  /// 空闲任务节点链表
+  Task*  m_freeTasks     = nullptr;
+  size_t m_freeTaskCount = 0;
 };
 
 }  // namespace Basic
\ No newline at end of file
@@ -3,12 +3,16 @@
 #include <arpa/inet.h>
 #include <limits.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "basic/address.h"
+#include "basic/config.h"
 #include "basic/fd_manager.h"
 #include "basic/hook.h"
 #include "basic/iomanager.h"
@@ -63,6 +67,36 @@ Socket::ptr Socket::CreateUnixUDPSocket() {
   return sock;
 }
 
+std::pair<Socket::ptr, Socket::ptr> Socket::CreateUnixPair(int type) {
+  int fds[2];
+  if (socketpair(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds)) {
+    LOG_ERROR_STREAM << "socketpair(" << type << ") errno=" << errno << " errstr=" << strerror(errno);
+    return std::make_pair(nullptr, nullptr);
+  }
+  Socket::ptr socks[2];
+  for (int i = 0; i < 2; ++i) {
+    FdMgr::GetInstance()->get(fds[i], true, true);
+    socks[i].reset(new Socket(UNIX, type, 0));
+    socks[i]->init(fds[i]);
+  }
+  return std::make_pair(socks[0], socks[1]);
+}
+
+Socket::ptr Socket::Attach(int fd) {
+  int       family = 0;
+  int       type   = 0;
+  socklen_t len    = sizeof(int);
+  if (getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &family, &len) ||
+      getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len)) {
+    LOG_ERROR_STREAM << "Attach(" << fd << ") errno=" << errno << " errstr=" << strerror(errno);
+    return nullptr;
+  }
+  FdMgr::GetInstance()->get(fd, true);
+  Socket::ptr sock(new Socket(family, type, 0));
+  if (sock->init(fd)) { return sock; }
+  return nullptr;
+}
+
 Socket::Socket(int family, int type, int protocol)
     : m_sock(-1), m_family(family), m_type(type), m_protocol(protocol), m_isConnected(false) {}
 
@@ -115,13 +149,44 @@ bool Socket::setOption(int level, int option, const void* result, size_t len) {
   return true;
 }
 
-Socket::ptr Socket::accept() {
-  Socket::ptr sock(new Socket(m_family, m_type, m_protocol));
-  int         newsock = ::accept(m_sock, nullptr, nullptr);
+bool Socket::applyOptions(const SocketOptions& opts, bool listener) {
+  bool rt = true;
+  if (opts.rcvbuf > 0) { rt &= setOption(SOL_SOCKET, SO_RCVBUF, opts.rcvbuf); }
+  if (opts.sndbuf > 0) { rt &= setOption(SOL_SOCKET, SO_SNDBUF, opts.sndbuf); }
+  if (opts.busy_poll > 0) { rt &= setOption(SOL_SOCKET, SO_BUSY_POLL, opts.busy_poll); }
+  if (m_type != SOCK_STREAM || m_family == AF_UNIX) { return rt; }
+
+  rt &= setOption(IPPROTO_TCP, TCP_NODELAY, (int)opts.tcp_nodelay);
+  if (opts.tcp_quickack) { rt &= setOption(IPPROTO_TCP, TCP_QUICKACK, 1); }
+  if (opts.notsent_lowat > 0) {
+    rt &= setOption(IPPROTO_TCP, TCP_NOTSENT_LOWAT, opts.notsent_lowat);
+  }
+  if (listener && opts.defer_accept > 0) {
+    rt &= setOption(IPPROTO_TCP, TCP_DEFER_ACCEPT, opts.defer_accept);
+  }
+  if (listener && opts.fastopen > 0) { rt &= setOption(IPPROTO_TCP, TCP_FASTOPEN, opts.fastopen); }
+  return rt;
+}
+
+int Socket::acceptFd(Address::ptr& remote) {
+  sockaddr_storage addr;
+  socklen_t        addrlen = sizeof(addr);
+  int newsock = ::accept4(m_sock, (sockaddr*)&addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
   if (newsock == -1) {
     LOG_ERROR_STREAM << "accept(" << m_sock << ") errno=" << errno << " errstr=" << strerror(errno);
-    return nullptr;
+    return -1;
+  }
+  // unix socket 的地址长度需要单独处理, 仍由 getRemoteAddress 获取
+  if (m_family == AF_INET || m_family == AF_INET6) {
+    remote = Address::Create((sockaddr*)&addr, addrlen);
   }
+  return newsock;
+}
+
+Socket::ptr Socket::accept() {
+  Socket::ptr sock(new Socket(m_family, m_type, m_protocol));
+  int         newsock = acceptFd(sock->m_remoteAddress);
+  if (newsock == -1) { return nullptr; }
   if (sock->init(newsock)) { return sock; }
   return nullptr;
 }
@@ -131,7 +196,7 @@ bool Socket::init(int sock) {
   if (ctx && ctx->isSocket() && !ctx->isClose()) {
     m_sock        = sock;
     m_isConnected = true;
-    initSock();
+    // TCP_NODELAY 等参数从监听socket继承, 不再逐个设置
     getLocalAddress();
     getRemoteAddress();
     return true;
@@ -297,6 +362,85 @@ int Socket::recvFrom(iovec* buffers, size_t length, Address::ptr from, int flags
   return -1;
 }
 
+int Socket::recvBatch(DatagramBatch& batch, int flags) {
+  if (!isConnected()) { return -1; }
+  batch.prepareRecv();
+  int rt = ::recvmmsg(m_sock, batch.getMsgs(), batch.getCapacity(), flags, nullptr);
+  batch.finishRecv(rt > 0 ? rt : 0);
+  return rt;
+}
+
+int Socket::sendBatch(DatagramBatch& batch, int flags) {
+  if (!isConnected()) { return -1; }
+  size_t sent = 0;
+  // 发送缓冲区满时 sendmmsg 只发送一部分
+  while (sent < batch.size()) {
+    int rt = ::sendmmsg(m_sock, batch.getMsgs() + sent, batch.size() - sent, flags);
+    if (rt <= 0) { return sent > 0 ? sent : -1; }
+    sent += rt;
+  }
+  return sent;
+}
+
+bool Socket::setUdpGro(bool v) {
+  int val = v ? 1 : 0;
+  return setOption(SOL_UDP, UDP_GRO, val);
+}
+
+int64_t Socket::sendFile(int fd, off_t offset, size_t length) {
+  if (isConnected()) { return ::sendfile(m_sock, fd, &offset, length); }
+  return -1;
+}
+
+int Socket::sendFds(const void* buffer, size_t length, const std::vector<int>& fds) {
+  if (!isConnected()) { return -1; }
+  iovec iov;
+  iov.iov_base = (void*)buffer;
+  iov.iov_len  = length;
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+  msghdr            msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov    = &iov;
+  msg.msg_iovlen = 1;
+  if (!fds.empty()) {
+    msg.msg_control    = &control[0];
+    msg.msg_controllen = control.size();
+    cmsghdr* cmsg      = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level   = SOL_SOCKET;
+    cmsg->cmsg_type    = SCM_RIGHTS;
+    cmsg->cmsg_len     = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(cmsg), &fds[0], sizeof(int) * fds.size());
+  }
+  return ::sendmsg(m_sock, &msg, 0);
+}
+
+int Socket::recvFds(void* buffer, size_t length, std::vector<int>& fds, size_t max_fds) {
+  if (!isConnected()) { return -1; }
+  iovec iov;
+  iov.iov_base = buffer;
+  iov.iov_len  = length;
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * max_fds));
+  msghdr            msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = &control[0];
+  msg.msg_controllen = control.size();
+  int rt             = ::recvmsg(m_sock, &msg, MSG_CMSG_CLOEXEC);
+  if (rt < 0) { return rt; }
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) { continue; }
+    size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    size_t pos   = fds.size();
+    fds.resize(pos + count);
+    memcpy(&fds[pos], CMSG_DATA(cmsg), sizeof(int) * count);
+  }
+  if (msg.msg_flags & MSG_CTRUNC) {
+    LOG_WARN_STREAM << "recvFds control truncated sock=" << m_sock << " max_fds=" << max_fds;
+  }
+  return rt;
+}
+
 Address::ptr Socket::getRemoteAddress() {
   if (m_remoteAddress) { return m_remoteAddress; }
 
@@ -406,7 +550,7 @@ bool Socket::cancelAll() {
 void Socket::initSock() {
   int val = 1;
   setOption(SOL_SOCKET, SO_REUSEADDR, val);
-  if (m_type == SOCK_STREAM) { setOption(IPPROTO_TCP, TCP_NODELAY, val); }
+  if (m_type == SOCK_STREAM && m_family != AF_UNIX) { setOption(IPPROTO_TCP, TCP_NODELAY, val); }
 }
 
 void Socket::newSock() {
@@ -433,15 +577,72 @@ static _SSLInit s_init;
 
 }  // namespace
 
+static ConfigVar<uint32_t>::ptr g_ssl_session_cache_size =
+    Config::Lookup("ssl.session_cache_size", (uint32_t)20480, "服务端session缓存数量");
+
+static ConfigVar<uint32_t>::ptr g_ssl_session_timeout =
+    Config::Lookup("ssl.session_timeout", (uint32_t)300, "session有效时间(s)");
+
+static ConfigVar<bool>::ptr g_ssl_ktls =
+    Config::Lookup("ssl.ktls", true, "内核与OpenSSL支持时启用kTLS");
+
+static void EnableKtls(SSL_CTX* ctx) {
+#ifdef SSL_OP_ENABLE_KTLS
+  if (g_ssl_ktls->getValue()) { SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS); }
+#endif
+}
+
+std::shared_ptr<SSL_CTX> SSLSocket::CreateServerContext(const std::string& cert_file,
+                                                        const std::string& key_file) {
+  std::shared_ptr<SSL_CTX> ctx(SSL_CTX_new(TLS_server_method()), SSL_CTX_free);
+  if (SSL_CTX_use_certificate_chain_file(ctx.get(), cert_file.c_str()) != 1) {
+    LOG_ERROR_STREAM << "SSL_CTX_use_certificate_chain_file(" << cert_file << ") error";
+    return nullptr;
+  }
+  if (SSL_CTX_use_PrivateKey_file(ctx.get(), key_file.c_str(), SSL_FILETYPE_PEM) != 1) {
+    LOG_ERROR_STREAM << "SSL_CTX_use_PrivateKey_file(" << key_file << ") error";
+    return nullptr;
+  }
+  if (SSL_CTX_check_private_key(ctx.get()) != 1) {
+    LOG_ERROR_STREAM << "SSL_CTX_check_private_key cert_file=" << cert_file
+                     << " key_file=" << key_file;
+    return nullptr;
+  }
+  static const unsigned char s_sid_ctx[] = "Basic::SSLSocket";
+  SSL_CTX_set_session_id_context(ctx.get(), s_sid_ctx, sizeof(s_sid_ctx) - 1);
+  SSL_CTX_set_session_cache_mode(ctx.get(), SSL_SESS_CACHE_SERVER);
+  SSL_CTX_sess_set_cache_size(ctx.get(), g_ssl_session_cache_size->getValue());
+  SSL_CTX_set_timeout(ctx.get(), g_ssl_session_timeout->getValue());
+  EnableKtls(ctx.get());
+  return ctx;
+}
+
+std::shared_ptr<SSL_CTX> SSLSocket::GetClientContext() {
+  static std::shared_ptr<SSL_CTX> s_ctx = []() {
+    std::shared_ptr<SSL_CTX> ctx(SSL_CTX_new(TLS_client_method()), SSL_CTX_free);
+    // session 由调用方保存, 通过 OnNewSession 交给对应的socket
+    SSL_CTX_set_session_cache_mode(ctx.get(),
+                                   SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx.get(), &SSLSocket::OnNewSession);
+    EnableKtls(ctx.get());
+    return ctx;
+  }();
+  return s_ctx;
+}
+
+int SSLSocket::OnNewSession(SSL* ssl, SSL_SESSION* session) {
+  SSLSocket* sock = static_cast<SSLSocket*>(SSL_get_app_data(ssl));
+  if (!sock) { return 0; }
+  sock->m_session.reset(session, SSL_SESSION_free);
+  return 1;
+}
+
 SSLSocket::SSLSocket(int family, int type, int protocol) : Socket(family, type, protocol) {}
 
 Socket::ptr SSLSocket::accept() {
   SSLSocket::ptr sock(new SSLSocket(m_family, m_type, m_protocol));
-  int            newsock = ::accept(m_sock, nullptr, nullptr);
-  if (newsock == -1) {
-    LOG_ERROR_STREAM << "accept(" << m_sock << ") errno=" << errno << " errstr=" << strerror(errno);
-    return nullptr;
-  }
+  int            newsock = acceptFd(sock->m_remoteAddress);
+  if (newsock == -1) { return nullptr; }
   sock->m_ctx = m_ctx;
   if (sock->init(newsock)) { return sock; }
   return nullptr;
@@ -454,9 +655,11 @@ bool SSLSocket::bind(const Address::ptr addr) {
 bool SSLSocket::connect(const Address::ptr addr, uint64_t timeout_ms) {
   bool v = Socket::connect(addr, timeout_ms);
   if (v) {
-    m_ctx.reset(SSL_CTX_new(SSLv23_client_method()), SSL_CTX_free);
+    if (!m_ctx) { m_ctx = GetClientContext(); }
     m_ssl.reset(SSL_new(m_ctx.get()), SSL_free);
+    SSL_set_app_data(m_ssl.get(), this);
     SSL_set_fd(m_ssl.get(), m_sock);
+    if (m_session) { SSL_set_session(m_ssl.get(), m_session.get()); }
     v = (SSL_connect(m_ssl.get()) == 1);
   }
   return v;
@@ -467,6 +670,10 @@ bool SSLSocket::listen(int backlog) {
 }
 
 bool SSLSocket::close() {
+  // 不发送 close_notify, 只标记为正常关闭, 避免session被移出缓存
+  if (m_ssl && SSL_is_init_finished(m_ssl.get())) {
+    SSL_set_shutdown(m_ssl.get(), SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+  }
   return Socket::close();
 }
 
@@ -524,31 +731,52 @@ int SSLSocket::recvFrom(iovec* buffers, size_t length, Address::ptr from, int fl
   return -1;
 }
 
+int64_t SSLSocket::sendFile(int fd, off_t offset, size_t length) {
+  if (!m_ssl) { return -1; }
+#ifdef SSL_OP_ENABLE_KTLS
+  if (isKtlsSend()) { return SSL_sendfile(m_ssl.get(), fd, offset, length, 0); }
+#endif
+  char    buff[16 * 1024];
+  ssize_t n = pread(fd, buff, std::min(length, sizeof(buff)), offset);
+  if (n <= 0) { return n; }
+  return SSL_write(m_ssl.get(), buff, n);
+}
+
+bool SSLSocket::isSessionReused() const {
+  return m_ssl && SSL_session_reused(m_ssl.get());
+}
+
+bool SSLSocket::isKtlsSend() const {
+#ifdef SSL_OP_ENABLE_KTLS
+  return m_ssl && BIO_get_ktls_send(SSL_get_wbio(m_ssl.get()));
+#else
+  return false;
+#endif
+}
+
+bool SSLSocket::isKtlsRecv() const {
+#ifdef SSL_OP_ENABLE_KTLS
+  return m_ssl && BIO_get_ktls_recv(SSL_get_rbio(m_ssl.get()));
+#else
+  return false;
+#endif
+}
+
 bool SSLSocket::init(int sock) {
   bool v = Socket::init(sock);
   if (v) {
     m_ssl.reset(SSL_new(m_ctx.get()), SSL_free);
     SSL_set_fd(m_ssl.get(), m_sock);
-    v = (SSL_accept(m_ssl.get()) == 1);
+    // 握手推迟到第一次读写时在处理连接的协程中完成, 不阻塞 accept
+    SSL_set_accept_state(m_ssl.get());
   }
   return v;
 }
 
 bool SSLSocket::loadCertificates(const std::string& cert_file, const std::string& key_file) {
-  m_ctx.reset(SSL_CTX_new(SSLv23_server_method()), SSL_CTX_free);
-  if (SSL_CTX_use_certificate_chain_file(m_ctx.get(), cert_file.c_str()) != 1) {
-    LOG_ERROR_STREAM << "SSL_CTX_use_certificate_chain_file(" << cert_file << ") error";
-    return false;
-  }
-  if (SSL_CTX_use_PrivateKey_file(m_ctx.get(), key_file.c_str(), SSL_FILETYPE_PEM) != 1) {
-    LOG_ERROR_STREAM << "SSL_CTX_use_PrivateKey_file(" << key_file << ") error";
-    return false;
-  }
-  if (SSL_CTX_check_private_key(m_ctx.get()) != 1) {
-    LOG_ERROR_STREAM << "SSL_CTX_check_private_key cert_file=" << cert_file
-                     << " key_file=" << key_file;
-    return false;
-  }
+  auto ctx = CreateServerContext(cert_file, key_file);
+  if (!ctx) { return false; }
+  m_ctx = ctx;
   return true;
 }
 
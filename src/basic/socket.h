@@ -6,10 +6,33 @@
 #include <memory>
 
 #include "basic/address.h"
+#include "basic/datagram.h"
 #include "basic/noncopyable.h"
 
 namespace Basic {
 
+/**
+ * 可按服务器配置的 socket 参数, 0 表示使用系统默认值
+ * 设置在监听socket上的参数会被 accept 得到的socket继承(TCP_QUICKACK 除外)
+ */
+struct SocketOptions {
+  bool tcp_nodelay   = true;   // 关闭 Nagle 算法
+  bool tcp_quickack  = false;  // 立即回复ACK, 不会一直保持, 每个连接 accept 后设置一次
+  int  defer_accept  = 0;      // TCP_DEFER_ACCEPT(s), 监听socket上数据到达后 accept 才返回
+  int  fastopen      = 0;      // TCP_FASTOPEN 队列长度, 只用于监听socket
+  int  busy_poll     = 0;      // SO_BUSY_POLL(us), 阻塞读时忙轮询网卡队列
+  int  rcvbuf        = 0;      // SO_RCVBUF
+  int  sndbuf        = 0;      // SO_SNDBUF
+  int  notsent_lowat = 0;      // TCP_NOTSENT_LOWAT, 未发送数据超过该值时不可写
+
+  bool operator==(const SocketOptions& oth) const {
+    return tcp_nodelay == oth.tcp_nodelay && tcp_quickack == oth.tcp_quickack &&
+           defer_accept == oth.defer_accept && fastopen == oth.fastopen &&
+           busy_poll == oth.busy_poll && rcvbuf == oth.rcvbuf && sndbuf == oth.sndbuf &&
+           notsent_lowat == oth.notsent_lowat;
+  }
+};
+
 class Socket : public std::enable_shared_from_this<Socket>, NonCopyable {
 public:
   typedef std::shared_ptr<Socket> ptr;
@@ -34,6 +57,10 @@ public:
 
   static Socket::ptr CreateUnixTCPSocket();
   static Socket::ptr CreateUnixUDPSocket();
+  /// socketpair 创建一对已连接的 unix socket, 失败时返回两个空指针
+  static std::pair<Socket::ptr, Socket::ptr> CreateUnixPair(int type = TCP);
+  /// 接管已连接的socket, 如 recvFds 收到的fd
+  static Socket::ptr Attach(int fd);
 
   Socket(int family, int type, int protocol = 0);
   ~Socket();
@@ -59,6 +86,13 @@ public:
     return setOption(level, option, &value, sizeof(T));
   }
 
+  /**
+   * @brief 设置 SocketOptions 中的参数, 非TCP的socket跳过TCP参数
+   * @param[in] listener 为true时同时设置 defer_accept/fastopen, 在 listen 之前调用
+   * @return 全部设置成功返回true
+   */
+  bool applyOptions(const SocketOptions& opts, bool listener = false);
+
   virtual Socket::ptr accept();
 
   virtual bool bind(const Address::ptr addr);
@@ -77,6 +111,38 @@ public:
   virtual int recvFrom(void* buffer, size_t length, Address::ptr from, int flags = 0);
   virtual int recvFrom(iovec* buffers, size_t length, Address::ptr from, int flags = 0);
 
+  /**
+   * @brief recvmmsg 一次接收一批数据报, 没有数据时挂起协程
+   * @return 收到的数据报个数, 出错返回-1
+   */
+  int recvBatch(DatagramBatch& batch, int flags = 0);
+  /**
+   * @brief sendmmsg 发送 batch 中的所有数据报
+   * @return 发送的数据报个数, 一个都没有发送时返回-1
+   */
+  int sendBatch(DatagramBatch& batch, int flags = 0);
+  /// 开启 UDP_GRO, 内核把同一来源的连续报文合并成一个数据报交给 recvBatch
+  bool setUdpGro(bool v);
+
+  /**
+   * @brief 通过 SCM_RIGHTS 发送文件描述符, 只用于 unix socket
+   * @param[in] buffer 同时发送的数据, 不能为空
+   * @return 发送的数据字节数, 出错返回-1. 发送成功后原fd仍需调用方关闭
+   */
+  int sendFds(const void* buffer, size_t length, const std::vector<int>& fds);
+  /**
+   * @brief 接收 sendFds 发送的数据和文件描述符, 收到的fd设置了 close-on-exec
+   * @param[in] max_fds 最多接收的fd个数, 超出的被内核丢弃
+   * @return 收到的数据字节数, 出错返回-1
+   */
+  int recvFds(void* buffer, size_t length, std::vector<int>& fds, size_t max_fds = 16);
+
+  /**
+   * @brief 发送文件 fd 中从 offset 开始的 length 字节
+   * @return 实际发送的字节数, 可能小于 length
+   */
+  virtual int64_t sendFile(int fd, off_t offset, size_t length);
+
   Address::ptr getRemoteAddress();
   Address::ptr getLocalAddress();
 
@@ -102,6 +168,8 @@ protected:
   void         initSock();
   void         newSock();
   virtual bool init(int sock);
+  /// accept4 得到非阻塞的fd, IP地址族同时得到对端地址
+  int          acceptFd(Address::ptr& remote);
 
 protected:
   int  m_sock;
@@ -140,16 +208,44 @@ public:
   virtual int  recvFrom(void* buffer, size_t length, Address::ptr from, int flags = 0) override;
   virtual int  recvFrom(iovec* buffers, size_t length, Address::ptr from, int flags = 0) override;
 
-  bool                  loadCertificates(const std::string& cert_file, const std::string& key_file);
-  virtual std::ostream& dump(std::ostream& os) const override;
+  /// 启用kTLS发送时由内核加密, 走 sendfile 零拷贝; 否则读入用户态后 SSL_write
+  virtual int64_t sendFile(int fd, off_t offset, size_t length) override;
+
+  /**
+   * @brief 创建服务端SSL_CTX, 开启session缓存与session ticket, 多个监听socket应共用同一个
+   */
+  static std::shared_ptr<SSL_CTX> CreateServerContext(const std::string& cert_file,
+                                                      const std::string& key_file);
+
+  /// 进程内共享的客户端SSL_CTX
+  static std::shared_ptr<SSL_CTX> GetClientContext();
 
+  bool loadCertificates(const std::string& cert_file, const std::string& key_file);
+
+  void                     setContext(std::shared_ptr<SSL_CTX> v) { m_ctx = v; }
+  std::shared_ptr<SSL_CTX> getContext() const { return m_ctx; }
+
+  /// connect 前设置, 握手时尝试恢复该session
+  void setSession(std::shared_ptr<SSL_SESSION> v) { m_session = v; }
+  /// 服务端最近下发的session, 可用于之后的连接
+  std::shared_ptr<SSL_SESSION> getSession() const { return m_session; }
+
+  bool isSessionReused() const;
+  bool isKtlsSend() const;
+  bool isKtlsRecv() const;
+
+  virtual std::ostream& dump(std::ostream& os) const override;
 
 protected:
   virtual bool init(int sock) override;
 
 private:
-  std::shared_ptr<SSL_CTX> m_ctx;
-  std::shared_ptr<SSL>     m_ssl;
+  static int OnNewSession(SSL* ssl, SSL_SESSION* session);
+
+private:
+  std::shared_ptr<SSL_CTX>     m_ctx;
+  std::shared_ptr<SSL>         m_ssl;
+  std::shared_ptr<SSL_SESSION> m_session;
 };
 
 std::ostream& operator<<(std::ostream& os, const Socket& sock);
@@ -7,9 +7,9 @@ int Stream::readFixSize(void* buffer, size_t length) {
   int64_t left   = length;
   while (left > 0) {
     int64_t len = read((char*)buffer + offset, left);
-    if (len < 0) { return len; }
+    if (len <= 0) { return len; }
     offset += len;
-    left -= left;
+    left -= len;
   }
   return length;
 }
@@ -46,4 +46,30 @@ int Stream::writeFixSize(ByteArray::ptr ba, size_t length) {
   return length;
 }
 
+int Stream::read(BufferChain::ptr chain, size_t length) {
+  std::vector<iovec> iovs;
+  if (chain->getWriteBuffers(iovs, length) == 0) { return 0; }
+  int rt = read(iovs[0].iov_base, iovs[0].iov_len);
+  chain->commit(rt > 0 ? rt : 0);
+  return rt;
+}
+
+int Stream::write(BufferChain::ptr chain, size_t length) {
+  std::vector<iovec> iovs;
+  if (chain->getReadBuffers(iovs, length) == 0) { return 0; }
+  int rt = write(iovs[0].iov_base, iovs[0].iov_len);
+  if (rt > 0) { chain->consume(rt); }
+  return rt;
+}
+
+int Stream::writeFixSize(BufferChain::ptr chain, size_t length) {
+  int64_t left = length;
+  while (left > 0) {
+    int64_t len = write(chain, left);
+    if (len <= 0) { return len; }
+    left -= len;
+  }
+  return length;
+}
+
 }  // namespace Basic
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include "basic/buffer_chain.h"
 #include "basic/bytearray.h"
 
 namespace Basic {
@@ -21,6 +22,11 @@ public:
   virtual int  writeFixSize(const void* buffer, size_t length);
   virtual int  writeFixSize(ByteArray::ptr ba, size_t length);
 
+  // 读入的数据追加到链尾, 写出的数据从链头移除; 默认每次只读写一个节点
+  virtual int  read(BufferChain::ptr chain, size_t length);
+  virtual int  write(BufferChain::ptr chain, size_t length);
+  virtual int  writeFixSize(BufferChain::ptr chain, size_t length);
+
   virtual void close() = 0;
 };
 
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Basic {
+
+/**
+ * @brief 只能移动的 void() 任务函数
+ * @details 不超过 INLINE_SIZE 且可无异常移动的可调用对象直接存放在内部缓冲区, 不分配内存;
+ *          其余的在堆上分配. 可以保存只能移动的对象(如捕获了unique_ptr的lambda)
+ */
+class TaskFunc {
+public:
+  static const size_t INLINE_SIZE = 56;
+
+  TaskFunc() = default;
+
+  template <class F, typename = typename std::enable_if<
+                         !std::is_same<typename std::decay<F>::type, TaskFunc>::value>::type>
+  TaskFunc(F&& f) {
+    assign(std::forward<F>(f));
+  }
+
+  TaskFunc(TaskFunc&& other) { moveFrom(other); }
+
+  TaskFunc& operator=(TaskFunc&& other) {
+    if (this != &other) {
+      reset();
+      moveFrom(other);
+    }
+    return *this;
+  }
+
+  ~TaskFunc() { reset(); }
+
+  template <class F>
+  void assign(F&& f) {
+    typedef typename std::decay<F>::type Fn;
+    reset();
+    if (IsEmpty(f)) { return; }
+    if constexpr (sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) &&
+                  std::is_nothrow_move_constructible<Fn>::value) {
+      new (m_buf) Fn(std::forward<F>(f));
+      m_ops = &InlineOps<Fn>::s_ops;
+    } else {
+      *reinterpret_cast<Fn**>(m_buf) = new Fn(std::forward<F>(f));
+      m_ops = &HeapOps<Fn>::s_ops;
+    }
+  }
+
+  void reset() {
+    if (m_ops) {
+      m_ops->destroy(m_buf);
+      m_ops = nullptr;
+    }
+  }
+
+  void operator()() { m_ops->invoke(m_buf); }
+
+  explicit operator bool() const { return m_ops != nullptr; }
+
+private:
+  struct Ops {
+    void (*invoke)(void* buf);
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void* buf);
+  };
+
+  template <class Fn>
+  struct InlineOps {
+    static void Invoke(void* buf) { (*static_cast<Fn*>(buf))(); }
+    static void Move(void* dst, void* src) {
+      new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+      static_cast<Fn*>(src)->~Fn();
+    }
+    static void Destroy(void* buf) { static_cast<Fn*>(buf)->~Fn(); }
+
+    static constexpr Ops s_ops = {&Invoke, &Move, &Destroy};
+  };
+
+  template <class Fn>
+  struct HeapOps {
+    static void Invoke(void* buf) { (**static_cast<Fn**>(buf))(); }
+    static void Move(void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); }
+    static void Destroy(void* buf) { delete *static_cast<Fn**>(buf); }
+
+    static constexpr Ops s_ops = {&Invoke, &Move, &Destroy};
+  };
+
+  template <class F>
+  static bool IsEmpty(const F& f) {
+    if constexpr (std::is_constructible<bool, const F&>::value) {
+      return !static_cast<bool>(f);
+    } else {
+      return false;
+    }
+  }
+
+  void moveFrom(TaskFunc& other) {
+    if (other.m_ops) {
+      other.m_ops->move(m_buf, other.m_buf);
+      m_ops       = other.m_ops;
+      other.m_ops = nullptr;
+    }
+  }
+
+private:
+  alignas(std::max_align_t) unsigned char m_buf[INLINE_SIZE];
+  const Ops* m_ops = nullptr;
+};
+
+}  // namespace Basic
@@ -2,15 +2,92 @@
 
 #include "basic/tcp_server.h"
 
+#include <netinet/tcp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <yaml-cpp/yaml.h>
+
+#include <map>
+
 #include "basic/config.h"
 #include "basic/iomanager.h"
 #include "basic/log.h"
 
 namespace Basic {
 
+template <>
+class LexicalCast<std::string, SocketOptions> {
+public:
+  SocketOptions operator()(const std::string& v) {
+    YAML::Node    node = YAML::Load(v);
+    SocketOptions opts;
+#define XX(name, type) \
+  if (node[#name].IsDefined()) { opts.name = node[#name].as<type>(); }
+    XX(tcp_nodelay, bool);
+    XX(tcp_quickack, bool);
+    XX(defer_accept, int);
+    XX(fastopen, int);
+    XX(busy_poll, int);
+    XX(rcvbuf, int);
+    XX(sndbuf, int);
+    XX(notsent_lowat, int);
+#undef XX
+    return opts;
+  }
+};
+
+template <>
+class LexicalCast<SocketOptions, std::string> {
+public:
+  std::string operator()(const SocketOptions& opts) {
+    YAML::Node node;
+    node["tcp_nodelay"]   = opts.tcp_nodelay;
+    node["tcp_quickack"]  = opts.tcp_quickack;
+    node["defer_accept"]  = opts.defer_accept;
+    node["fastopen"]      = opts.fastopen;
+    node["busy_poll"]     = opts.busy_poll;
+    node["rcvbuf"]        = opts.rcvbuf;
+    node["sndbuf"]        = opts.sndbuf;
+    node["notsent_lowat"] = opts.notsent_lowat;
+    std::stringstream ss;
+    ss << node;
+    return ss.str();
+  }
+};
+
 static ConfigVar<uint64_t>::ptr g_tcp_server_read_timeout =
     Config::Lookup("tcp_server.read_timeout", (uint64_t)(60 * 1000 * 2), "tcp服务器读取超时时间");
 
+static ConfigVar<std::map<std::string, SocketOptions>>::ptr g_tcp_server_socket_options =
+    Config::Lookup("tcp_server.socket_options", std::map<std::string, SocketOptions>(),
+                   "按服务器名称配置的socket参数, default 对没有同名项的服务器生效");
+
+// 文件系统中的 unix socket 路径, 抽象命名空间和非unix地址返回空
+static std::string UnixPath(Address::ptr addr) {
+  auto unix_addr = std::dynamic_pointer_cast<UnixAddress>(addr);
+  if (!unix_addr) { return ""; }
+  std::string path = unix_addr->getPath();
+  return (path.empty() || path[0] == '\0') ? "" : path;
+}
+
+// 上次进程退出时留下的 socket 文件会让 bind 失败, 没有进程在监听时删除
+static void RemoveStaleUnixPath(Address::ptr addr) {
+  std::string path = UnixPath(addr);
+  struct stat st;
+  if (path.empty() || lstat(path.c_str(), &st) || !S_ISSOCK(st.st_mode)) { return; }
+  Socket::ptr sock = Socket::CreateUnixTCPSocket();
+  if (!sock->connect(addr, 100) && errno == ECONNREFUSED) {
+    LOG_INFO_STREAM << "remove stale unix socket: " << path;
+    unlink(path.c_str());
+  }
+}
+
+static void CloseListener(Socket::ptr sock) {
+  std::string path = UnixPath(sock->getLocalAddress());
+  sock->close();
+  if (!path.empty()) { unlink(path.c_str()); }
+}
+
 TcpServer::TcpServer(IOManager* worker, IOManager* io_worker, IOManager* accept_worker)
     : m_worker(worker),
       m_ioWorker(io_worker),
@@ -21,7 +98,7 @@ TcpServer::TcpServer(IOManager* worker, IOManager* io_worker, IOManager* accept_
 
 TcpServer::~TcpServer() {
   for (auto& i : m_socks) {
-    i->close();
+    CloseListener(i);
   }
   m_socks.clear();
 }
@@ -33,11 +110,23 @@ bool TcpServer::bind(Address::ptr addr, bool ssl) {
   return bind(addrs, fails, ssl);
 }
 
+void TcpServer::setSocketOptions(const SocketOptions& v) {
+  m_options    = v;
+  m_hasOptions = true;
+}
+
 bool TcpServer::bind(const std::vector<Address::ptr>& addrs, std::vector<Address::ptr>& fails,
                      bool ssl) {
   m_ssl = ssl;
+  if (!m_hasOptions) {
+    auto options = g_tcp_server_socket_options->getSnapshot();
+    auto it      = options->find(m_name);
+    if (it == options->end()) { it = options->find("default"); }
+    if (it != options->end()) { m_options = it->second; }
+  }
 
   for (auto& addr : addrs) {
+    RemoveStaleUnixPath(addr);
     Socket::ptr sock = ssl ? SSLSocket::CreateTCP(addr) : Socket::CreateTCP(addr);
     if (!sock->bind(addr)) {
       LOG_ERROR_STREAM << "bind fail errno=" << errno << " errstr=" << strerror(errno) << " addr=["
@@ -45,6 +134,11 @@ bool TcpServer::bind(const std::vector<Address::ptr>& addrs, std::vector<Address
       fails.push_back(addr);
       continue;
     }
+    // 缓冲区大小要在 listen 之前设置才能协商窗口扩大因子
+    if (!sock->applyOptions(m_options, true)) {
+      LOG_WARN_STREAM << "applyOptions fail errno=" << errno << " errstr=" << strerror(errno)
+                      << " addr=[" << addr->to_string() << "]";
+    }
     if (!sock->listen()) {
       LOG_ERROR_STREAM << "listen fail errno=" << errno << " errstr=" << strerror(errno)
                        << " addr=[" << addr->to_string() << "]";
@@ -55,6 +149,9 @@ bool TcpServer::bind(const std::vector<Address::ptr>& addrs, std::vector<Address
   }
 
   if (!fails.empty()) {
+    for (auto& i : m_socks) {
+      CloseListener(i);
+    }
     m_socks.clear();
     return false;
   }
@@ -71,6 +168,9 @@ void TcpServer::startAccept(Socket::ptr sock) {
     Socket::ptr client = sock->accept();
     if (client) {
       client->setRecvTimeout(m_recvTimeout);
+      if (m_options.tcp_quickack && client->getFamily() != AF_UNIX) {
+        client->setOption(IPPROTO_TCP, TCP_QUICKACK, 1);
+      }
       m_ioWorker->schedule(std::bind(&TcpServer::handleClient, shared_from_this(), client));
     } else {
       LOG_ERROR_STREAM << "accept errno=" << errno << " errstr=" << strerror(errno);
@@ -93,7 +193,7 @@ void TcpServer::stop() {
   m_acceptWorker->schedule([this, self]() {
     for (auto& sock : m_socks) {
       sock->cancelAll();
-      sock->close();
+      CloseListener(sock);
     }
     m_socks.clear();
   });
@@ -104,11 +204,12 @@ void TcpServer::handleClient(Socket::ptr client) {
 }
 
 bool TcpServer::loadCertificates(const std::string& cert_file, const std::string& key_file) {
+  // 所有监听socket共用一个SSL_CTX, session缓存和ticket密钥才能跨socket复用
+  auto ctx = SSLSocket::CreateServerContext(cert_file, key_file);
+  if (!ctx) { return false; }
   for (auto& i : m_socks) {
     auto ssl_socket = std::dynamic_pointer_cast<SSLSocket>(i);
-    if (ssl_socket) {
-      if (!ssl_socket->loadCertificates(cert_file, key_file)) { return false; }
-    }
+    if (ssl_socket) { ssl_socket->setContext(ctx); }
   }
   return true;
 }
@@ -12,6 +12,7 @@ namespace Basic {
 class TcpServer : public std::enable_shared_from_this<TcpServer>, NonCopyable {
 public:
   typedef std::shared_ptr<TcpServer> ptr;
+  /// 多NUMA节点时, 三个IOManager可通过 scheduler.affinity 绑定到网卡所在节点
   TcpServer(IOManager* worker = IOManager::GetThis(), IOManager* io_worker = IOManager::GetThis(),
             IOManager* accept_worker = IOManager::GetThis());
   virtual ~TcpServer();
@@ -29,6 +30,15 @@ public:
 
   bool isStop() const { return m_isStop; }
 
+  const std::vector<Socket::ptr>& getSocks() const { return m_socks; }
+
+  /**
+   * 监听socket的参数, 在 bind 之前设置. 没有设置时使用配置 tcp_server.socket_options
+   * 中与服务器名称同名的项, 没有同名项时使用 default 项
+   */
+  const SocketOptions& getSocketOptions() const { return m_options; }
+  void                 setSocketOptions(const SocketOptions& v);
+
   bool loadCertificates(const std::string& cert_file, const std::string& key_file);
 
   virtual std::string to_string(const std::string& prefix = "");
@@ -46,8 +56,10 @@ protected:
   std::string              m_name;
   std::string              m_type = "tcp";
   bool                     m_isStop;
+  SocketOptions            m_options;
 
-  bool m_ssl = false;
+  bool m_ssl        = false;
+  bool m_hasOptions = false;
 };
 
 }  // namespace Basic
\ No newline at end of file
@@ -68,7 +68,8 @@ private:
 private:
   LockType                                m_lock;
   std::set<Timer::ptr, Timer::Comparator> m_timers;
-  bool                                    m_tickled       = false;
+  /// getNextTimer 只持有读锁, 需要原子变量
+  std::atomic<bool>                       m_tickled       = {false};
   uint64_t                                m_previouseTime = 0;
 };
 
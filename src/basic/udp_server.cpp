@@ -0,0 +1,165 @@
+#include "basic/udp_server.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "basic/config.h"
+#include "basic/fd_manager.h"
+#include "basic/log.h"
+
+namespace Basic {
+
+static ConfigVar<uint32_t>::ptr g_udp_batch_size =
+    Config::Lookup("udp_server.batch_size", (uint32_t)64, "udp服务器每次收发的数据报个数");
+
+static ConfigVar<uint32_t>::ptr g_udp_buffer_size =
+    Config::Lookup("udp_server.buffer_size", (uint32_t)2048, "udp服务器每个数据报的缓冲区大小");
+
+static ConfigVar<bool>::ptr g_udp_gro =
+    Config::Lookup("udp_server.gro", false, "udp服务器开启UDP_GRO, 缓冲区扩大到64KB");
+
+bool UdpServer::Reply::send(const void* data, size_t len) {
+  return sendTo(data, len, m_packet->from, m_packet->fromLen);
+}
+
+bool UdpServer::Reply::sendTo(const void* data, size_t len, const sockaddr* to, socklen_t tolen) {
+  if (m_batch->size() == m_batch->getCapacity()) { flush(); }
+  return m_batch->add(data, len, to, tolen);
+}
+
+void UdpServer::Reply::flush() {
+  if (m_batch->empty()) { return; }
+  if (m_sock->sendBatch(*m_batch) < (int)m_batch->size()) {
+    LOG_ERROR_STREAM << "udp sendBatch errno=" << errno << " errstr=" << strerror(errno)
+                     << " sock=" << *m_sock;
+  }
+  m_batch->clear();
+}
+
+UdpServer::UdpServer(IOManager* worker)
+    : m_worker(worker), m_name("server/1.0.0"), m_isStop(true) {}
+
+UdpServer::~UdpServer() {
+  for (auto& i : m_socks) {
+    i->close();
+  }
+  m_socks.clear();
+}
+
+bool UdpServer::bind(Address::ptr addr, size_t sockets) {
+  if (sockets == 0) { sockets = m_worker ? std::max<size_t>(m_worker->getThreadCount(), 1) : 1; }
+
+  std::vector<Socket::ptr> socks;
+  for (size_t i = 0; i < sockets; ++i) {
+    Socket::ptr sock = Socket::CreateUDP(addr);
+    // 在没有开启 hook 的线程中创建时也登记到 FdManager, 接收协程才能挂起等待
+    FdMgr::GetInstance()->get(sock->getSocket(), true);
+    int val = 1;
+    sock->setOption(SOL_SOCKET, SO_REUSEPORT, val);
+    if (g_udp_gro->getValue() && !sock->setUdpGro(true)) {
+      LOG_WARN_STREAM << "udp setUdpGro fail errno=" << errno << " errstr=" << strerror(errno);
+    }
+    if (!sock->bind(addr)) {
+      LOG_ERROR_STREAM << "bind fail errno=" << errno << " errstr=" << strerror(errno) << " addr=["
+                       << addr->to_string() << "]";
+      return false;
+    }
+    // 端口为0时其余 socket 绑定到第一个分配到的端口
+    if (i == 0) { addr = sock->getLocalAddress(); }
+    socks.push_back(sock);
+  }
+  m_socks.insert(m_socks.end(), socks.begin(), socks.end());
+
+  LOG_INFO_STREAM << "type=" << m_type << " name=" << m_name << " sockets=" << sockets
+                  << " server bind success: " << *addr;
+  return true;
+}
+
+bool UdpServer::start() {
+  if (!m_isStop) { return true; }
+  m_isStop = false;
+  // 每个 socket 固定在一个线程上, 内核按四元组分发到各 socket 的数据报由各自线程处理
+  const std::vector<int>& threads = m_worker->getThreadIds();
+  for (size_t i = 0; i < m_socks.size(); ++i) {
+    int thread = threads.empty() ? -1 : threads[i % threads.size()];
+    m_worker->schedule(std::bind(&UdpServer::startRecv, shared_from_this(), m_socks[i], thread),
+                       thread);
+  }
+  return true;
+}
+
+void UdpServer::stop() {
+  m_isStop  = true;
+  auto self = shared_from_this();
+  // 关闭后接收协程的 recvBatch 返回 -1 退出
+  m_worker->schedule([this, self]() {
+    for (auto& sock : m_socks) {
+      sock->close();
+    }
+    m_socks.clear();
+  });
+}
+
+void UdpServer::handlePacket(const Packet& packet, Reply& reply) {
+  if (m_handler) { m_handler(packet, reply); }
+}
+
+void UdpServer::startRecv(Socket::ptr sock, int thread) {
+  size_t buf_size = g_udp_buffer_size->getValue();
+  if (g_udp_gro->getValue()) { buf_size = std::max<size_t>(buf_size, 65536); }
+  DatagramBatch recv(g_udp_batch_size->getValue(), buf_size);
+  DatagramBatch send(g_udp_batch_size->getValue(), buf_size);
+  Reply         reply(sock, &send);
+  uint64_t      backoff_ms = 0;
+
+  while (!m_isStop) {
+    int rt    = sock->recvBatch(recv);
+    int error = errno;
+    // 可读事件可能由其他线程取到并在那里恢复本协程, 回到所属线程再处理
+    m_worker->switchTo(thread);
+    if (rt < 0) {
+      if (m_isStop || error == EBADF) { break; }
+      // ENOMEM/ENOBUFS 等持续的错误, 退避后重试, 避免空转刷日志
+      backoff_ms = std::min<uint64_t>(backoff_ms ? backoff_ms * 2 : 1, 1000);
+      LOG_ERROR_STREAM << "udp recvBatch errno=" << error << " errstr=" << strerror(error)
+                       << " sock=" << *sock << " retry after " << backoff_ms << "ms";
+      usleep(backoff_ms * 1000);
+      continue;
+    }
+    backoff_ms = 0;
+    for (size_t i = 0; i < recv.size(); ++i) {
+      Packet packet;
+      packet.from    = recv.getAddr(i);
+      packet.fromLen = recv.getAddrLen(i);
+      const char* data    = recv.getData(i);
+      size_t      len     = recv.getLength(i);
+      size_t      segment = recv.getSegmentSize(i);
+      if (segment == 0) { segment = len; }
+      // 空报文也是一个报文, 至少交给处理器一次
+      size_t offset = 0;
+      do {
+        packet.data    = data + offset;
+        packet.size    = std::min(segment, len - offset);
+        reply.m_packet = &packet;
+        handlePacket(packet, reply);
+        offset += segment;
+      } while (offset < len);
+    }
+    reply.flush();
+  }
+}
+
+std::string UdpServer::to_string(const std::string& prefix) {
+  std::stringstream ss;
+  ss << prefix << "[type=" << m_type << " name=" << m_name
+     << " worker=" << (m_worker ? m_worker->getName() : "") << "]" << std::endl;
+  std::string pfx = prefix.empty() ? "    " : prefix;
+  for (auto& i : m_socks) {
+    ss << pfx << pfx << *i << std::endl;
+  }
+  return ss.str();
+}
+
+}  // namespace Basic
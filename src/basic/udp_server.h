@@ -0,0 +1,89 @@
+/**
+ * UDP 服务器
+ * 每个地址创建多个 SO_REUSEPORT socket, 内核按来源把数据报分散到各 socket, 每个 socket 一个接收协程
+ * 在 worker 的线程上运行. 接收协程用 recvmmsg 一次收一批数据报, 回调拿到的是接收缓冲区中的视图,
+ * 回复写入发送批次, 一批处理完后用 sendmmsg 一起发送, 收发过程中不申请内存
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "basic/address.h"
+#include "basic/datagram.h"
+#include "basic/iomanager.h"
+#include "basic/noncopyable.h"
+#include "basic/socket.h"
+
+namespace Basic {
+
+class UdpServer : public std::enable_shared_from_this<UdpServer>, NonCopyable {
+public:
+  typedef std::shared_ptr<UdpServer> ptr;
+
+  /// 收到的数据报, 只在回调期间有效. 开启 GRO 时合并的数据报按原来的报文分别回调
+  struct Packet {
+    const char*     data;
+    size_t          size;
+    const sockaddr* from;
+    socklen_t       fromLen;
+  };
+
+  /// 回复写入当前发送批次, 批次满时先发送已有的回复
+  class Reply : NonCopyable {
+  public:
+    /// 回复到数据报的来源地址, 超过缓冲区大小返回false
+    bool send(const void* data, size_t len);
+    bool sendTo(const void* data, size_t len, const sockaddr* to, socklen_t tolen);
+
+  private:
+    friend class UdpServer;
+    Reply(Socket::ptr sock, DatagramBatch* batch) : m_sock(sock), m_batch(batch) {}
+    void flush();
+
+  private:
+    Socket::ptr    m_sock;
+    DatagramBatch* m_batch;
+    const Packet*  m_packet = nullptr;
+  };
+
+  typedef std::function<void(const Packet& packet, Reply& reply)> Handler;
+
+  UdpServer(IOManager* worker = IOManager::GetThis());
+  virtual ~UdpServer();
+
+  /**
+   * @brief 绑定地址
+   * @param[in] sockets 创建的 SO_REUSEPORT socket 数, 0 表示 worker 的线程数
+   */
+  virtual bool bind(Address::ptr addr, size_t sockets = 0);
+  virtual bool start();
+  virtual void stop();
+
+  void setHandler(Handler v) { m_handler = std::move(v); }
+
+  std::string getName() const { return m_name; }
+  void        setName(const std::string& v) { m_name = v; }
+  bool        isStop() const { return m_isStop; }
+
+  const std::vector<Socket::ptr>& getSocks() const { return m_socks; }
+
+  virtual std::string to_string(const std::string& prefix = "");
+
+protected:
+  /// 默认交给 setHandler 设置的回调
+  virtual void handlePacket(const Packet& packet, Reply& reply);
+  /// 在 thread 线程上循环接收, -1 表示不限定线程
+  virtual void startRecv(Socket::ptr sock, int thread);
+
+protected:
+  std::vector<Socket::ptr> m_socks;
+  IOManager*               m_worker;
+  Handler                  m_handler;
+  std::string              m_name;
+  std::string              m_type = "udp";
+  bool                     m_isStop;
+};
+
+}  // namespace Basic
@@ -1,9 +1,14 @@
 #include "basic/utils.h"
 
+#include <dirent.h>
 #include <execinfo.h>
+#include <sched.h>
 #include <string.h>
 #include <sys/syscall.h>
 
+#include <algorithm>
+#include <fstream>
+
 #include "basic/fiber.h"
 #include "basic/log.h"
 
@@ -61,6 +66,21 @@ std::string backtrace2string(int size, int skip, const std::string& prefix) {
   return ss.str();
 }
 
+std::string backtrace2string(void* const* frames, int size, int skip, const std::string& prefix) {
+  char** strings = backtrace_symbols(frames, size);
+  if (strings == nullptr) {
+    LOG_ERROR("backtrace_synbols error");
+    return "";
+  }
+
+  std::stringstream ss;
+  for (int i = skip; i < size; ++i) {
+    ss << prefix << strings[i] << std::endl;
+  }
+  free(strings);
+  return ss.str();
+}
+
 uint64_t get_current_ms() {
   struct timeval tv;
   gettimeofday(&tv, NULL);
@@ -73,6 +93,12 @@ uint64_t get_current_us() {
   return tv.tv_sec * 1000 * 1000ul  + tv.tv_usec;
 }
 
+uint64_t get_coarse_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return ts.tv_sec * 1000ul + ts.tv_nsec / 1000000;
+}
+
 std::string time2str(time_t ts, const std::string& format) {
   struct tm tm;
   localtime_r(&ts, &tm);
@@ -90,4 +116,94 @@ time_t str2time(const char* str, const char* format) {
   return mktime(&t);
 }
 
+void list_all_file(std::vector<std::string>& files, const std::string& path,
+                   const std::string& subfix) {
+  DIR* dir = opendir(path.c_str());
+  if (!dir) { return; }
+  struct dirent* dp = nullptr;
+  while ((dp = readdir(dir)) != nullptr) {
+    std::string name = dp->d_name;
+    if (name == "." || name == "..") { continue; }
+    if (dp->d_type == DT_DIR) {
+      list_all_file(files, path + "/" + name, subfix);
+    } else if (dp->d_type == DT_REG && name.size() >= subfix.size() &&
+               name.compare(name.size() - subfix.size(), subfix.size(), subfix) == 0) {
+      files.push_back(path + "/" + name);
+    }
+  }
+  closedir(dir);
+}
+
+std::vector<int> parse_cpu_list(const std::string& str) {
+  std::vector<int> cpus;
+  size_t           pos = 0;
+  while (pos < str.size()) {
+    size_t      end  = str.find(',', pos);
+    std::string item = str.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    pos              = end == std::string::npos ? str.size() : end + 1;
+
+    item.erase(0, item.find_first_not_of(" \t\n"));
+    item.erase(item.find_last_not_of(" \t\n") + 1);
+    if (item.empty()) { continue; }
+
+    char* ptr   = nullptr;
+    long  first = strtol(item.c_str(), &ptr, 10);
+    long  last  = first;
+    if (ptr == item.c_str()) { return {}; }
+    if (*ptr == '-') {
+      const char* begin = ptr + 1;
+      last              = strtol(begin, &ptr, 10);
+      if (ptr == begin) { return {}; }
+    }
+    if (*ptr || first < 0 || last < first || last >= CPU_SETSIZE) { return {}; }
+    for (int i = first; i <= last; ++i) {
+      cpus.push_back(i);
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+static std::string read_sys_file(const std::string& path) {
+  std::ifstream ifs(path);
+  std::string   line;
+  if (ifs) { std::getline(ifs, line); }
+  return line;
+}
+
+int get_numa_node_count() {
+  std::vector<int> nodes = parse_cpu_list(read_sys_file("/sys/devices/system/node/online"));
+  return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+std::vector<int> get_numa_node_cpus(int node) {
+  std::vector<int> cpus = parse_cpu_list(
+      read_sys_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+  if (cpus.empty() && node == 0) {
+    cpus = parse_cpu_list(read_sys_file("/sys/devices/system/cpu/online"));
+    if (cpus.empty()) {
+      for (long i = 0; i < sysconf(_SC_NPROCESSORS_ONLN); ++i) {
+        cpus.push_back(i);
+      }
+    }
+  }
+  return cpus;
+}
+
+bool set_thread_affinity(const std::vector<int>& cpus) {
+  if (cpus.empty()) { return false; }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int i : cpus) {
+    CPU_SET(i, &set);
+  }
+  int rt = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (rt) {
+    LOG_ERROR("pthread_setaffinity_np fail, rt=%d, errstr=%s", rt, strerror(rt));
+    return false;
+  }
+  return true;
+}
+
 }  // namespace Basic
\ No newline at end of file
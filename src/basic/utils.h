@@ -76,6 +76,12 @@ void my_backtrace(std::vector<std::string>& bt, int size, int skip = 1);
  */
 std::string backtrace2string(int size = 64, int skip = 2, const std::string& prefix = "");
 
+/**
+ * @brief 把 backtrace() 得到的地址转换成调用栈字符串
+ */
+std::string backtrace2string(void* const* frames, int size, int skip = 0,
+                             const std::string& prefix = "");
+
 /**
  * @brief 获取当前时间的毫秒
  */
@@ -86,8 +92,42 @@ uint64_t get_current_ms();
  */
 uint64_t get_current_us();
 
+/**
+ * @brief 单调时钟毫秒, 精度为一个时钟节拍(通常1~4ms), 开销比 get_current_ms 小
+ */
+uint64_t get_coarse_ms();
+
 std::string time2str(time_t ts = time(0), const std::string& format = "%Y-%m-%d %H:%M:%S");
 
 time_t str2time(const std::string& str, const std::string& format = "%Y-%m-%d %H:%M:%S");
 
+/**
+ * @brief 递归列出目录下以 subfix 结尾的文件
+ * @param[out] files 追加完整路径
+ */
+void list_all_file(std::vector<std::string>& files, const std::string& path,
+                   const std::string& subfix);
+
+/**
+ * @brief 解析cpu列表, 格式同 /sys/devices/system/node/node0/cpulist, 如 "0-3,8,10-11"
+ * @return 升序去重的cpu编号, 格式错误返回空
+ */
+std::vector<int> parse_cpu_list(const std::string& str);
+
+/**
+ * @brief 获取NUMA节点数, 没有NUMA信息时返回1
+ */
+int get_numa_node_count();
+
+/**
+ * @brief 获取NUMA节点上的cpu, 没有NUMA信息时节点0返回全部在线cpu
+ */
+std::vector<int> get_numa_node_cpus(int node);
+
+/**
+ * @brief 把当前线程绑定到指定cpu集合
+ * @return 成功返回true
+ */
+bool set_thread_affinity(const std::vector<int>& cpus);
+
 }  // namespace Basic
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "basic/watchdog.h"
+
+#include <execinfo.h>
+#include <signal.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "basic/config.h"
+#include "basic/fiber.h"
+#include "basic/log.h"
+#include "basic/utils.h"
+
+namespace Basic {
+
+static ConfigVar<uint32_t>::ptr g_fiber_watchdog_ms =
+    Config::Lookup("fiber.watchdog_ms", (uint32_t)0, "协程连续运行超过该时间(ms)时打印调用栈, 0关闭");
+
+static thread_local FiberWatchdog::Slot* t_slot = nullptr;
+
+FiberWatchdog::FiberWatchdog() {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = &FiberWatchdog::OnSignal;
+  sa.sa_flags   = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGURG, &sa, nullptr);
+
+  m_thread.reset(new Thread(std::bind(&FiberWatchdog::run, this), "watchdog"));
+}
+
+FiberWatchdog::~FiberWatchdog() {
+  m_stop = true;
+  m_sem.notify();
+  m_thread->join();
+}
+
+FiberWatchdog::Slot* FiberWatchdog::RegisterThread() {
+  if (g_fiber_watchdog_ms->getValue() == 0) { return nullptr; }
+  return FiberWatchdogMgr::GetInstance()->addSlot();
+}
+
+void FiberWatchdog::UnregisterThread(Slot* slot) {
+  if (slot) { FiberWatchdogMgr::GetInstance()->delSlot(slot); }
+}
+
+FiberWatchdog::Slot* FiberWatchdog::addSlot() {
+  // backtrace 第一次调用会加载libgcc, 不能放在信号处理函数里
+  void* dummy[1];
+  backtrace(dummy, 1);
+
+  Slot* slot   = new Slot;
+  slot->tid    = get_thread_id();
+  slot->thread = pthread_self();
+  t_slot       = slot;
+
+  LockType::Lock lock(m_mutex);
+  m_slots.push_back(slot);
+  return slot;
+}
+
+void FiberWatchdog::delSlot(Slot* slot) {
+  {
+    LockType::Lock lock(m_mutex);
+    m_slots.remove(slot);
+  }
+  // 等看门狗线程抓完本线程的调用栈, t_slot 仍有效时信号处理函数能很快应答
+  while (slot->checking.load(std::memory_order_acquire)) {
+    usleep(1000);
+  }
+  if (t_slot == slot) { t_slot = nullptr; }
+  delete slot;
+}
+
+void FiberWatchdog::OnSignal(int) {
+  Slot* slot = t_slot;
+  if (!slot || slot->frameCount.load(std::memory_order_acquire) >= 0) { return; }
+  slot->frameFiber = Fiber::GetFiberId();
+  slot->frameCount.store(backtrace(slot->frames, Slot::MAX_FRAMES), std::memory_order_release);
+}
+
+void FiberWatchdog::run() {
+  while (!m_stop) {
+    uint32_t limit = g_fiber_watchdog_ms->getValue();
+    m_sem.waitFor(limit ? std::max(limit / 2, (uint32_t)1) : 1000);
+    if (m_stop) { break; }
+    if (limit == 0) { continue; }
+
+    // 发信号和等待调用栈最长要50ms, 不能持锁, 否则阻塞调度线程的启动和退出
+    uint64_t           now = get_coarse_ms();
+    std::vector<Slot*> stalled;
+    {
+      LockType::Lock lock(m_mutex);
+      for (auto slot : m_slots) {
+        if (!isStalled(slot, now, limit)) { continue; }
+        slot->checking.store(true, std::memory_order_release);
+        stalled.push_back(slot);
+      }
+    }
+    for (auto slot : stalled) {
+      check(slot, now, limit);
+      slot->checking.store(false, std::memory_order_release);
+    }
+  }
+}
+
+bool FiberWatchdog::isStalled(Slot* slot, uint64_t now, uint64_t limit) const {
+  uint64_t start = slot->start.load(std::memory_order_acquire);
+  return start != 0 && now >= start + limit && slot->reported != start;
+}
+
+void FiberWatchdog::check(Slot* slot, uint64_t now, uint64_t limit) {
+  uint64_t start = slot->start.load(std::memory_order_acquire);
+  if (start == 0 || now < start + limit || slot->reported == start) { return; }
+  slot->reported = start;
+  ++m_reports;
+
+  uint64_t fiber_id = slot->fiber.load(std::memory_order_relaxed);
+  slot->frameCount.store(-1, std::memory_order_release);
+  pthread_kill(slot->thread, SIGURG);
+  int count = -1;
+  for (int i = 0; i < 50 && (count = slot->frameCount.load(std::memory_order_acquire)) < 0; ++i) {
+    usleep(1000);
+  }
+
+  // 信号到达时协程可能已经让出, 调用栈不再属于它
+  std::string bt;
+  if (count > 0 && slot->frameFiber == fiber_id) {
+    bt = backtrace2string(slot->frames, count, 2, "    ");
+  }
+  LOG_ERROR("fiber_id=%lu thread=%d running %lu ms without yield\n%s", fiber_id, slot->tid,
+            now - start, bt.c_str());
+}
+
+}  // namespace Basic
@@ -0,0 +1,85 @@
+/**
+ * 协程运行看门狗
+ * 调度线程执行每个任务前登记开始时间, 看门狗线程定期检查,
+ * 发现某个协程连续运行超过 fiber.watchdog_ms 仍未让出时, 向该线程发送 SIGURG,
+ * 在信号处理函数中抓取调用栈地址, 由看门狗线程转换成字符串写日志
+ */
+#pragma once
+
+#include <pthread.h>
+
+#include <atomic>
+#include <list>
+#include <memory>
+
+#include "basic/mutex.h"
+#include "basic/singleton.h"
+#include "basic/thread.h"
+
+namespace Basic {
+
+class FiberWatchdog {
+public:
+  typedef Mutex LockType;
+
+  /// 每个调度线程一个, 记录当前正在执行的协程
+  struct Slot {
+    static const int MAX_FRAMES = 64;
+
+    pid_t                 tid      = 0;
+    pthread_t             thread   = 0;
+    std::atomic<uint64_t> start    = {0};  // 本次开始执行的时间, 0表示没有在执行任务
+    std::atomic<uint64_t> fiber    = {0};
+    uint64_t              reported = 0;  // 已报告过的那次执行的开始时间, 只由看门狗线程访问
+    std::atomic<bool>     checking = {false};  // 看门狗线程正在不持锁地抓取调用栈, 不能释放
+
+    std::atomic<int> frameCount = {-1};  // 信号处理函数写入, -1表示还没抓到
+    uint64_t         frameFiber = 0;
+    void*            frames[MAX_FRAMES];
+  };
+
+  FiberWatchdog();
+  ~FiberWatchdog();
+
+  /**
+   * @brief 在调度线程中调用, 登记当前线程, 第一次登记时启动看门狗线程
+   * @return 看门狗关闭(fiber.watchdog_ms为0)时返回nullptr
+   */
+  static Slot* RegisterThread();
+  static void  UnregisterThread(Slot* slot);
+
+  /// start 为 get_coarse_ms() 的返回值
+  static void Begin(Slot* slot, uint64_t fiber_id, uint64_t start) {
+    if (!slot) { return; }
+    slot->fiber.store(fiber_id, std::memory_order_relaxed);
+    slot->start.store(start, std::memory_order_release);
+  }
+
+  static void End(Slot* slot) {
+    if (slot) { slot->start.store(0, std::memory_order_release); }
+  }
+
+  /// 累计报告的超时次数
+  uint64_t getReportCount() const { return m_reports; }
+
+private:
+  Slot* addSlot();
+  void  delSlot(Slot* slot);
+  void  run();
+  bool  isStalled(Slot* slot, uint64_t now, uint64_t limit) const;
+  void  check(Slot* slot, uint64_t now, uint64_t limit);
+
+  static void OnSignal(int sig);
+
+private:
+  LockType              m_mutex;
+  std::list<Slot*>      m_slots;
+  Thread::ptr           m_thread;
+  Semaphore             m_sem;
+  std::atomic<bool>     m_stop    = {false};
+  std::atomic<uint64_t> m_reports = {0};
+};
+
+typedef Singleton<FiberWatchdog> FiberWatchdogMgr;
+
+}  // namespace Basic
@@ -288,6 +288,7 @@ public:
   void               setStatus(HttpStatus v) { m_status = v; }
   void               setVersion(uint8_t v) { m_version = v; }
   void               setBody(const std::string& v) { m_body = v; }
+  void               setBody(std::string&& v) { m_body = std::move(v); }
   void               setReason(const std::string& v) { m_reason = v; }
   void               setHeaders(const MapType& v) { m_headers = v; }
   bool               isClose() const { return m_close; }
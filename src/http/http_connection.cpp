@@ -1,7 +1,12 @@
 #include "http_connection.h"
 
+#include <algorithm>
 #include <functional>
 
+#include "basic/cancel.h"
+#include "basic/config.h"
+#include "basic/hook.h"
+#include "basic/iomanager.h"
 #include "basic/log.h"
 #include "basic/utils.h"
 #include "http_parser.h"
@@ -15,22 +20,44 @@ std::string HttpResult::to_string() const {
   return ss.str();
 };
 
-HttpConnection::HttpConnection(Socket::ptr sock, bool owner) : SocketStream(sock, owner) {}
+HttpConnection::HttpConnection(Socket::ptr sock, bool owner) : SocketStream(sock, owner) {
+  m_createTime  = get_current_ms();
+  m_lastUseTime = m_createTime;
+}
 
 HttpConnection::~HttpConnection() {
   LOG_DEBUG("HttpConnection::~HttpConnection");
 }
 
 HttpResponse::ptr HttpConnection::recvResponse() {
+  std::string body;
+  uint64_t    max_size = HttpResponseParser::GetHttpResponseMaxBodySize();
+  auto        rsp      = recvResponse([&body, max_size](const char* data, size_t len) {
+    if (body.size() + len > max_size) {
+      LOG_ERROR_STREAM << "recvResponse: body too large, max_size=" << max_size;
+      return false;
+    }
+    body.append(data, len);
+    return true;
+  });
+  if (rsp) { rsp->setBody(std::move(body)); }
+  return rsp;
+}
+
+HttpResponse::ptr HttpConnection::recvResponse(Stream::ptr out) {
+  return recvResponse([out](const char* data, size_t len) {
+    return out->writeFixSize(data, len) > 0;
+  });
+}
+
+HttpResponse::ptr HttpConnection::recvResponse(BodyCallback cb) {
   HttpResponseParser::ptr parser(new HttpResponseParser);
-  uint64_t                buff_size = HttpRequestParser::GetHttpRequestBufferSize();
-  // uint64_t buff_size = 100;
-  std::shared_ptr<char> buffer(new char[buff_size + 1], [](char* ptr) { delete[] ptr; });
-  char*                 data   = buffer.get();
-  int                   offset = 0;
+  uint64_t                buff_size = HttpResponseParser::GetHttpResponseBufferSize();
+  std::shared_ptr<char>   buffer(new char[buff_size + 1], [](char* ptr) { delete[] ptr; });
+  char*                   data   = buffer.get();
+  int                     offset = 0;
   do {
     int len = read(data + offset, buff_size - offset);
-    LOG_DEBUG_STREAM << "recvResponse: read header len=" << len;
     if (len <= 0) {
       LOG_ERROR_STREAM << "recvResponse: read header failed, len=" << len << ", errno=" << errno;
       close();
@@ -39,7 +66,6 @@ HttpResponse::ptr HttpConnection::recvResponse() {
     len += offset;
     data[len]     = '\0';
     size_t nparse = parser->execute(data, len, false);
-    LOG_DEBUG_STREAM << "recvResponse: execute nparse=" << nparse << ", len=" << len;
     if (parser->hasError()) {
       LOG_ERROR_STREAM << "recvResponse: parser error";
       close();
@@ -53,98 +79,99 @@ HttpResponse::ptr HttpConnection::recvResponse() {
     }
     if (parser->isFinished()) { break; }
   } while (true);
+
   auto& client_parser = parser->getParser();
-  LOG_INFO_STREAM << "recvResponse: header done, chunked=" << client_parser.chunked
-                  << ", content_len=" << parser->getContentLength()
-                  << ", status=" << client_parser.status;
-  std::string body;
-  if (client_parser.chunked) {
-    int len = offset;
-    LOG_DEBUG_STREAM << "recvResponse: start chunked, offset=" << offset;
-    do {
-      bool begin = true;
-      do {
-        if (!begin || len == 0) {
-          int rt = read(data + len, buff_size - len);
-          LOG_DEBUG_STREAM << "recvResponse: read chunk rt=" << rt;
-          if (rt <= 0) {
-            LOG_ERROR_STREAM << "recvResponse: read chunk failed, rt=" << rt << ", errno=" << errno;
-            close();
-            return nullptr;
-          }
-          len += rt;
-        }
+  LOG_DEBUG_STREAM << "recvResponse: header done, chunked=" << client_parser.chunked
+                   << ", content_len=" << parser->getContentLength()
+                   << ", status=" << client_parser.status;
+
+  // 缓冲区中 [0, len) 为已读取未处理的数据, body 只经过这一块固定大小的缓冲区
+  int  len       = offset;
+  auto read_more = [this, data, buff_size, &len]() {
+    if (len == (int)buff_size) {
+      LOG_ERROR_STREAM << "recvResponse: buffer full";
+      return false;
+    }
+    int rt = read(data + len, buff_size - len);
+    if (rt <= 0) {
+      LOG_ERROR_STREAM << "recvResponse: read failed, rt=" << rt << ", errno=" << errno;
+      return false;
+    }
+    len += rt;
+    return true;
+  };
+  // 交付 length 字节的 body, 先取缓冲区中的数据, 剩余部分直接读入缓冲区后交付
+  auto read_body = [this, data, buff_size, &len, &cb](uint64_t length) {
+    uint64_t n = std::min((uint64_t)len, length);
+    if (n > 0) {
+      if (!cb(data, n)) { return false; }
+      memmove(data, data + n, len - n);
+      len    -= n;
+      length -= n;
+    }
+    while (length > 0) {
+      int rt = read(data, std::min(length, buff_size));
+      if (rt <= 0) {
+        LOG_ERROR_STREAM << "recvResponse: read body failed, rt=" << rt << ", errno=" << errno;
+        return false;
+      }
+      if (!cb(data, rt)) { return false; }
+      length -= rt;
+    }
+    return true;
+  };
 
-        data[len]     = '\0';
-        size_t nparse = parser->execute(data, len, true);
-        LOG_DEBUG_STREAM << "recvResponse: chunk execute nparse=" << nparse << ", len=" << len;
-        if (parser->hasError()) {
-          LOG_ERROR_STREAM << "recvResponse: chunk parser error, data="
-                           << std::string(data, std::min(len, 50));
-          close();
-          return nullptr;
-        }
-        len -= nparse;
-        if (len == (int)buff_size) {
-          LOG_ERROR_STREAM << "recvResponse: chunk buffer full";
+  if (client_parser.chunked) {
+    while (true) {
+      // chunk 头 ("\r\n"? size [ext] "\r\n") 完整后再交给解析器, 解析器每次都会重置状态
+      int skip = 0;
+      if (skip < len && data[skip] == '\r') { ++skip; }
+      if (skip < len && data[skip] == '\n') { ++skip; }
+      if (!memchr(data + skip, '\n', len - skip)) {
+        if (!read_more()) {
           close();
           return nullptr;
         }
-        begin = false;
-      } while (!parser->isFinished());
-
-      LOG_INFO_STREAM << "content_len=" << client_parser.content_len
-                      << ", chunks_done=" << client_parser.chunks_done;
-      if (client_parser.content_len <= len) {
-        body.append(data, client_parser.content_len);
-        memmove(data, data + client_parser.content_len, len - client_parser.content_len);
-        len -= client_parser.content_len;
-      } else {
-        body.append(data, len);
-        int left = client_parser.content_len - len;
-        while (left > 0) {
-          int rt = read(data, left > (int)buff_size ? (int)buff_size : left);
-          if (rt <= 0) {
-            LOG_ERROR_STREAM << "recvResponse: read chunk body failed, rt=" << rt;
-            close();
-            return nullptr;
-          }
-          body.append(data, rt);
-          left -= rt;
-        }
-        len = 0;
+        continue;
       }
-    } while (!client_parser.chunks_done);
-    LOG_INFO_STREAM << "recvResponse: chunked done, body size=" << body.size();
-    parser->getData()->setBody(body);
-  } else {
-    int64_t length = parser->getContentLength();
-    LOG_DEBUG_STREAM << "recvResponse: content-length mode, length=" << length;
-    if (length > 0) {
-      std::string body;
-      body.resize(length);
-
-      int len = 0;
-      if (length >= offset) {
-        memcpy(&body[0], data, offset);
-        len = offset;
-      } else {
-        memcpy(&body[0], data, length);
-        len = length;
+      data[len]     = '\0';
+      size_t nparse = parser->execute(data, len, true);
+      if (parser->hasError() || !parser->isFinished()) {
+        LOG_ERROR_STREAM << "recvResponse: chunk parser error, data="
+                         << std::string(data, std::min(len, 50));
+        close();
+        return nullptr;
+      }
+      len -= nparse;
+      if (client_parser.chunks_done) { break; }
+      if (!read_body(client_parser.content_len)) {
+        close();
+        return nullptr;
       }
-      length -= offset;
-      if (length > 0) {
-        if (readFixSize(&body[len], length) <= 0) {
-          LOG_ERROR_STREAM << "recvResponse: readFixSize failed";
+    }
+    // 跳过 trailer 直到空行, 保证连接复用时下一个响应从头开始解析
+    while (true) {
+      char* end = (char*)memchr(data, '\n', len);
+      if (!end) {
+        if (!read_more()) {
           close();
           return nullptr;
         }
+        continue;
       }
-      parser->getData()->setBody(body);
+      int  line  = end - data + 1;
+      bool empty = line == 1 || (line == 2 && data[0] == '\r');
+      memmove(data, end + 1, len - line);
+      len -= line;
+      if (empty) { break; }
+    }
+  } else {
+    int64_t length = parser->getContentLength();
+    if (length > 0 && !read_body(length)) {
+      close();
+      return nullptr;
     }
   }
-
-  LOG_INFO_STREAM << "recvResponse: success";
   return parser->getData();
 }
 
@@ -226,6 +253,11 @@ HttpResult::ptr HttpConnection::DoRequest(HttpMethod method, Uri::ptr uri, uint6
 }
 
 HttpResult::ptr HttpConnection::DoRequest(HttpRequest::ptr req, Uri::ptr uri, uint64_t timeout_ms) {
+  return DoRequest(req, uri, timeout_ms, nullptr);
+}
+
+HttpResult::ptr HttpConnection::DoRequest(HttpRequest::ptr req, Uri::ptr uri, uint64_t timeout_ms,
+                                          BodyCallback cb) {
   Address::ptr addr = uri->createAddress();
   if (!addr) {
     return std::make_shared<HttpResult>((int)HttpResult::Error::INVALID_HOST, nullptr,
@@ -254,7 +286,7 @@ HttpResult::ptr HttpConnection::DoRequest(HttpRequest::ptr req, Uri::ptr uri, ui
                                         "send request socket error errno=" + std::to_string(errno) +
                                             " errstr=" + std::string(strerror(errno)));
   }
-  auto rsp = conn->recvResponse();
+  auto rsp = cb ? conn->recvResponse(cb) : conn->recvResponse();
   if (!rsp) {
     return std::make_shared<HttpResult>((int)HttpResult::Error::TIMEOUT, nullptr,
                                         "recv response timeout: " + addr->to_string() +
@@ -265,73 +297,311 @@ HttpResult::ptr HttpConnection::DoRequest(HttpRequest::ptr req, Uri::ptr uri, ui
 
 HttpConnectionPool::HttpConnectionPool(const std::string& host, const std::string& vhost,
                                        uint32_t port, uint32_t max_size, uint32_t max_alive_time,
-                                       uint32_t max_request)
+                                       uint32_t max_request, bool is_https)
     : m_host(host),
       m_vhost(vhost),
       m_port(port),
       m_maxSize(max_size),
       m_maxAliveTime(max_alive_time),
-      m_maxRequest(max_request) {}
+      m_maxRequest(max_request),
+      m_isHttps(is_https) {}
+
+HttpConnectionPool::ptr HttpConnectionPool::CreateUnix(const std::string& path,
+                                                       const std::string& vhost, uint32_t max_size,
+                                                       uint32_t max_alive_time,
+                                                       uint32_t max_request) {
+  HttpConnectionPool::ptr pool(new HttpConnectionPool(vhost.empty() ? "localhost" : vhost, vhost,
+                                                      0, max_size, max_alive_time, max_request));
+  pool->m_unixPath = path;
+  return pool;
+}
 
-HttpConnection::ptr HttpConnectionPool::getConnection() {
+HttpConnectionPool::~HttpConnectionPool() {
+  stopIdleCheck();
+  for (auto i : m_conns) {
+    delete i;
+  }
+  m_conns.clear();
+}
+
+bool HttpConnectionPool::isExpired(HttpConnection* conn, uint64_t now_ms) const {
+  if (m_maxAliveTime && conn->m_createTime + m_maxAliveTime <= now_ms) { return true; }
+  if (m_maxRequest && conn->m_request >= m_maxRequest) { return true; }
+  return false;
+}
+
+// 空闲连接上不应有可读数据, 对端关闭(recv返回0)或有残留数据都不能复用
+static bool CheckAlive(HttpConnection* conn) {
+  if (!conn->isConnected()) { return false; }
+  char    c;
+  ssize_t rt = recv_f(conn->getSocket()->getSocket(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return rt == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+HttpConnection::ptr HttpConnectionPool::getConnection(uint64_t timeout_ms) {
   uint64_t                     now_ms = get_current_ms();
   std::vector<HttpConnection*> invalid_conns;
-  HttpConnection*              ptr = nullptr;
+  HttpConnection*              ptr    = nullptr;
+  bool                         create = false;
   LockType::Lock               lock(m_mutex);
   while (!m_conns.empty()) {
     auto conn = *m_conns.begin();
     m_conns.pop_front();
-    if (!conn->isConnected()) {
-      invalid_conns.push_back(conn);
-      continue;
-    }
-    if ((conn->m_createTime + m_maxAliveTime) > now_ms) {
+    if (isExpired(conn, now_ms) || !CheckAlive(conn)) {
       invalid_conns.push_back(conn);
+      --m_total;
       continue;
     }
     ptr = conn;
     break;
   }
+
+  if (!ptr) {
+    if (!m_maxSize || m_total < (int32_t)m_maxSize) {
+      ++m_total;
+      create = true;
+    } else if (IOManager::GetThis()) {
+      Waiter::ptr waiter(new Waiter);
+      waiter->scheduler = Scheduler::GetThis();
+      waiter->fiber     = Fiber::GetThis();
+      m_waiters.push_back(waiter);
+
+      Timer::ptr timer;
+      if (timeout_ms != (uint64_t)-1) {
+        std::weak_ptr<Waiter>             wwaiter(waiter);
+        std::weak_ptr<HttpConnectionPool> wpool(shared_from_this());
+        timer = IOManager::GetThis()->addConditionTimer(
+            timeout_ms,
+            [wpool, wwaiter]() {
+              auto w    = wwaiter.lock();
+              auto pool = wpool.lock();
+              if (!w || !pool) { return; }
+              LockType::Lock lock(pool->m_mutex);
+              auto it = std::find(pool->m_waiters.begin(), pool->m_waiters.end(), w);
+              if (it == pool->m_waiters.end()) { return; }
+              pool->m_waiters.erase(it);
+              w->timeout = true;
+              lock.unlock();
+              w->scheduler->schedule(w->fiber);
+            },
+            wwaiter);
+      }
+      lock.unlock();
+      Fiber::Yield2Hold();
+      if (timer) { timer->cancel(); }
+      lock.lock();
+
+      if (waiter->timeout) {
+        LOG_ERROR_STREAM << "wait connection timeout: " << m_host << ":" << m_port
+                         << " timeout_ms=" << timeout_ms;
+        lock.unlock();
+        for (auto i : invalid_conns) {
+          delete i;
+        }
+        return nullptr;
+      }
+      ptr    = waiter->conn;
+      create = waiter->slot;
+    } else {
+      LOG_ERROR_STREAM << "pool full and not in IOManager: " << m_host << ":" << m_port
+                       << " max_size=" << m_maxSize;
+    }
+  }
   lock.unlock();
   for (auto i : invalid_conns) {
     delete i;
   }
-  m_total -= invalid_conns.size();
 
-  if (!ptr) {
-    IPAddress::ptr addr = Address::LookupAnyIPAddress(m_host);
+  if (ptr) {
+    ++m_reused;
+  } else if (create) {
+    Address::ptr addr = resolve();
     if (!addr) {
       LOG_ERROR_STREAM << "get addr fail: " << m_host;
+      releaseSlot();
       return nullptr;
     }
-    addr->setPort(m_port);
-    Socket::ptr sock = Socket::CreateTCP(addr);
+    Socket::ptr    sock;
+    SSLSocket::ptr ssl_sock;
+    if (m_isHttps) {
+      ssl_sock = SSLSocket::CreateTCP(addr);
+      lock.lock();
+      ssl_sock->setSession(m_sslSession);
+      lock.unlock();
+      sock = ssl_sock;
+    } else {
+      sock = Socket::CreateTCP(addr);
+    }
     if (!sock) {
       LOG_ERROR_STREAM << "create sock fail: " << *addr;
+      releaseSlot();
       return nullptr;
     }
-    if (!sock->connect(addr)) {
+    if (!sock->connect(addr, timeout_ms)) {
       LOG_ERROR_STREAM << "sock connect fail: " << *addr;
+      invalidAddress();
+      releaseSlot();
       return nullptr;
     }
+    if (ssl_sock && ssl_sock->isSessionReused()) { ++m_resumed; }
 
     ptr = new HttpConnection(sock);
-    ++m_total;
+    ++m_created;
+  } else {
+    return nullptr;
   }
-  return HttpConnection::ptr(
-      ptr, std::bind(&HttpConnectionPool::ReleasePtr, std::placeholders::_1, this));
+  // 连接可能比连接池活得久(如 HttpConnectionPoolManager::clear), 只持有弱引用
+  return HttpConnection::ptr(ptr, std::bind(&HttpConnectionPool::ReleasePtr, std::placeholders::_1,
+                                            std::weak_ptr<HttpConnectionPool>(shared_from_this())));
 }
 
-void HttpConnectionPool::ReleasePtr(HttpConnection* ptr, HttpConnectionPool* pool) {
-  ++ptr->m_request;
-  if (!ptr->isConnected() || ((ptr->m_createTime + pool->m_maxAliveTime) >= get_current_ms()) ||
-      (ptr->m_request >= pool->m_maxRequest)) {
+void HttpConnectionPool::releaseSlot() {
+  LockType::Lock lock(m_mutex);
+  if (m_waiters.empty()) {
+    --m_total;
+    return;
+  }
+  Waiter::ptr waiter = m_waiters.front();
+  m_waiters.pop_front();
+  waiter->slot = true;
+  lock.unlock();
+  waiter->scheduler->schedule(waiter->fiber);
+}
+
+Address::ptr HttpConnectionPool::resolve() {
+  static ConfigVar<uint64_t>::ptr s_dns_ttl =
+      Config::Lookup("http.pool.dns_ttl", (uint64_t)(60 * 1000), "连接池地址缓存时间ms");
+
+  uint64_t now_ms = get_current_ms();
+  {
+    LockType::Lock lock(m_mutex);
+    if (m_addr && now_ms < m_addrExpire) { return m_addr; }
+  }
+  if (!m_unixPath.empty()) { return std::make_shared<UnixAddress>(m_unixPath); }
+
+  IPAddress::ptr addr = Address::LookupAnyIPAddress(m_host);
+  if (!addr) { return nullptr; }
+  addr->setPort(m_port);
+
+  LockType::Lock lock(m_mutex);
+  m_addr       = addr;
+  m_addrExpire = now_ms + s_dns_ttl->getValue();
+  return addr;
+}
+
+void HttpConnectionPool::invalidAddress() {
+  LockType::Lock lock(m_mutex);
+  m_addr.reset();
+  m_addrExpire = 0;
+}
+
+void HttpConnectionPool::ReleasePtr(HttpConnection* ptr, std::weak_ptr<HttpConnectionPool> wpool) {
+  HttpConnectionPool::ptr pool = wpool.lock();
+  if (!pool) {
     delete ptr;
-    --pool->m_total;
     return;
   }
+  uint64_t now_ms = get_current_ms();
+  ++ptr->m_request;
+  ptr->m_lastUseTime = now_ms;
+  bool reuse         = ptr->isConnected() && !pool->isExpired(ptr, now_ms);
+
+  std::shared_ptr<SSL_SESSION> session;
+  if (pool->m_isHttps) {
+    auto ssl_sock = std::dynamic_pointer_cast<SSLSocket>(ptr->getSocket());
+    if (ssl_sock) { session = ssl_sock->getSession(); }
+  }
+
   LockType::Lock lock(pool->m_mutex);
-  pool->m_conns.push_back(ptr);
+  // 保存最新的session, 之后新建的连接可以跳过完整握手
+  if (session) { pool->m_sslSession = session; }
+  if (!pool->m_waiters.empty()) {
+    Waiter::ptr waiter = pool->m_waiters.front();
+    pool->m_waiters.pop_front();
+    if (reuse) {
+      waiter->conn = ptr;
+    } else {
+      waiter->slot = true;
+    }
+    lock.unlock();
+    if (!reuse) { delete ptr; }
+    waiter->scheduler->schedule(waiter->fiber);
+    return;
+  }
+
+  if (!reuse) {
+    --pool->m_total;
+    lock.unlock();
+    delete ptr;
+    return;
+  }
+  // 最近使用的放在队头, 空闲久的留在队尾便于回收
+  pool->m_conns.push_front(ptr);
+}
+
+void HttpConnectionPool::startIdleCheck(uint64_t max_idle_time, uint64_t interval_ms) {
+  IOManager* iom = IOManager::GetThis();
+  if (!iom) {
+    LOG_ERROR_STREAM << "startIdleCheck not in IOManager: " << m_host << ":" << m_port;
+    return;
+  }
+  stopIdleCheck();
+  m_maxIdleTime = max_idle_time;
+  std::weak_ptr<HttpConnectionPool> wpool(shared_from_this());
+  m_idleTimer = iom->addConditionTimer(
+      interval_ms,
+      [wpool]() {
+        auto pool = wpool.lock();
+        if (pool) { pool->checkIdle(); }
+      },
+      wpool, true);
+}
+
+void HttpConnectionPool::stopIdleCheck() {
+  if (m_idleTimer) {
+    m_idleTimer->cancel();
+    m_idleTimer = nullptr;
+  }
+}
+
+void HttpConnectionPool::checkIdle() {
+  uint64_t                     now_ms = get_current_ms();
+  std::vector<HttpConnection*> invalid_conns;
+  {
+    LockType::Lock lock(m_mutex);
+    for (auto it = m_conns.begin(); it != m_conns.end();) {
+      HttpConnection* conn = *it;
+      if ((m_maxIdleTime && conn->m_lastUseTime + m_maxIdleTime <= now_ms) ||
+          isExpired(conn, now_ms) || !conn->isConnected()) {
+        invalid_conns.push_back(conn);
+        it = m_conns.erase(it);
+        --m_total;
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (auto i : invalid_conns) {
+    delete i;
+  }
+  if (!invalid_conns.empty()) {
+    LOG_DEBUG_STREAM << "checkIdle " << m_host << ":" << m_port
+                     << " evict=" << invalid_conns.size();
+  }
+}
+
+uint32_t HttpConnectionPool::getIdle() {
+  LockType::Lock lock(m_mutex);
+  return m_conns.size();
+}
+
+std::string HttpConnectionPool::to_string() {
+  std::stringstream ss;
+  ss << "[HttpConnectionPool host=" << m_host << " port=" << m_port << " https=" << m_isHttps
+     << (m_unixPath.empty() ? "" : " unix=" + m_unixPath)
+     << " total=" << m_total << " idle=" << getIdle() << " created=" << m_created
+     << " reused=" << m_reused << " resumed=" << m_resumed << " max_size=" << m_maxSize << "]";
+  return ss.str();
 }
 
 HttpResult::ptr HttpConnectionPool::doGet(const std::string& url, uint64_t timeout_ms,
@@ -404,7 +674,20 @@ HttpResult::ptr HttpConnectionPool::doRequest(HttpMethod method, Uri::ptr uri, u
 }
 
 HttpResult::ptr HttpConnectionPool::doRequest(HttpRequest::ptr req, uint64_t timeout_ms) {
-  auto conn = getConnection();
+  return doRequest(req, timeout_ms, nullptr);
+}
+
+HttpResult::ptr HttpConnectionPool::doRequest(HttpRequest::ptr req, uint64_t timeout_ms,
+                                              HttpConnection::BodyCallback cb) {
+  // 继承调用方协程的截止时间
+  timeout_ms = std::min(timeout_ms, CancelToken::Remaining());
+  if (timeout_ms == 0) {
+    return std::make_shared<HttpResult>(
+        (int)(CancelToken::Check() == ECANCELED ? HttpResult::Error::CANCELLED
+                                                : HttpResult::Error::TIMEOUT),
+        nullptr, "deadline exceeded before request, host:" + m_host);
+  }
+  auto conn = getConnection(timeout_ms);
   if (!conn) {
     return std::make_shared<HttpResult>((int)HttpResult::Error::POOL_GET_CONNECTION, nullptr,
                                         "pool host:" + m_host + " port:" + std::to_string(m_port));
@@ -417,23 +700,316 @@ HttpResult::ptr HttpConnectionPool::doRequest(HttpRequest::ptr req, uint64_t tim
   sock->setRecvTimeout(timeout_ms);
   int rt = conn->sendRequest(req);
   if (rt == 0) {
+    conn->close();
     return std::make_shared<HttpResult>(
         (int)HttpResult::Error::SEND_CLOSE_BY_PEER, nullptr,
         "send request closed by peer: " + sock->getRemoteAddress()->to_string());
   }
   if (rt < 0) {
+    conn->close();
     return std::make_shared<HttpResult>((int)HttpResult::Error::SEND_SOCKET_ERROR, nullptr,
                                         "send request socket error errno=" + std::to_string(errno) +
                                             " errstr=" + std::string(strerror(errno)));
   }
-  auto rsp = conn->recvResponse();
+  auto rsp = cb ? conn->recvResponse(cb) : conn->recvResponse();
   if (!rsp) {
+    if (CancelToken::Check() == ECANCELED) {
+      return std::make_shared<HttpResult>(
+          (int)HttpResult::Error::CANCELLED, nullptr,
+          "request cancelled: " + sock->getRemoteAddress()->to_string());
+    }
     return std::make_shared<HttpResult>(
         (int)HttpResult::Error::TIMEOUT, nullptr,
         "recv response timeout: " + sock->getRemoteAddress()->to_string() +
             " timeout_ms:" + std::to_string(timeout_ms));
   }
+  // 对端要求关闭的连接不再放回池中
+  std::string conn_header = rsp->getHeader("connection");
+  if (strcasecmp(conn_header.c_str(), "close") == 0 ||
+      (rsp->getVersion() == 0x10 && strcasecmp(conn_header.c_str(), "keep-alive") != 0)) {
+    conn->close();
+  }
   return std::make_shared<HttpResult>((int)HttpResult::Error::OK, rsp, "ok");
 }
 
-}  // namespace http
\ No newline at end of file
+namespace {
+
+struct BatchContext {
+  typedef std::shared_ptr<BatchContext> ptr;
+
+  Mutex                                     mutex;
+  std::vector<HttpConnectionPool::BatchJob> jobs;
+  std::vector<HttpResult::ptr>              results;
+  std::vector<HttpResult::ptr>              errors;    /// hedge时先失败的一次结果
+  std::vector<uint32_t>                     inflight;  /// 每个请求进行中的次数
+  std::vector<Timer::ptr>                   timers;
+  size_t                                    done      = 0;
+  size_t                                    ok        = 0;
+  uint32_t                                  first_n   = 0;
+  uint64_t                                  timeout   = 0;
+  uint64_t                                  deadline  = -1;
+  bool                                      finished  = false;
+  Scheduler*                                scheduler = nullptr;
+  Fiber::ptr                                fiber;
+  CancelToken::ptr                          token;  /// 请求协程继承, 批量结束时取消未完成的请求
+};
+
+void BatchFinish(BatchContext::ptr ctx, Mutex::Lock& lock) {
+  ctx->finished = true;
+  lock.unlock();
+  ctx->scheduler->schedule(ctx->fiber);
+}
+
+void BatchComplete(BatchContext::ptr ctx, size_t idx, HttpResult::ptr r) {
+  Mutex::Lock lock(ctx->mutex);
+  --ctx->inflight[idx];
+  if (ctx->finished || ctx->results[idx]) { return; }
+  if (r->result != (int)HttpResult::Error::OK && ctx->inflight[idx] > 0) {
+    ctx->errors[idx] = r;
+    return;
+  }
+  ctx->results[idx] = r;
+  ++ctx->done;
+  if (r->result == (int)HttpResult::Error::OK) { ++ctx->ok; }
+  if (ctx->done == ctx->results.size() || (ctx->first_n && ctx->ok >= ctx->first_n)) {
+    BatchFinish(ctx, lock);
+  }
+}
+
+void BatchLaunch(BatchContext::ptr ctx, size_t idx) {
+  IOManager::GetThis()->schedule([ctx, idx]() {
+    CancelScope scope(ctx->token);
+    uint64_t    timeout = ctx->timeout;
+    if (ctx->deadline != (uint64_t)-1) {
+      uint64_t now = get_current_ms();
+      timeout      = std::min(timeout, ctx->deadline > now ? ctx->deadline - now : 0);
+    }
+    HttpResult::ptr r;
+    if (timeout == 0) {
+      r = std::make_shared<HttpResult>((int)HttpResult::Error::TIMEOUT, nullptr, "batch timeout");
+    } else {
+      r = ctx->jobs[idx](timeout);
+    }
+    if (!r) {
+      r = std::make_shared<HttpResult>((int)HttpResult::Error::CANCELLED, nullptr, "empty result");
+    }
+    BatchComplete(ctx, idx, r);
+  });
+}
+
+}  // namespace
+
+std::vector<HttpResult::ptr> HttpConnectionPool::DoBatch(const std::vector<BatchJob>& jobs,
+                                                         uint64_t                     timeout_ms,
+                                                         const HttpBatchOptions&      opts) {
+  std::vector<HttpResult::ptr> results;
+  if (jobs.empty()) { return results; }
+  // 整体超时不超过调用方协程的剩余时间
+  uint64_t batch_timeout = std::min(opts.timeout_ms, CancelToken::Remaining());
+  uint64_t deadline =
+      batch_timeout == (uint64_t)-1 ? (uint64_t)-1 : get_current_ms() + batch_timeout;
+
+  IOManager* iom = IOManager::GetThis();
+  if (!iom) {
+    size_t ok = 0;
+    for (auto& job : jobs) {
+      uint64_t now = get_current_ms();
+      if ((opts.first_n && ok >= opts.first_n) || (deadline != (uint64_t)-1 && now >= deadline)) {
+        results.push_back(std::make_shared<HttpResult>(
+            (int)(opts.first_n && ok >= opts.first_n ? HttpResult::Error::CANCELLED
+                                                     : HttpResult::Error::TIMEOUT),
+            nullptr, "batch finished"));
+        continue;
+      }
+      auto r = job(deadline == (uint64_t)-1 ? timeout_ms : std::min(timeout_ms, deadline - now));
+      if (r && r->result == (int)HttpResult::Error::OK) { ++ok; }
+      results.push_back(r);
+    }
+    return results;
+  }
+
+  BatchContext::ptr ctx(new BatchContext);
+  ctx->results.resize(jobs.size());
+  ctx->errors.resize(jobs.size());
+  ctx->inflight.resize(jobs.size(), 1);
+  ctx->jobs      = jobs;
+  ctx->first_n   = opts.first_n;
+  ctx->timeout   = timeout_ms;
+  ctx->deadline  = deadline;
+  ctx->scheduler = Scheduler::GetThis();
+  ctx->fiber     = Fiber::GetThis();
+  ctx->token     = CancelToken::Create(batch_timeout);
+
+  std::weak_ptr<BatchContext> wctx(ctx);
+  {
+    Mutex::Lock lock(ctx->mutex);
+    if (batch_timeout != (uint64_t)-1) {
+      ctx->timers.push_back(iom->addConditionTimer(
+          batch_timeout,
+          [wctx]() {
+            auto ctx = wctx.lock();
+            if (!ctx) { return; }
+            Mutex::Lock lock(ctx->mutex);
+            if (!ctx->finished) { BatchFinish(ctx, lock); }
+          },
+          wctx));
+    }
+    if (opts.hedge_ms) {
+      for (size_t i = 0; i < jobs.size(); ++i) {
+        ctx->timers.push_back(iom->addConditionTimer(
+            opts.hedge_ms,
+            [wctx, i]() {
+              auto ctx = wctx.lock();
+              if (!ctx) { return; }
+              Mutex::Lock lock(ctx->mutex);
+              if (ctx->finished || ctx->results[i]) { return; }
+              ++ctx->inflight[i];
+              lock.unlock();
+              BatchLaunch(ctx, i);
+            },
+            wctx));
+      }
+    }
+  }
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    BatchLaunch(ctx, i);
+  }
+  Fiber::Yield2Hold();
+
+  ctx->token->cancel();
+  Mutex::Lock lock(ctx->mutex);
+  for (auto& i : ctx->timers) {
+    i->cancel();
+  }
+  bool enough = ctx->first_n && ctx->ok >= ctx->first_n;
+  for (size_t i = 0; i < ctx->results.size(); ++i) {
+    if (ctx->results[i]) { continue; }
+    if (ctx->errors[i]) {
+      ctx->results[i] = ctx->errors[i];
+    } else if (enough) {
+      ctx->results[i] = std::make_shared<HttpResult>((int)HttpResult::Error::CANCELLED, nullptr,
+                                                     "batch finished early");
+    } else {
+      ctx->results[i] = std::make_shared<HttpResult>(
+          (int)HttpResult::Error::TIMEOUT, nullptr,
+          "batch timeout_ms:" + std::to_string(batch_timeout));
+    }
+  }
+  results = ctx->results;
+  return results;
+}
+
+std::vector<HttpResult::ptr> HttpConnectionPool::doBatch(const std::vector<HttpRequest::ptr>& reqs,
+                                                         uint64_t                timeout_ms,
+                                                         const HttpBatchOptions& opts) {
+  // 提前返回后请求仍可能在后台进行, job 持有连接池
+  HttpConnectionPool::ptr self = shared_from_this();
+  std::vector<BatchJob>   jobs;
+  for (auto& req : reqs) {
+    jobs.push_back([self, req](uint64_t timeout) { return self->doRequest(req, timeout); });
+  }
+  return DoBatch(jobs, timeout_ms, opts);
+}
+
+static ConfigVar<uint32_t>::ptr g_http_pool_max_size =
+    Config::Lookup("http.pool.max_size", (uint32_t)64, "单个host连接池最大连接数");
+
+static ConfigVar<uint32_t>::ptr g_http_pool_max_alive_time =
+    Config::Lookup("http.pool.max_alive_time", (uint32_t)(120 * 1000), "连接最长存活时间ms");
+
+static ConfigVar<uint32_t>::ptr g_http_pool_max_request =
+    Config::Lookup("http.pool.max_request", (uint32_t)1000, "单个连接最多处理的请求数");
+
+static ConfigVar<uint64_t>::ptr g_http_pool_max_idle_time =
+    Config::Lookup("http.pool.max_idle_time", (uint64_t)(30 * 1000), "连接最长空闲时间ms");
+
+HttpConnectionPool::ptr HttpConnectionPoolManager::get(Uri::ptr uri) {
+  return get(uri->getSchema(), uri->getHost(), uri->getPort());
+}
+
+HttpConnectionPool::ptr HttpConnectionPoolManager::get(const std::string& scheme,
+                                                       const std::string& host, uint32_t port) {
+  std::string key = scheme + "://" + host + ":" + std::to_string(port);
+  {
+    LockType::ReadLock lock(m_mutex);
+    auto               it = m_pools.find(key);
+    if (it != m_pools.end()) { return it->second; }
+  }
+
+  LockType::WriteLock lock(m_mutex);
+  auto                it = m_pools.find(key);
+  if (it != m_pools.end()) { return it->second; }
+
+  HttpConnectionPool::ptr pool(new HttpConnectionPool(
+      host, "", port, g_http_pool_max_size->getValue(), g_http_pool_max_alive_time->getValue(),
+      g_http_pool_max_request->getValue(), scheme == "https"));
+  m_pools[key] = pool;
+  lock.unlock();
+
+  uint64_t max_idle = g_http_pool_max_idle_time->getValue();
+  if (max_idle && IOManager::GetThis()) { pool->startIdleCheck(max_idle, max_idle / 2 + 1); }
+  return pool;
+}
+
+HttpResult::ptr HttpConnectionPoolManager::doGet(const std::string& url, uint64_t timeout_ms,
+                                                 const std::map<std::string, std::string>& headers,
+                                                 const std::string&                        body) {
+  return doRequest(HttpMethod::GET, url, timeout_ms, headers, body);
+}
+
+HttpResult::ptr HttpConnectionPoolManager::doPost(const std::string& url, uint64_t timeout_ms,
+                                                  const std::map<std::string, std::string>& headers,
+                                                  const std::string&                        body) {
+  return doRequest(HttpMethod::POST, url, timeout_ms, headers, body);
+}
+
+HttpResult::ptr HttpConnectionPoolManager::doRequest(
+    HttpMethod method, const std::string& url, uint64_t timeout_ms,
+    const std::map<std::string, std::string>& headers, const std::string& body) {
+  Uri::ptr uri = Uri::Create(url);
+  if (!uri) {
+    return std::make_shared<HttpResult>((int)HttpResult::Error::INVALID_URL, nullptr,
+                                        "invalid url: " + url);
+  }
+  return doRequest(method, uri, timeout_ms, headers, body);
+}
+
+HttpResult::ptr HttpConnectionPoolManager::doRequest(
+    HttpMethod method, Uri::ptr uri, uint64_t timeout_ms,
+    const std::map<std::string, std::string>& headers, const std::string& body) {
+  if (uri->getHost().empty()) {
+    return std::make_shared<HttpResult>((int)HttpResult::Error::INVALID_HOST, nullptr,
+                                        "invalid host: " + uri->to_string());
+  }
+  return get(uri)->doRequest(method, uri, timeout_ms, headers, body);
+}
+
+std::vector<HttpResult::ptr> HttpConnectionPoolManager::doBatch(
+    HttpMethod method, const std::vector<std::string>& urls, uint64_t timeout_ms,
+    const HttpBatchOptions& opts) {
+  std::vector<HttpConnectionPool::BatchJob> jobs;
+  for (auto& url : urls) {
+    jobs.push_back(
+        [this, method, url](uint64_t timeout) { return doRequest(method, url, timeout); });
+  }
+  return HttpConnectionPool::DoBatch(jobs, timeout_ms, opts);
+}
+
+void HttpConnectionPoolManager::clear() {
+  LockType::WriteLock lock(m_mutex);
+  for (auto& i : m_pools) {
+    i.second->stopIdleCheck();
+  }
+  m_pools.clear();
+}
+
+std::string HttpConnectionPoolManager::to_string() {
+  std::stringstream  ss;
+  LockType::ReadLock lock(m_mutex);
+  for (auto& i : m_pools) {
+    ss << i.first << " " << i.second->to_string() << std::endl;
+  }
+  return ss.str();
+}
+
+}  // namespace http
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <functional>
 #include <list>
+#include <unordered_map>
 
+#include "basic/iomanager.h"
+#include "basic/singleton.h"
 #include "basic/uri.h"
 #include "http/http.h"
 #include "stream/socket_stream.h"
@@ -22,6 +26,7 @@ struct HttpResult {
     CREATE_SOCKET_ERROR     = 7,  /// 创建Socket失败
     POOL_GET_CONNECTION     = 8,  /// 从连接池中取连接失败
     POOL_INVALID_CONNECTION = 9,  /// 无效的连接
+    CANCELLED               = 10,  /// 批量请求提前结束或协程令牌被取消, 请求未完成
   };
 
   HttpResult(int _result, HttpResponse::ptr _response, const std::string& _error)
@@ -34,6 +39,15 @@ struct HttpResult {
   std::string to_string() const;
 };
 
+/**
+ * @brief 批量请求选项
+ */
+struct HttpBatchOptions {
+  uint64_t timeout_ms = -1;  /// 整体超时, 到期未完成的请求结果为 TIMEOUT
+  uint32_t first_n    = 0;   /// 非0时成功 first_n 个即返回, 未完成的请求结果为 CANCELLED
+  uint64_t hedge_ms   = 0;   /// 非0时请求超过该时间未完成则再发一次相同请求, 取先成功的结果
+};
+
 class HttpConnectionPool;
 
 class HttpConnection : public SocketStream {
@@ -41,6 +55,8 @@ class HttpConnection : public SocketStream {
 
 public:
   typedef std::shared_ptr<HttpConnection> ptr;
+  /// 响应体分段回调, 返回false时中止接收并关闭连接
+  typedef std::function<bool(const char* data, size_t len)> BodyCallback;
 
   static HttpResult::ptr DoGet(const std::string& url, uint64_t timeout_ms,
                                const std::map<std::string, std::string>& headers = {},
@@ -68,25 +84,98 @@ public:
 
   static HttpResult::ptr DoRequest(HttpRequest::ptr req, Uri::ptr uri, uint64_t timeout_ms);
 
+  /**
+   * @brief 流式请求, 响应体交给cb, 返回的response不含body
+   */
+  static HttpResult::ptr DoRequest(HttpRequest::ptr req, Uri::ptr uri, uint64_t timeout_ms,
+                                   BodyCallback cb);
+
   HttpConnection(Socket::ptr sock, bool owner = true);
   ~HttpConnection();
+
+  /**
+   * @brief 接收响应, body 超过 http.response.max_body_size 时失败
+   */
   HttpResponse::ptr recvResponse();
-  int               sendRequest(HttpRequest::ptr req);
+
+  /**
+   * @brief 流式接收响应, chunked 与 content-length 的 body 都按段交给 cb
+   * @details 只使用 http.response.buffer_size 大小的缓冲区, 返回的response不含body
+   */
+  HttpResponse::ptr recvResponse(BodyCallback cb);
+
+  /**
+   * @brief 流式接收响应, body 写入 out
+   */
+  HttpResponse::ptr recvResponse(Stream::ptr out);
+
+  int sendRequest(HttpRequest::ptr req);
 
 private:
-  uint64_t m_createTime = 0;
-  uint64_t m_request    = 0;
+  uint64_t m_createTime  = 0;
+  uint64_t m_lastUseTime = 0;
+  uint64_t m_request     = 0;
 };
 
-class HttpConnectionPool {
+/**
+ * @brief 单个 scheme/host/port 的连接池
+ * @details max_size 为 0 时不限制连接数; 连接数达到上限时, 协程挂起等待归还的连接.
+ *          请求的超时时间不超过调用方协程 CancelToken 的剩余时间
+ */
+class HttpConnectionPool : public std::enable_shared_from_this<HttpConnectionPool> {
 public:
-  typedef std::shared_ptr<HttpConnectionPool> ptr;
-  typedef Mutex                               LockType;
-
+  typedef std::shared_ptr<HttpConnectionPool>                 ptr;
+  typedef Mutex                                               LockType;
+  typedef std::function<HttpResult::ptr(uint64_t timeout_ms)> BatchJob;
+
+  /**
+   * @brief 在当前IOManager上每个job一个协程并发执行, 结果与jobs顺序一致
+   * @param[in] timeout_ms 单个请求的超时时间, 不超过整体剩余时间
+   * @details 不在IOManager中时顺序执行. 请求协程继承调用方的 CancelToken, 提前返回时取消仍在
+   *          进行的请求, 结果被丢弃. 开启 hedge_ms 时同一个请求可能被发送两次, 只应用于幂等请求
+   */
+  static std::vector<HttpResult::ptr> DoBatch(const std::vector<BatchJob>& jobs,
+                                              uint64_t                     timeout_ms,
+                                              const HttpBatchOptions&      opts = {});
+
+  /// 连接和请求会调用 shared_from_this, 连接池必须由 shared_ptr 持有
   HttpConnectionPool(const std::string& host, const std::string& vhost, uint32_t port,
-                     uint32_t max_size, uint32_t max_alive_time, uint32_t max_request);
-
-  HttpConnection::ptr getConnection();
+                     uint32_t max_size, uint32_t max_alive_time, uint32_t max_request,
+                     bool is_https = false);
+  ~HttpConnectionPool();
+
+  /**
+   * @brief 连接 unix socket 的连接池, 用于同机进程间通信
+   * @param[in] vhost 请求的 Host 头, 为空时使用 localhost
+   */
+  static HttpConnectionPool::ptr CreateUnix(const std::string& path, const std::string& vhost,
+                                            uint32_t max_size, uint32_t max_alive_time,
+                                            uint32_t max_request);
+
+  /**
+   * @brief 获取连接
+   * @param[in] timeout_ms 等待空闲连接以及建立连接的超时时间
+   * @return 失败返回nullptr
+   */
+  HttpConnection::ptr getConnection(uint64_t timeout_ms = -1);
+
+  /**
+   * @brief 在当前IOManager上启动空闲连接回收定时器
+   * @param[in] max_idle_time 连接空闲超过该时间(ms)被关闭
+   * @param[in] interval_ms 检查间隔
+   */
+  void startIdleCheck(uint64_t max_idle_time, uint64_t interval_ms);
+  void stopIdleCheck();
+  void checkIdle();
+
+  uint32_t getTotal() const { return m_total; }
+  uint32_t getIdle();
+  uint64_t getCreated() const { return m_created; }
+  uint64_t getReused() const { return m_reused; }
+  /// https 新建连接中恢复了session的数量
+  uint64_t getResumed() const { return m_resumed; }
+
+  std::string to_string();
 
   HttpResult::ptr doGet(const std::string& url, uint64_t timeout_ms,
                         const std::map<std::string, std::string>& headers = {},
@@ -114,20 +203,96 @@ public:
 
   HttpResult::ptr doRequest(HttpRequest::ptr req, uint64_t timeout_ms);
 
+  /// 流式请求, 响应体交给cb
+  HttpResult::ptr doRequest(HttpRequest::ptr req, uint64_t timeout_ms,
+                            HttpConnection::BodyCallback cb);
+
+  /// 并发发送一组请求, 共用本连接池的连接, 见 DoBatch
+  std::vector<HttpResult::ptr> doBatch(const std::vector<HttpRequest::ptr>& reqs,
+                                       uint64_t timeout_ms, const HttpBatchOptions& opts = {});
+
 private:
-  static void ReleasePtr(HttpConnection* ptr, HttpConnectionPool* pool);
+  static void ReleasePtr(HttpConnection* ptr, std::weak_ptr<HttpConnectionPool> wpool);
+
+  /// 等待连接的协程, 被唤醒时 conn 非空表示直接交接的连接, slot 为 true 表示可新建连接
+  struct Waiter {
+    typedef std::shared_ptr<Waiter> ptr;
+    Scheduler*      scheduler = nullptr;
+    Fiber::ptr      fiber;
+    HttpConnection* conn    = nullptr;
+    bool            slot    = false;
+    bool            timeout = false;
+  };
+
+  bool         isExpired(HttpConnection* conn, uint64_t now_ms) const;
+  void         releaseSlot();
+  Address::ptr resolve();
+  void         invalidAddress();
 
 private:
   std::string m_host;
   std::string m_vhost;
+  std::string m_unixPath;
   uint32_t    m_port;
   uint32_t    m_maxSize;
   uint32_t    m_maxAliveTime;
   uint32_t    m_maxRequest;
+  uint64_t    m_maxIdleTime = 0;
+  bool        m_isHttps;
 
   LockType                   m_mutex;
   std::list<HttpConnection*> m_conns;
+  std::list<Waiter::ptr>     m_waiters;
   std::atomic<int32_t>       m_total = {0};
+
+  Address::ptr                 m_addr;
+  uint64_t                     m_addrExpire = 0;
+  Timer::ptr                   m_idleTimer;
+  std::shared_ptr<SSL_SESSION> m_sslSession;
+
+  std::atomic<uint64_t> m_created = {0};
+  std::atomic<uint64_t> m_reused  = {0};
+  std::atomic<uint64_t> m_resumed = {0};
+};
+
+/**
+ * @brief 按 scheme://host:port 管理连接池
+ */
+class HttpConnectionPoolManager {
+public:
+  typedef RWMutex LockType;
+
+  HttpConnectionPool::ptr get(Uri::ptr uri);
+  HttpConnectionPool::ptr get(const std::string& scheme, const std::string& host, uint32_t port);
+
+  HttpResult::ptr doGet(const std::string& url, uint64_t timeout_ms,
+                        const std::map<std::string, std::string>& headers = {},
+                        const std::string&                        body    = "");
+
+  HttpResult::ptr doPost(const std::string& url, uint64_t timeout_ms,
+                         const std::map<std::string, std::string>& headers = {},
+                         const std::string&                        body    = "");
+
+  HttpResult::ptr doRequest(HttpMethod method, const std::string& url, uint64_t timeout_ms,
+                            const std::map<std::string, std::string>& headers = {},
+                            const std::string&                        body    = "");
+
+  HttpResult::ptr doRequest(HttpMethod method, Uri::ptr uri, uint64_t timeout_ms,
+                            const std::map<std::string, std::string>& headers = {},
+                            const std::string&                        body    = "");
+
+  /// 并发请求多个url, 各自使用对应host的连接池, 见 HttpConnectionPool::DoBatch
+  std::vector<HttpResult::ptr> doBatch(HttpMethod method, const std::vector<std::string>& urls,
+                                       uint64_t timeout_ms, const HttpBatchOptions& opts = {});
+
+  void        clear();
+  std::string to_string();
+
+private:
+  LockType                                                 m_mutex;
+  std::unordered_map<std::string, HttpConnectionPool::ptr> m_pools;
 };
 
+typedef Singleton<HttpConnectionPoolManager> HttpConnectionPoolMgr;
+
 }  // namespace http
\ No newline at end of file
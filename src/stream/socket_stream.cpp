@@ -42,6 +42,24 @@ int SocketStream::write(ByteArray::ptr ba, size_t length) {
   return rt;
 }
 
+int SocketStream::read(BufferChain::ptr chain, size_t length) {
+  if (!isConnected()) { return -1; }
+  std::vector<iovec> iovs;
+  if (chain->getWriteBuffers(iovs, length) == 0) { return 0; }
+  int rt = m_socket->recv(&iovs[0], iovs.size());
+  chain->commit(rt > 0 ? rt : 0);
+  return rt;
+}
+
+int SocketStream::write(BufferChain::ptr chain, size_t length) {
+  if (!isConnected()) { return -1; }
+  std::vector<iovec> iovs;
+  if (chain->getReadBuffers(iovs, length) == 0) { return 0; }
+  int rt = m_socket->send(&iovs[0], iovs.size());
+  if (rt > 0) { chain->consume(rt); }
+  return rt;
+}
+
 void SocketStream::close() {
   if (m_socket) { m_socket->close(); }
 }
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <memory>
 
 #include "basic/socket.h"
@@ -15,6 +17,9 @@ public:
   virtual int  read(ByteArray::ptr ba, size_t length) override;
   virtual int  write(const void* buffer, size_t length) override;
   virtual int  write(ByteArray::ptr ba, size_t length) override;
+  // 直接收发链中节点的内存, 不经过中间缓冲区
+  virtual int  read(BufferChain::ptr chain, size_t length) override;
+  virtual int  write(BufferChain::ptr chain, size_t length) override;
   virtual void close() override;
 
   Socket::ptr getSocket() const { return m_socket; }
@@ -0,0 +1,148 @@
+#include <sched.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "basic/channel.h"
+#include "basic/config.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+
+using namespace Basic;
+
+static std::string to_cpu_list(const std::vector<int>& cpus) {
+  std::string rt;
+  for (int i : cpus) {
+    rt += (rt.empty() ? "" : ",") + std::to_string(i);
+  }
+  return rt;
+}
+
+static void set_affinity(const std::string& name, const std::string& value) {
+  auto var   = Config::Lookup("scheduler.affinity", std::map<std::string, std::string>());
+  auto conf  = var->getValue();
+  conf[name] = value;
+  var->setValue(conf);
+}
+
+void test_parse() {
+  ASSERT(parse_cpu_list("0-3,8,10-11") == std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+  ASSERT(parse_cpu_list(" 5 , 1-2,2") == std::vector<int>({1, 2, 5}));
+  ASSERT(parse_cpu_list("").empty());
+  ASSERT(parse_cpu_list("3-1").empty());
+  ASSERT(parse_cpu_list("a").empty());
+  ASSERT(parse_cpu_list("1-").empty());
+  ASSERT(get_numa_node_count() >= 1);
+  ASSERT(!get_numa_node_cpus(0).empty());
+}
+
+// 绑核后工作线程只在指定cpu上运行
+void test_pin(const std::string& value, const std::vector<int>& cpus) {
+  set_affinity("aff_pin", value);
+  IOManager        iom(2, "aff_pin", false);
+  std::atomic<int> bad{0};
+  for (int i = 0; i < 100; ++i) {
+    iom.schedule([&]() {
+      int cpu = sched_getcpu();
+      if (std::find(cpus.begin(), cpus.end(), cpu) == cpus.end()) { ++bad; }
+    });
+  }
+  iom.stop();
+  ASSERT(bad == 0);
+}
+
+/**
+ * 两个调度器之间的往返延迟, 每轮接收方读取发送方刚写入的缓冲区,
+ * 模拟连接缓冲区在线程间传递; a 固定在 node_a, b 分别在 node_a(本地) 和 node_b(远端)
+ */
+uint64_t bench_ping_pong(const std::string& name, const std::vector<int>& node_a,
+                         const std::vector<int>& node_b) {
+  static const int    s_rounds = 20000;
+  static const size_t s_buffer = 16 * 1024;
+
+  set_affinity(name + "_a", to_cpu_list(node_a));
+  set_affinity(name + "_b", to_cpu_list(node_b));
+  IOManager a(1, name + "_a", false);
+  IOManager b(1, name + "_b", false);
+
+  Channel<char*>::ptr ping(new Channel<char*>(1));
+  Channel<char*>::ptr pong(new Channel<char*>(1));
+  std::vector<char>   buffer(s_buffer);
+  WaitGroup           wg;
+  uint64_t            used = 0;
+
+  wg.add(2);
+  b.schedule([&]() {
+    char*    buf = nullptr;
+    uint64_t sum = 0;
+    while (ping->recv(buf)) {
+      for (size_t i = 0; i < s_buffer; i += 64) {
+        sum += buf[i];
+      }
+      pong->send(buf);
+    }
+    ASSERT(sum > 0);
+    wg.done();
+  });
+  a.schedule([&]() {
+    char* buf = nullptr;
+    // a 上首次写入, 页面落在 node_a
+    memset(&buffer[0], 1, s_buffer);
+    uint64_t begin = get_current_us();
+    for (int i = 0; i < s_rounds; ++i) {
+      memset(&buffer[0], i & 0x7f, s_buffer);
+      ping->send(&buffer[0]);
+      pong->recv(buf);
+    }
+    used = get_current_us() - begin;
+    ping->close();
+    wg.done();
+  });
+  wg.wait();
+  a.stop();
+  b.stop();
+
+  uint64_t rtt_ns = used * 1000 / s_rounds;
+  LOG_ERROR_STREAM << name << " a=" << to_cpu_list(node_a) << " b=" << to_cpu_list(node_b)
+                   << " rounds=" << s_rounds << " rtt_ns=" << rtt_ns;
+  return rtt_ns;
+}
+
+void bench() {
+  std::vector<int> node_a;
+  std::vector<int> node_b;
+  std::string      topology;
+  if (get_numa_node_count() >= 2) {
+    node_a   = get_numa_node_cpus(0);
+    node_b   = get_numa_node_cpus(1);
+    topology = "numa";
+  } else {
+    // 只有一个节点时把cpu分成两半模拟两个节点, 只能体现跨核而非跨节点的差异
+    std::vector<int> cpus = get_numa_node_cpus(0);
+    size_t           half = std::max<size_t>(cpus.size() / 2, 1);
+    node_a.assign(cpus.begin(), cpus.begin() + half);
+    node_b.assign(cpus.size() > 1 ? cpus.begin() + half : cpus.begin(), cpus.end());
+    topology = "simulated";
+  }
+  // 同一节点内 a 和 b 用不同的cpu
+  std::vector<int> local_b = node_a.size() > 1 ? std::vector<int>(node_a.begin() + 1, node_a.end())
+                                               : node_a;
+  std::vector<int> local_a = {node_a[0]};
+
+  uint64_t local  = bench_ping_pong("aff_local", local_a, local_b);
+  uint64_t remote = bench_ping_pong("aff_remote", local_a, node_b);
+  LOG_ERROR_STREAM << "topology=" << topology << " nodes=" << get_numa_node_count()
+                   << " local_rtt_ns=" << local << " remote_rtt_ns=" << remote
+                   << " delta_ns=" << (int64_t)(remote - local);
+}
+
+int main(int argc, char* argv[]) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  test_parse();
+  test_pin("node:0", get_numa_node_cpus(0));
+  test_pin(std::to_string(get_numa_node_cpus(0).back()), {get_numa_node_cpus(0).back()});
+  bench();
+  LOG_ERROR_STREAM << "test_affinity ok";
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <stdexcept>
+
+#include "basic/blocking.h"
+#include "basic/fiber_sync.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+
+using namespace Basic;
+
+// 阻塞调用在线程池中执行, 协程回到原线程, 同一线程上的其它协程不受影响
+void test_run(IOManager& iom) {
+  WaitGroup         wg;
+  std::atomic<bool> other_done{false};
+  wg.add(2);
+  iom.schedule([&]() {
+    int  tid    = get_thread_id();
+    int  pool   = 0;
+    bool before = other_done;
+    int  rt     = Blocking::run([&pool, &other_done]() {
+      pool = get_thread_id();
+      // 线程池线程没有开启hook, 真正阻塞100ms
+      for (int i = 0; i < 100 && !other_done; ++i) {
+        usleep(1000);
+      }
+      return 42;
+    });
+    ASSERT(rt == 42);
+    ASSERT(pool != tid);
+    ASSERT(get_thread_id() == tid);
+    ASSERT(!before && other_done);
+    wg.done();
+  });
+  iom.schedule([&]() {
+    other_done = true;
+    wg.done();
+  });
+  wg.wait();
+
+  // 异常带回调用方
+  wg.add();
+  iom.schedule([&]() {
+    bool caught = false;
+    try {
+      Blocking::run([]() { throw std::runtime_error("blocking"); });
+    } catch (std::runtime_error& e) { caught = true; }
+    ASSERT(caught);
+    wg.done();
+  });
+  wg.wait();
+
+  // 不在协程中直接执行
+  ASSERT(!Blocking::CanSuspend());
+  ASSERT(Blocking::run([]() { return get_thread_id(); }) == get_thread_id());
+}
+
+// 协程中的文件操作经过线程池, errno 正确带回
+void test_file_hook(IOManager& iom) {
+  WaitGroup wg;
+  wg.add();
+  iom.schedule([&]() {
+    uint64_t    submitted = Blocking::GetStats().submitted;
+    std::string path      = "/tmp/test_blocking_" + std::to_string(getpid());
+
+    ASSERT(open("/nonexistent/test_blocking", O_RDONLY) == -1 && errno == ENOENT);
+    int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    ASSERT(fd >= 0);
+    ASSERT(write(fd, "hello", 5) == 5);
+    ASSERT(fsync(fd) == 0);
+    char buf[8] = {0};
+    ASSERT(pread(fd, buf, 5, 0) == 5 && std::string(buf) == "hello");
+    close(fd);
+
+    struct stat st;
+    ASSERT(stat(path.c_str(), &st) == 0 && st.st_size == 5);
+    ASSERT(unlink(path.c_str()) == 0);
+    ASSERT(stat(path.c_str(), &st) == -1 && errno == ENOENT);
+
+    // open x2, write, fsync, pread, stat x2, unlink
+    ASSERT(Blocking::GetStats().submitted - submitted >= 8);
+    wg.done();
+  });
+  wg.wait();
+  LOG_INFO_STREAM << Blocking::ToString();
+}
+
+// 协程在线程池中执行时停止调度器, stop 等协程恢复执行完再返回
+void test_stop() {
+  std::atomic<bool> resumed{false};
+  IOManager         iom(1, "test_blocking_stop", false);
+  iom.schedule([&resumed]() {
+    Blocking::run([]() { usleep(300 * 1000); });
+    resumed = true;
+  });
+  usleep(50 * 1000);
+  iom.stop();
+  ASSERT(resumed);
+}
+
+int main(int argc, char* argv[]) {
+  test_stop();
+  IOManager iom(1, "test_blocking", false);
+  test_run(iom);
+  test_file_hook(iom);
+  LOG_INFO("test_blocking ok");
+  return 0;
+}
@@ -0,0 +1,153 @@
+#include <stdexcept>
+
+#include "basic/buffer_chain.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/socket.h"
+#include "stream/socket_stream.h"
+
+using namespace Basic;
+
+void test_chain() {
+  BufferChain a(8);
+  a.append("hello world, buffer chain");
+  ASSERT(a.getSize() == 25 && a.getBlockCount() == 4);
+  ASSERT(a.to_string() == "hello world, buffer chain");
+
+  BufferChain s = a.slice(6, 5);
+  ASSERT(s.to_string() == "world" && s.getBlockCount() == 2);
+
+  BufferChain head = a.cut(12);
+  ASSERT(head.to_string() == "hello world," && a.to_string() == " buffer chain");
+  ASSERT(s.to_string() == "world");
+
+  // 共享的节点不会被追加的数据覆盖
+  head.append("!");
+  ASSERT(head.to_string() == "hello world,!" && s.to_string() == "world");
+  s.append(s);
+  ASSERT(s.to_string() == "worldworld");
+
+  head.append(a);
+  ASSERT(head.to_string() == "hello world,! buffer chain");
+  head.consume(14);
+  ASSERT(head.to_string() == "buffer chain");
+
+  char buf[6];
+  head.copyOut(buf, 5, 7);
+  ASSERT(std::string(buf, 5) == "chain");
+
+  bool thrown = false;
+  try {
+    head.slice(10, 3);
+  } catch (std::out_of_range&) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+
+  // 只被自身引用的尾节点继续写入
+  BufferChain c(16);
+  c.append("abc");
+  std::vector<iovec> iovs;
+  ASSERT(c.getWriteBuffers(iovs, 20) == 20 && iovs.size() == 2 && iovs[0].iov_len == 13);
+  memcpy(iovs[0].iov_base, "defghijklmnop", 13);
+  memcpy(iovs[1].iov_base, "qrs", 3);
+  c.commit(16);
+  ASSERT(c.to_string() == "abcdefghijklmnopqrs" && c.getBlockCount() == 2);
+
+  // 读取挂起期间其他协程引用或取走链尾, 提交仍按交出的空间记账
+  BufferChain d(16);
+  d.append("abc");
+  iovs.clear();
+  ASSERT(d.getWriteBuffers(iovs, 20) == 20 && iovs[0].iov_len == 13);
+  BufferChain view = d.slice(0, 3);
+  memcpy(iovs[0].iov_base, "defghijklmnop", 13);
+  memcpy(iovs[1].iov_base, "qrs", 3);
+  d.commit(16);
+  ASSERT(d.getSize() == 19 && d.to_string() == "abcdefghijklmnopqrs" && view.to_string() == "abc");
+
+  iovs.clear();
+  ASSERT(d.getWriteBuffers(iovs, 4) == 4 && iovs.size() == 1);
+  BufferChain all = d.cut(d.getSize());
+  memcpy(iovs[0].iov_base, "tuvw", 4);
+  d.commit(4);
+  ASSERT(d.to_string() == "tuvw" && all.to_string() == "abcdefghijklmnopqrs");
+
+  // 提交前另一个写入方追加数据被拒绝, 清空已有数据不影响之后的提交
+  iovs.clear();
+  ASSERT(d.getWriteBuffers(iovs, 4) == 4);
+  size_t rejected = 0;
+  try {
+    d.append("x");
+  } catch (std::logic_error&) { ++rejected; }
+  try {
+    std::vector<iovec> other;
+    d.getWriteBuffers(other, 4);
+  } catch (std::logic_error&) { ++rejected; }
+  ASSERT(rejected == 2 && d.to_string() == "tuvw");
+  d.clear();
+  memcpy(iovs[0].iov_base, "wxyz", 4);
+  d.commit(4);
+  ASSERT(d.getSize() == 4 && d.to_string() == "wxyz");
+  d.append("!");
+  ASSERT(d.to_string() == "wxyz!");
+  LOG_INFO("test_chain ok");
+}
+
+// 代理在两个连接之间转发数据, 不复制到中间缓冲区
+void test_proxy() {
+  const size_t size = 1024 * 1024;
+  std::string  data(size, 0);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = rand();
+  }
+
+  IOManager iom(1, "test_buffer_chain", false);
+  // socket 在 hook 的线程中创建, 才会登记到 FdManager
+  iom.schedule([&iom, &data]() {
+    Socket::ptr server = Socket::CreateTCPSocket();
+    Socket::ptr proxy  = Socket::CreateTCPSocket();
+    ASSERT(server->bind(IPv4Address::Create("127.0.0.1", 0)) && server->listen());
+    ASSERT(proxy->bind(IPv4Address::Create("127.0.0.1", 0)) && proxy->listen());
+    Address::ptr server_addr = server->getLocalAddress();
+    Address::ptr proxy_addr  = proxy->getLocalAddress();
+
+    iom.schedule([server, &data]() {
+      SocketStream stream(server->accept());
+      std::string  recv(data.size(), 0);
+      ASSERT(stream.readFixSize(&recv[0], recv.size()) == (int)recv.size());
+      ASSERT(recv == data);
+      LOG_INFO("server recv %lu bytes", recv.size());
+    });
+    iom.schedule([proxy, server_addr]() {
+      SocketStream in(proxy->accept());
+      Socket::ptr  sock = Socket::CreateTCP(server_addr);
+      ASSERT(sock->connect(server_addr));
+      SocketStream     out(sock);
+      BufferChain::ptr chain(new BufferChain);
+      size_t           total = 0;
+      while (true) {
+        int rt = in.read(chain, 64 * 1024);
+        if (rt <= 0) { break; }
+        total += rt;
+        BufferChain::ptr forward(new BufferChain(chain->cut(chain->getSize())));
+        ASSERT(out.writeFixSize(forward, forward->getSize()) > 0);
+        ASSERT(forward->empty());
+      }
+      LOG_INFO("proxy forward %lu bytes", total);
+    });
+    iom.schedule([proxy_addr, &data]() {
+      Socket::ptr sock = Socket::CreateTCP(proxy_addr);
+      ASSERT(sock->connect(proxy_addr));
+      SocketStream stream(sock);
+      ASSERT(stream.writeFixSize(data.c_str(), data.size()) == (int)data.size());
+    });
+  });
+}
+
+int main(int argc, char** argv) {
+  test_chain();
+  test_proxy();
+  LOG_INFO("test_buffer_chain ok");
+  return 0;
+}
@@ -86,7 +86,194 @@ void test() {
 #undef XX
 }
 
+// 批量接口与逐个读写的结果一致, 包括跨节点和数据末尾
+void test_array() {
+  for (size_t base_len : {1, 3, 7, 64, 4096}) {
+    std::vector<uint32_t> vec;
+    for (int i = 0; i < 1000; ++i) {
+      vec.push_back((uint32_t)rand() >> (rand() % 32));
+    }
+    vec.push_back(0xffffffff);
+    ByteArray::ptr ba(new ByteArray(base_len));
+    ba->writeUint32Array(vec.data(), vec.size());
+    ByteArray::ptr ba2(new ByteArray(base_len));
+    for (auto& i : vec) {
+      ba2->writeUint32(i);
+    }
+    ba->setPosition(0);
+    ba2->setPosition(0);
+    ASSERT(ba->to_string() == ba2->to_string());
+
+    std::vector<uint32_t> out(vec.size());
+    ba->readUint32Array(out.data(), out.size());
+    ASSERT(out == vec);
+    ASSERT(ba->getReadSize() == 0);
+    for (auto& i : vec) {
+      ASSERT(ba2->readUint32() == i);
+    }
+
+    ba->setPosition(0);
+    bool thrown = false;
+    try {
+      out.resize(vec.size() + 1);
+      ba->readUint32Array(out.data(), out.size());
+    } catch (std::out_of_range&) {
+      thrown = true;
+    }
+    ASSERT(thrown);
+  }
+  LOG_INFO("test_array ok");
+}
+
+// clear 后复用节点, reserve 预留的空间直接写入
+void test_reserve() {
+  ByteArray::ptr ba(new ByteArray(64));
+  for (int n = 0; n < 3; ++n) {
+    ba->reserve(10000);
+    ASSERT(ba->getPosition() == 0 && ba->getSize() == 0);
+    for (uint32_t i = 0; i < 2500; ++i) {
+      ba->writeFuint32(i);
+    }
+    ba->setPosition(0);
+    for (uint32_t i = 0; i < 2500; ++i) {
+      ASSERT(ba->readFuint32() == i);
+    }
+    ba->clear();
+  }
+
+  // 构造 4MB 的消息, 第一次申请节点, 之后从线程缓存复用
+  const size_t size = 4 * 1024 * 1024;
+  std::string  data(4096, 'x');
+  for (int n = 0; n < 3; ++n) {
+    uint64_t begin = get_current_us();
+    {
+      ByteArray::ptr ba(new ByteArray);
+      ba->reserve(size);
+      for (size_t i = 0; i < size; i += data.size()) {
+        ba->writeStringWithoutLength(data);
+      }
+      ASSERT(ba->getSize() == size);
+    }
+    LOG_INFO("build %lu bytes round=%d used=%luus", size, n, get_current_us() - begin);
+  }
+  LOG_INFO("test_reserve ok");
+}
+
+// mmap 映射的文件与 writeToFile/readFromFile 的结果一致
+void test_mmap() {
+  const std::string     name  = "/tmp/test_bytearray_mmap.dat";
+  const size_t          count = 1000000;
+  std::vector<uint32_t> vec;
+  for (size_t i = 0; i < count; ++i) {
+    vec.push_back(rand());
+  }
+  unlink(name.c_str());
+
+  uint64_t begin = get_current_us();
+  {
+    // 写入时超过初始映射, 扩大文件重新映射
+    ByteArray::ptr ba = ByteArray::MapFile(name, true);
+    ASSERT(ba && ba->isMapped() && ba->getSize() == 0);
+    ba->writeUint32Array(vec.data(), vec.size());
+    ba->writeStringF32("tail");
+    ASSERT(ba->sync());
+  }
+  uint64_t mid = get_current_us();
+
+  // 读入堆上的节点再解析
+  std::vector<uint32_t> out(count);
+  ByteArray::ptr        heap(new ByteArray);
+  ASSERT(heap->readFromFile(name));
+  heap->setPosition(0);
+  heap->readUint32Array(out.data(), out.size());
+  ASSERT(out == vec);
+  uint64_t heap_end = get_current_us();
+
+  // 直接解析映射的文件
+  ByteArray::ptr ba = ByteArray::MapFile(name, false, true);
+  ASSERT(ba && ba->getSize() == heap->getSize());
+  ba->readUint32Array(out.data(), out.size());
+  uint64_t map_end = get_current_us();
+  ASSERT(out == vec);
+  ASSERT(ba->readStringF32() == "tail" && ba->getReadSize() == 0);
+  ba->setPosition(0);
+  heap->setPosition(0);
+  ASSERT(ba->to_string() == heap->to_string());
+
+  bool thrown = false;
+  try {
+    ba->writeFuint8(1);
+  } catch (std::logic_error&) {
+    thrown = true;
+  }
+  ASSERT(thrown);
+  LOG_INFO("test_mmap size=%lu write=%luus parse readFromFile=%luus mmap=%luus", ba->getSize(),
+           mid - begin, heap_end - mid, map_end - heap_end);
+  unlink(name.c_str());
+}
+
+// 原来的实现: 编码到临时数组再 write, 逐字节 read
+static void old_write_uint32(ByteArray::ptr ba, uint32_t value) {
+  uint8_t tmp[5];
+  uint8_t i = 0;
+  while (value >= 0x80) {
+    tmp[i++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  tmp[i++] = value;
+  ba->write(tmp, i);
+}
+
+static uint32_t old_read_uint32(ByteArray::ptr ba) {
+  uint32_t result = 0;
+  for (int i = 0; i < 32; i += 7) {
+    uint8_t b;
+    ba->read(&b, 1);
+    result |= (((uint32_t)(b & 0x7f)) << i);
+    if (b < 0x80) { break; }
+  }
+  return result;
+}
+
+void bench() {
+  const size_t          count = 1000000;
+  std::vector<uint32_t> vec;
+  for (size_t i = 0; i < count; ++i) {
+    vec.push_back((uint32_t)rand() >> (rand() % 32));
+  }
+  std::vector<uint32_t> out(count);
+  uint64_t              sum = 0;
+
+#define XX(name, write_code, read_code)                                             \
+  {                                                                                 \
+    ByteArray::ptr ba(new ByteArray(4096));                                         \
+    uint64_t       begin = get_current_us();                                        \
+    write_code;                                                                     \
+    uint64_t mid = get_current_us();                                                \
+    ba->setPosition(0);                                                             \
+    read_code;                                                                      \
+    uint64_t end = get_current_us();                                                \
+    ASSERT(out == vec);                                                             \
+    sum += out[0];                                                                  \
+    LOG_INFO("%-8s count=%lu size=%lu write=%luus read=%luus", name, count,         \
+             ba->getSize(), mid - begin, end - mid);                                \
+  }
+
+  XX("old", for (auto& i : vec) { old_write_uint32(ba, i); },
+     for (size_t i = 0; i < count; ++i) { out[i] = old_read_uint32(ba); });
+  XX("single", for (auto& i : vec) { ba->writeUint32(i); },
+     for (size_t i = 0; i < count; ++i) { out[i] = ba->readUint32(); });
+  XX("array", ba->writeUint32Array(vec.data(), count),
+     ba->readUint32Array(out.data(), count));
+#undef XX
+  LOG_INFO("bench sum=%lu", sum);
+}
+
 int main(int argc, char** argv) {
   test();
+  test_array();
+  test_reserve();
+  test_mmap();
+  bench();
   return 0;
 }
@@ -0,0 +1,126 @@
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "basic/cancel.h"
+#include "basic/fd_manager.h"
+#include "basic/fiber_sync.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+
+using namespace Basic;
+
+// socketpair 没有被hook, 手动登记才会走协程调度
+static void make_pair(int fds[2]) {
+  ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  FdMgr::GetInstance()->get(fds[0], true);
+  FdMgr::GetInstance()->get(fds[1], true);
+}
+
+static void set_recv_timeout(int fd, uint64_t ms) {
+  struct timeval tv;
+  tv.tv_sec  = ms / 1000;
+  tv.tv_usec = ms % 1000 * 1000;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+// 三次各 150ms 超时的 read 共用 200ms 的截止时间
+void test_deadline() {
+  int fds[2];
+  make_pair(fds);
+  set_recv_timeout(fds[0], 150);
+
+  uint64_t begin = get_current_ms();
+  int      errors[3];
+  {
+    CancelScope scope(200);
+    for (int i = 0; i < 3; ++i) {
+      char c;
+      ASSERT(read(fds[0], &c, 1) == -1);
+      errors[i] = errno;
+    }
+  }
+  uint64_t used = get_current_ms() - begin;
+  LOG_INFO("3 reads used=%lu", used);
+  ASSERT(errors[0] == ETIMEDOUT && errors[1] == ETIMEDOUT && errors[2] == ETIMEDOUT);
+  ASSERT(used >= 190 && used < 300);
+  ASSERT(CancelToken::GetThis() == nullptr);
+
+  // 作用域外不受影响
+  ASSERT(write(fds[1], "x", 1) == 1);
+  char c;
+  ASSERT(read(fds[0], &c, 1) == 1);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+void test_sleep_accept() {
+  uint64_t begin = get_current_ms();
+  {
+    CancelScope scope(50);
+    ASSERT(usleep(1000 * 1000) == -1 && errno == ETIMEDOUT);
+    // 已经超时的令牌不再挂起
+    ASSERT(sleep(1) == 1);
+  }
+  ASSERT(get_current_ms() - begin < 200);
+
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT(bind(sock, (sockaddr*)&addr, sizeof(addr)) == 0);
+  ASSERT(listen(sock, 1) == 0);
+  begin = get_current_ms();
+  {
+    CancelScope scope(50);
+    ASSERT(accept(sock, nullptr, nullptr) == -1 && errno == ETIMEDOUT);
+  }
+  ASSERT(get_current_ms() - begin < 200);
+  close(sock);
+}
+
+// 其它协程取消令牌, 子令牌一起取消
+void test_cancel() {
+  int fds[2];
+  make_pair(fds);
+
+  CancelScope outer(-1);
+  ASSERT(CancelToken::Remaining() == (uint64_t)-1);
+  CancelToken::ptr token = outer.getToken();
+  IOManager::GetThis()->schedule([token]() {
+    usleep(50 * 1000);
+    token->cancel();
+  });
+  {
+    CancelScope inner(1000);
+    ASSERT(CancelToken::Remaining() <= 1000);
+    char c;
+    ASSERT(read(fds[0], &c, 1) == -1 && errno == ECANCELED);
+    ASSERT(inner.getToken()->getError() == ECANCELED);
+  }
+  ASSERT(CancelToken::Check() == ECANCELED);
+
+  // 新建子令牌继承已取消状态
+  CancelScope child(1000);
+  ASSERT(CancelToken::Remaining() == 0);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+int main(int argc, char* argv[]) {
+  IOManager iom(1, "cancel", false);
+  WaitGroup wg;
+  wg.add();
+  iom.schedule([&wg]() {
+    test_deadline();
+    test_sleep_accept();
+    test_cancel();
+    wg.done();
+  });
+  wg.wait();
+  iom.stop();
+  LOG_INFO("test_cancel ok");
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include "basic/channel.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+
+using namespace Basic;
+
+static const uint64_t s_messages = 1000000;
+
+void test_basic(IOManager& iom) {
+  // 队列满时 send 挂起, 直到 recv 取走数据
+  Channel<int>::ptr ch(new Channel<int>(2));
+  ASSERT(ch->getCapacity() == 2);
+  ASSERT(ch->trySend(1) && ch->trySend(2) && !ch->trySend(3));
+
+  WaitGroup wg;
+  wg.add();
+  bool sent = false;
+  iom.schedule([&]() {
+    ASSERT(ch->send(3));
+    sent = true;
+    wg.done();
+  });
+  usleep(50 * 1000);
+  ASSERT(!sent);
+  int v = 0;
+  ASSERT(ch->recv(v) && v == 1);
+  wg.wait();
+  ASSERT(sent);
+
+  // close 后取完剩余数据, 之后 recv 返回false
+  ch->close();
+  ASSERT(!ch->send(4));
+  ASSERT(ch->recv(v) && v == 2);
+  ASSERT(ch->recv(v) && v == 3);
+  ASSERT(!ch->recv(v));
+
+  // close 唤醒挂起的接收方
+  Channel<int>::ptr empty(new Channel<int>(4));
+  wg.add();
+  iom.schedule([&]() {
+    int x;
+    ASSERT(!empty->recv(x));
+    wg.done();
+  });
+  usleep(20 * 1000);
+  empty->close();
+  wg.wait();
+}
+
+void test_select(IOManager& iom) {
+  std::vector<Channel<std::string>::ptr> chans;
+  for (int i = 0; i < 3; ++i) {
+    chans.emplace_back(new Channel<std::string>(4));
+  }
+  iom.addTimer(30, [&chans]() { chans[2]->send(std::string("c")); });
+  std::string v;
+  ASSERT(Channel<std::string>::Select(chans, v) == 2 && v == "c");
+
+  chans[0]->send(std::string("a"));
+  ASSERT(Channel<std::string>::Select(chans, v) == 0 && v == "a");
+
+  for (auto& i : chans) {
+    i->close();
+  }
+  ASSERT(Channel<std::string>::Select(chans, v) == -1);
+}
+
+// 生产者在 a 上, 消费者在 b 上, 两个IOManager之间传递 s_messages 个消息
+void bench(const char* name, IOManager& a, IOManager& b, int producers, int consumers) {
+  Channel<uint64_t>::ptr ch(new Channel<uint64_t>(1024));
+  WaitGroup              wg_send;
+  WaitGroup              wg_recv;
+  std::atomic<uint64_t>  sum{0};
+  std::atomic<uint64_t>  count{0};
+
+  uint64_t begin = get_current_us();
+  for (int i = 0; i < consumers; ++i) {
+    wg_recv.add();
+    b.schedule([&]() {
+      uint64_t v = 0, local_sum = 0, local_count = 0;
+      while (ch->recv(v)) {
+        local_sum += v;
+        ++local_count;
+      }
+      sum   += local_sum;
+      count += local_count;
+      wg_recv.done();
+    });
+  }
+  for (int i = 0; i < producers; ++i) {
+    wg_send.add();
+    a.schedule([&, i]() {
+      for (uint64_t v = i; v < s_messages; v += producers) {
+        ch->send(v);
+      }
+      wg_send.done();
+    });
+  }
+  wg_send.wait();
+  ch->close();
+  wg_recv.wait();
+  uint64_t used = get_current_us() - begin;
+
+  ASSERT(count == s_messages);
+  ASSERT(sum == s_messages * (s_messages - 1) / 2);
+  LOG_ERROR_STREAM << name << " producers=" << producers << " consumers=" << consumers
+                   << " used_ms=" << used / 1000
+                   << " msg/s=" << s_messages * 1000000 / (used ? used : 1);
+}
+
+int main(int argc, char* argv[]) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  IOManager a(2, "chan_a", false);
+  IOManager b(2, "chan_b", false);
+
+  test_basic(a);
+  test_select(a);
+  bench("spsc", a, b, 1, 1);
+  bench("mpmc", a, b, 4, 4);
+  LOG_ERROR_STREAM << "test_channel ok";
+  return 0;
+}
@@ -287,9 +287,65 @@ void test_log_file_config() {
   }
 }
 
+// 32 线程并发读取配置, 与读写锁加拷贝的读取方式对比
+void bench_get_value() {
+  const int      threads = 32;
+  const uint64_t count   = 1000000;
+
+  auto int_var = Config::Lookup("bench.int", (int)1, "bench");
+  auto vec_var = Config::Lookup("bench.vec", std::vector<int>(64, 1), "bench");
+
+  RWMutex          lock;
+  std::vector<int> locked_vec(64, 1);
+
+  auto run = [&](const char* name, std::function<uint64_t()> read) {
+    std::vector<Thread::ptr> thrs;
+    std::atomic<uint64_t>    total{0};
+    uint64_t                 begin = get_current_us();
+    for (int i = 0; i < threads; ++i) {
+      thrs.push_back(std::make_shared<Thread>(
+          [&]() {
+            uint64_t sum = 0;
+            for (uint64_t j = 0; j < count; ++j) {
+              sum += read();
+            }
+            total += sum;
+          },
+          "bench_" + std::to_string(i)));
+    }
+    for (auto& i : thrs) {
+      i->join();
+    }
+    uint64_t used = get_current_us() - begin;
+    LOG_INFO("%s: threads=%d reads=%lu used=%lums %.1f Mreads/s", name, threads, threads * count,
+             used / 1000, threads * count * 1.0 / used);
+    ASSERT(total > 0);
+  };
+
+  run("ConfigVar<int>::getValue", [&]() { return (uint64_t)int_var->getValue(); });
+  run("ConfigVar<vector>::getValue", [&]() { return (uint64_t)vec_var->getValue()[0]; });
+  run("ConfigVar<vector>::getSnapshot", [&]() { return (uint64_t)(*vec_var->getSnapshot())[0]; });
+  run("RWMutex + copy vector", [&]() {
+    RWMutex::ReadLock l(lock);
+    std::vector<int>  v = locked_vec;
+    return (uint64_t)v[0];
+  });
+
+  // 修改后各线程读到新值, 之前取得的快照不受影响
+  auto old = vec_var->getSnapshot();
+  vec_var->setValue(std::vector<int>(64, 2));
+  ASSERT((*old)[0] == 1 && (*vec_var->getSnapshot())[0] == 2);
+  run("ConfigVar<vector>::getValue after set", [&]() {
+    ASSERT(vec_var->getValue()[0] == 2);
+    return (uint64_t)vec_var->getValue()[0];
+  });
+}
+
 int main() {
   test_cast();
 
+  bench_get_value();
+
   test_yaml();
 
   test_log_file_config();
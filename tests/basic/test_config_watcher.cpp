@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <fstream>
+
+#include "basic/config.h"
+#include "basic/config_watcher.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+
+using namespace Basic;
+
+static ConfigVar<int>::ptr g_port = Config::Lookup("watch.port", 80, "port");
+static ConfigVar<std::string>::ptr g_name = Config::Lookup("watch.name", std::string("a"), "name");
+static ConfigVar<std::vector<int>>::ptr g_list =
+    Config::Lookup("watch.list", std::vector<int>{1}, "list");
+
+static void write_file(const std::string& path, const std::string& content) {
+  // 先写临时文件再改名, 与编辑器/配置下发的做法一致
+  std::ofstream ofs(path + ".tmp");
+  ofs << content;
+  ofs.close();
+  rename((path + ".tmp").c_str(), path.c_str());
+}
+
+static bool wait_for(std::function<bool()> cond) {
+  for (int i = 0; i < 200; ++i) {
+    if (cond()) { return true; }
+    usleep(10 * 1000);
+  }
+  return false;
+}
+
+void test_watch() {
+  char tmpl[] = "/tmp/test_config_watcher_XXXXXX";
+  ASSERT(mkdtemp(tmpl));
+  std::string dir = tmpl;
+  write_file(dir + "/a.yaml", "watch:\n  port: 8080\n  name: b\n  list: [1, 2]\n");
+
+  std::atomic<int>         port_changes{0};
+  std::atomic<int>         name_changes{0};
+  std::atomic<int>         reloads{0};
+  std::vector<std::string> last_keys;
+  g_port->addListener([&](const int&, const int&) { ++port_changes; });
+  g_name->addListener([&](const std::string&, const std::string&) { ++name_changes; });
+  uint64_t id = Config::AddReloadListener([&](const std::vector<std::string>& keys) {
+    last_keys = keys;
+    ++reloads;
+  });
+
+  IOManager     iom(1, "watcher", false);
+  ConfigWatcher watcher(dir, &iom);
+  ASSERT(watcher.start());
+  ASSERT(g_port->getValue() == 8080 && g_name->getValue() == "b");
+  ASSERT(g_list->getValue().size() == 2);
+  ASSERT(reloads == 1 && last_keys.size() == 3);
+
+  // 只修改 port, 只触发 port 的监听
+  write_file(dir + "/a.yaml", "watch:\n  port: 9090\n  name: b\n  list: [1, 2]\n");
+  ASSERT(wait_for([&]() { return reloads == 2; }));
+  ASSERT(g_port->getValue() == 9090);
+  ASSERT(port_changes == 2 && name_changes == 1);
+  ASSERT(last_keys.size() == 1 && last_keys[0] == "watch.port");
+
+  // 内容不变只是重写文件, 不通知
+  uint64_t count = watcher.getReloadCount();
+  write_file(dir + "/a.yaml", "watch:\n  port: 9090\n  name: b\n  list: [1, 2]\n");
+  ASSERT(wait_for([&]() { return watcher.getReloadCount() > count; }));
+  ASSERT(reloads == 2);
+
+  // 新建的子目录
+  mkdir((dir + "/sub").c_str(), 0755);
+  usleep(50 * 1000);
+  write_file(dir + "/sub/b.yaml", "watch:\n  name: c\n");
+  ASSERT(wait_for([&]() { return g_name->getValue() == "c"; }));
+  ASSERT(name_changes == 2);
+
+  watcher.stop();
+  iom.stop();
+  Config::DelReloadListener(id);
+
+  unlink((dir + "/sub/b.yaml").c_str());
+  rmdir((dir + "/sub").c_str());
+  unlink((dir + "/a.yaml").c_str());
+  rmdir(dir.c_str());
+}
+
+// 同一线程上多个协程同时加载, 加载中挂起的协程不能阻塞其它协程
+void test_concurrent_load() {
+  char tmpl[] = "/tmp/test_config_watcher_XXXXXX";
+  ASSERT(mkdtemp(tmpl));
+  std::string dir = tmpl;
+  write_file(dir + "/a.yaml", "watch:\n  port: 7070\n");
+
+  std::atomic<int> done{0};
+  IOManager        iom(1, "loader", false);
+  for (int i = 0; i < 4; ++i) {
+    iom.schedule([&]() {
+      Config::LoadFromDir(dir, true);
+      ++done;
+    });
+  }
+  ASSERT(wait_for([&]() { return done == 4; }));
+  ASSERT(g_port->getValue() == 7070);
+  iom.stop();
+
+  unlink((dir + "/a.yaml").c_str());
+  rmdir(dir.c_str());
+}
+
+// 大量配置项中只修改一项时的重新加载耗时
+void bench_reload() {
+  char tmpl[] = "/tmp/test_config_watcher_XXXXXX";
+  ASSERT(mkdtemp(tmpl));
+  std::string dir = tmpl;
+
+  const int         count = 2000;
+  std::stringstream ss;
+  ss << "bench:\n";
+  for (int i = 0; i < count; ++i) {
+    Config::Lookup("bench.key" + std::to_string(i), i, "bench");
+    ss << "  key" << i << ": " << i << "\n";
+  }
+  std::string content = ss.str();
+  write_file(dir + "/bench.yaml", content);
+  Config::LoadFromDir(dir);
+
+  content.replace(content.find("key0: 0"), 7, "key0: 7");
+  write_file(dir + "/bench.yaml", content);
+  uint64_t begin   = get_current_us();
+  auto     changed = Config::LoadFromDir(dir);
+  LOG_INFO("reload %d keys, changed=%lu used=%luus", count, changed.size(),
+           get_current_us() - begin);
+  ASSERT(changed.size() == 1);
+
+  unlink((dir + "/bench.yaml").c_str());
+  rmdir(dir.c_str());
+}
+
+int main(int argc, char* argv[]) {
+  test_watch();
+  test_concurrent_load();
+  bench_reload();
+  LOG_INFO("test_config_watcher ok");
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include "basic/bytearray.h"
+#include "basic/dns.h"
+#include "basic/socket.h"
+#include "server.h"
+
+using namespace Basic;
+
+static Socket::ptr s_stub;
+static int         s_stub_queries = 0;
+
+// 本地DNS桩: stub.test 返回两条A记录, 其它域名返回NXDOMAIN
+void stub_server() {
+  s_stub = Socket::CreateUDP(IPv4Address::Create("127.0.0.1", 15353));
+  ASSERT(s_stub->bind(IPv4Address::Create("127.0.0.1", 15353)));
+
+  char buff[512];
+  while (true) {
+    Address::ptr from(new IPv4Address);
+    int          len = s_stub->recvFrom(buff, sizeof(buff), from);
+    if (len <= 0) { break; }
+    ++s_stub_queries;
+
+    ByteArray req;
+    req.write(buff, len);
+    req.setPosition(12);
+    std::string name;
+    uint8_t     l = 0;
+    while ((l = req.readFuint8()) != 0) {
+      std::string label(l, '\0');
+      req.read(&label[0], l);
+      name += (name.empty() ? "" : ".") + label;
+    }
+    uint16_t    qtype    = req.readFuint16();
+    size_t      qend     = req.getPosition() + 2;
+    bool        found    = name == "stub.test";
+    std::string question = std::string(buff + 12, qend - 12);
+
+    ByteArray rsp;
+    rsp.write(buff, 2);
+    rsp.writeFuint16(found ? 0x8180 : 0x8183);
+    rsp.writeFuint16(1);
+    rsp.writeFuint16(found && qtype == 1 ? 2 : 0);
+    rsp.writeFuint16(0);
+    rsp.writeFuint16(0);
+    rsp.write(question.c_str(), question.size());
+    if (found && qtype == 1) {
+      for (uint32_t ip : {0x0A000001u, 0x0A000002u}) {
+        rsp.writeFuint16(0xC00C);
+        rsp.writeFuint16(1);
+        rsp.writeFuint16(1);
+        rsp.writeFuint32(60);
+        rsp.writeFuint16(4);
+        rsp.writeFuint32(ip);
+      }
+    }
+    rsp.setPosition(0);
+    std::string data = rsp.to_string();
+    s_stub->sendTo(data.c_str(), data.size(), from);
+  }
+}
+
+void test_resolver() {
+  DnsResolver::ptr resolver(new DnsResolver);
+  resolver->setNameservers({IPv4Address::Create("127.0.0.1", 15353)});
+  resolver->setTimeout(500);
+
+  std::vector<IPAddress::ptr> addrs;
+  ASSERT(resolver->resolve(addrs, "stub.test"));
+  ASSERT(addrs.size() == 2);
+  ASSERT(addrs[0]->to_string() == "10.0.0.1:0");
+  ASSERT(s_stub_queries == 2);
+
+  addrs.clear();
+  ASSERT(resolver->resolve(addrs, "STUB.test."));
+  ASSERT(addrs.size() == 2);
+  ASSERT(s_stub_queries == 2);
+  ASSERT(resolver->getCacheHitCount() == 1);
+
+  addrs.clear();
+  ASSERT(!resolver->resolve(addrs, "nx.test"));
+  ASSERT(s_stub_queries == 3);
+  ASSERT(!resolver->resolve(addrs, "nx.test"));
+  ASSERT(s_stub_queries == 3);
+
+  addrs.clear();
+  ASSERT(resolver->resolve(addrs, "127.0.0.1"));
+  ASSERT(resolver->resolve(addrs, "localhost", AF_INET));
+  LOG_INFO_STREAM << resolver->to_string();
+
+  // nameserver 不可用时回退到 getaddrinfo 线程池
+  resolver->loadHosts("/nonexistent");
+  resolver->setNameservers({IPv4Address::Create("127.0.0.1", 15354)});
+  resolver->setTimeout(100);
+  resolver->setAttempts(1);
+  addrs.clear();
+  uint64_t begin = get_current_ms();
+  ASSERT(resolver->resolve(addrs, "localhost", AF_INET));
+  LOG_INFO_STREAM << "fallback localhost=" << *addrs[0] << " used=" << get_current_ms() - begin;
+
+  DnsMgr::GetInstance()->setNameservers({IPv4Address::Create("127.0.0.1", 15353)});
+  IPAddress::ptr addr = Address::LookupAnyIPAddress("stub.test:8080");
+  ASSERT(addr && addr->to_string() == "10.0.0.1:8080");
+
+  LOG_INFO("test_resolver ok");
+  s_stub->close();
+}
+
+int main(int argc, char** argv) {
+  IOManager iom(2);
+  iom.schedule(stub_server);
+  iom.addTimer(100, test_resolver);
+  return 0;
+}
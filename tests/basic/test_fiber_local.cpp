@@ -0,0 +1,104 @@
+#include <string>
+
+#include "basic/fiber_local.h"
+#include "basic/fiber_sync.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+
+using namespace Basic;
+
+static std::atomic<int> s_destroyed{0};
+
+struct Context {
+  std::string traceId;
+  ~Context() { ++s_destroyed; }
+};
+
+static FiberLocal<uint64_t> s_id;
+static FiberLocal<Context>  s_ctx;
+
+// 协程在线程间迁移后仍然看到自己的值
+void test_migrate() {
+  IOManager iom(2, "fiber_local", false);
+  WaitGroup wg;
+  std::atomic<int> threads_changed{0};
+  for (uint64_t i = 1; i <= 16; ++i) {
+    wg.add();
+    iom.schedule([i, &wg, &threads_changed]() {
+      ASSERT(!s_id.has() && s_ctx->traceId.empty());
+      s_id.set(i);
+      s_ctx->traceId = "trace-" + std::to_string(i);
+      int thread     = get_thread_id();
+      for (int j = 0; j < 100; ++j) {
+        Fiber::Yield2Ready();
+        ASSERT(*s_id == i);
+        ASSERT(s_ctx->traceId == "trace-" + std::to_string(i));
+      }
+      if (thread != get_thread_id()) { ++threads_changed; }
+      wg.done();
+    });
+  }
+  wg.wait();
+  iom.stop();
+  LOG_INFO("fibers migrated: %d", threads_changed.load());
+}
+
+// 协程结束时销毁值, 复用的协程不会看到上一个任务的值
+void test_destroy() {
+  int destroyed = s_destroyed;
+  {
+    IOManager iom(1, "fiber_local_destroy", false);
+    for (int i = 0; i < 10; ++i) {
+      iom.schedule([]() {
+        ASSERT(!s_id.has() && !s_ctx.has());
+        s_id.set(1);
+        s_ctx->traceId = "x";
+      });
+    }
+    iom.stop();
+  }
+  ASSERT(s_destroyed - destroyed == 10);
+
+  // reset 立即销毁
+  Fiber::GetThis();
+  Fiber::ptr fiber(new Fiber(
+      []() {
+        s_ctx->traceId = "y";
+        s_ctx.reset();
+        ASSERT(!s_ctx.has());
+        s_ctx->traceId = "z";
+      },
+      0, true));
+  fiber->call();
+  ASSERT(s_destroyed - destroyed == 12);
+
+  // 线程主协程
+  s_id.set(7);
+  ASSERT(*s_id == 7);
+}
+
+void bench() {
+  static thread_local uint64_t t_id = 0;
+  const uint64_t               count = 100000000;
+  uint64_t                     start = get_current_us();
+  for (uint64_t i = 0; i < count; ++i) {
+    ++*s_id;
+  }
+  uint64_t local_us = get_current_us() - start;
+  start             = get_current_us();
+  for (uint64_t i = 0; i < count; ++i) {
+    ++*(volatile uint64_t*)&t_id;
+  }
+  uint64_t tls_us = get_current_us() - start;
+  LOG_INFO("FiberLocal: %.2f ns/op, thread_local: %.2f ns/op", local_us * 1000.0 / count,
+           tls_us * 1000.0 / count);
+}
+
+int main(int argc, char* argv[]) {
+  test_migrate();
+  test_destroy();
+  bench();
+  LOG_INFO("test_fiber_local ok");
+  return 0;
+}
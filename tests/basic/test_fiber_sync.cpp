@@ -0,0 +1,148 @@
+#include <deque>
+
+#include "basic/fiber_sync.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/thread.h"
+
+using namespace Basic;
+
+// 单线程调度器上一个协程等待, 另一个协程唤醒, 线程不能被阻塞
+void test_single_thread() {
+  IOManager      iom(1, "single", false);
+  FiberSemaphore sem;
+  int            step = 0;
+  iom.schedule([&]() {
+    sem.wait();
+    ASSERT(step == 1);
+    step = 2;
+  });
+  iom.schedule([&]() {
+    step = 1;
+    sem.notify();
+  });
+  iom.stop();
+  ASSERT(step == 2);
+}
+
+void test_mutex(IOManager& iom) {
+  FiberMutex mutex;
+  WaitGroup  wg;
+  int        counter = 0;
+  for (int i = 0; i < 100; ++i) {
+    wg.add();
+    iom.schedule([&]() {
+      for (int j = 0; j < 100; ++j) {
+        FiberMutex::Lock lock(mutex);
+        int              v = counter;
+        if (j % 10 == 0) { Fiber::Yield2Ready(); }
+        counter = v + 1;
+      }
+      wg.done();
+    });
+  }
+  wg.wait();
+  ASSERT(counter == 100 * 100);
+}
+
+void test_condition(IOManager& iom) {
+  FiberMutex      mutex;
+  FiberCondition  cond;
+  std::deque<int> queue;
+  WaitGroup       wg;
+  int             sum = 0;
+
+  wg.add(2);
+  iom.schedule([&]() {
+    for (int i = 1; i <= 1000; ++i) {
+      FiberMutex::Lock lock(mutex);
+      queue.push_back(i);
+      cond.notifyOne();
+    }
+    wg.done();
+  });
+  iom.schedule([&]() {
+    for (int i = 0; i < 1000; ++i) {
+      FiberMutex::Lock lock(mutex);
+      while (queue.empty()) {
+        cond.wait(lock);
+      }
+      sum += queue.front();
+      queue.pop_front();
+    }
+    wg.done();
+  });
+  wg.wait();
+  ASSERT(sum == 1000 * 1001 / 2);
+
+  FiberMutex::Lock lock(mutex);
+  uint64_t         begin = get_current_ms();
+  ASSERT(!cond.waitFor(lock, 100));
+  uint64_t used = get_current_ms() - begin;
+  ASSERT(used >= 90 && used < 500);
+}
+
+void test_semaphore(IOManager& iom) {
+  FiberSemaphore   sem(3);
+  WaitGroup        wg;
+  std::atomic<int> running{0};
+  std::atomic<int> max_running{0};
+  for (int i = 0; i < 20; ++i) {
+    wg.add();
+    iom.schedule([&]() {
+      sem.wait();
+      int n = ++running;
+      for (int old = max_running; old < n && !max_running.compare_exchange_weak(old, n);) {}
+      usleep(5 * 1000);
+      --running;
+      sem.notify();
+      wg.done();
+    });
+  }
+  wg.wait();
+  ASSERT(max_running == 3);
+  ASSERT(sem.getCount() == 3);
+
+  FiberSemaphore empty;
+  ASSERT(!empty.tryWait());
+  ASSERT(!empty.waitFor(50));
+  iom.addTimer(20, [&empty]() { empty.notify(); });
+  ASSERT(empty.waitFor(1000));
+}
+
+// 普通线程中等待协程完成
+void test_thread_wait(IOManager& iom) {
+  WaitGroup         wg;
+  std::atomic<bool> done{false};
+  bool              ok = false;
+  wg.add();
+  Thread thread(
+      [&]() {
+        ASSERT(!Scheduler::GetThis());
+        wg.wait();
+        ok = done;
+      },
+      "wg_thread");
+  iom.addTimer(50, [&]() {
+    done = true;
+    wg.done();
+  });
+  thread.join();
+  ASSERT(ok);
+}
+
+void run(IOManager* iom) {
+  test_mutex(*iom);
+  test_condition(*iom);
+  test_semaphore(*iom);
+  test_thread_wait(*iom);
+  LOG_INFO("test_fiber_sync ok");
+}
+
+int main(int argc, char* argv[]) {
+  test_single_thread();
+  IOManager iom(4, "sync", false);
+  iom.schedule(std::bind(run, &iom));
+  return 0;
+}
@@ -7,6 +7,7 @@
 
 #include <iostream>
 
+#include "basic/fiber_sync.h"
 #include "server.h"
 
 using namespace Basic;
@@ -82,10 +83,92 @@ void test_condition_timer() {
       false);
 }
 
+// 一次epoll_wait中多个fd同时就绪, 全部协程都被唤醒
+void test_batch() {
+  static const int s_count = 64;
+  IOManager        iom(4, "test_batch", false);
+  int              fds[s_count][2];
+  WaitGroup        wg;
+  std::atomic<int> woken{0};
+  for (int i = 0; i < s_count; ++i) {
+    ASSERT(!socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+    fcntl(fds[i][0], F_SETFL, O_NONBLOCK);
+    wg.add();
+    iom.schedule([&, i]() {
+      ASSERT(!IOManager::GetThis()->addEvent(fds[i][0], IOManager::READ));
+      Fiber::Yield2Hold();
+      char c;
+      ASSERT(read(fds[i][0], &c, 1) == 1);
+      ++woken;
+      wg.done();
+    });
+  }
+  usleep(50 * 1000);
+  for (int i = 0; i < s_count; ++i) {
+    ASSERT(write(fds[i][1], "x", 1) == 1);
+  }
+  wg.wait();
+  ASSERT(woken == s_count);
+  for (int i = 0; i < s_count; ++i) {
+    close(fds[i][0]);
+    close(fds[i][1]);
+  }
+
+  // 批量schedule默认拷贝, 不会取走调用方的对象
+  std::atomic<int>                   calls{0};
+  std::vector<std::function<void()>> cbs(8, [&calls]() { ++calls; });
+  iom.schedule(cbs.begin(), cbs.end());
+  for (auto& i : cbs) {
+    ASSERT(i);
+  }
+  iom.schedule(std::make_move_iterator(cbs.begin()), std::make_move_iterator(cbs.end()));
+  iom.stop();
+  ASSERT(calls == 16);
+}
+
+// 对端关闭时 EPOLLHUP/EPOLLERR 只唤醒已注册的事件, 未注册的事件不能被触发
+void test_hangup() {
+  IOManager iom(2, "test_hangup", false);
+  WaitGroup wg;
+  int       rfds[2];
+  int       wfds[2];
+  ASSERT(!socketpair(AF_UNIX, SOCK_STREAM, 0, rfds));
+  ASSERT(!socketpair(AF_UNIX, SOCK_STREAM, 0, wfds));
+  fcntl(rfds[0], F_SETFL, O_NONBLOCK);
+  fcntl(wfds[0], F_SETFL, O_NONBLOCK);
+  // 写满缓冲区, 只等待WRITE
+  char buf[4096] = {0};
+  while (write(wfds[0], buf, sizeof(buf)) > 0) {}
+  ASSERT(errno == EAGAIN);
+
+  wg.add(2);
+  iom.schedule([&]() {
+    ASSERT(!IOManager::GetThis()->addEvent(rfds[0], IOManager::READ));
+    Fiber::Yield2Hold();
+    ASSERT(read(rfds[0], buf, sizeof(buf)) == 0);
+    wg.done();
+  });
+  iom.schedule([&]() {
+    ASSERT(!IOManager::GetThis()->addEvent(wfds[0], IOManager::WRITE));
+    Fiber::Yield2Hold();
+    ASSERT(send(wfds[0], buf, 1, MSG_NOSIGNAL) == -1 && errno == EPIPE);
+    wg.done();
+  });
+  usleep(50 * 1000);
+  close(rfds[1]);
+  close(wfds[1]);
+  wg.wait();
+  iom.stop();
+  close(rfds[0]);
+  close(wfds[0]);
+}
+
 int main(int argc, char** argv) {
   Config::LoadFromDir("");
   // test1();
   // test_timer();
   test_condition_timer();
+  test_batch();
+  test_hangup();
   return 0;
 }
\ No newline at end of file
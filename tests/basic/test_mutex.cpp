@@ -0,0 +1,129 @@
+#include <atomic>
+
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/mutex.h"
+#include "basic/thread.h"
+#include "basic/utils.h"
+
+using namespace Basic;
+
+static const int s_iterations  = 200000;
+static const int s_write_ratio = 1000;  /// 每 s_write_ratio 次操作有一次写
+
+// Mutex 没有读锁, 读写都用互斥锁
+template <class T>
+struct LockTraits {
+  typedef typename T::ReadLock  ReadLock;
+  typedef typename T::WriteLock WriteLock;
+};
+
+template <>
+struct LockTraits<Mutex> {
+  typedef Mutex::Lock ReadLock;
+  typedef Mutex::Lock WriteLock;
+};
+
+// 读锁可以被多个线程同时持有
+void test_shared_read() {
+  RWMutex          rw;
+  ShardedRWMutex   sharded;
+  std::atomic<int> inside{0};
+  std::atomic<int> max_inside{0};
+
+  auto reader = [&](auto& mutex) {
+    typename std::remove_reference<decltype(mutex)>::type::ReadLock lock(mutex);
+    int n = ++inside;
+    for (int old = max_inside; old < n && !max_inside.compare_exchange_weak(old, n);) {}
+    usleep(50 * 1000);
+    --inside;
+  };
+
+  for (int round = 0; round < 2; ++round) {
+    inside     = 0;
+    max_inside = 0;
+    std::vector<Thread::ptr> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.push_back(std::make_shared<Thread>(
+          [&, round] { round == 0 ? reader(rw) : reader(sharded); }, "reader_" + std::to_string(i)));
+    }
+    for (auto& i : threads) {
+      i->join();
+    }
+    ASSERT(max_inside > 1);
+  }
+}
+
+// 写锁互斥
+void test_exclusive_write() {
+  ShardedRWMutex           mutex;
+  uint64_t                 value = 0;
+  std::vector<Thread::ptr> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.push_back(std::make_shared<Thread>(
+        [&] {
+          for (int j = 0; j < 10000; ++j) {
+            if (j % 10 == 0) {
+              ShardedRWMutex::WriteLock lock(mutex);
+              ++value;
+            } else {
+              ShardedRWMutex::ReadLock lock(mutex);
+              ASSERT(value <= 8000);
+            }
+          }
+        },
+        "writer_" + std::to_string(i)));
+  }
+  for (auto& i : threads) {
+    i->join();
+  }
+  ASSERT(value == 8000);
+}
+
+template <class T>
+void bench(const char* name, int thread_count) {
+  T                        mutex;
+  std::vector<uint64_t>    table(64, 1);
+  std::atomic<uint64_t>    sum{0};
+  std::vector<Thread::ptr> threads;
+
+  uint64_t begin = get_current_us();
+  for (int i = 0; i < thread_count; ++i) {
+    threads.push_back(std::make_shared<Thread>(
+        [&, i] {
+          uint64_t local = 0;
+          for (int j = 0; j < s_iterations; ++j) {
+            if (j % s_write_ratio == 0) {
+              typename LockTraits<T>::WriteLock lock(mutex);
+              ++table[(i + j) % table.size()];
+            } else {
+              typename LockTraits<T>::ReadLock lock(mutex);
+              local += table[(i + j) % table.size()];
+            }
+          }
+          sum += local;
+        },
+        "bench_" + std::to_string(i)));
+  }
+  for (auto& i : threads) {
+    i->join();
+  }
+  uint64_t used = get_current_us() - begin;
+  uint64_t ops  = (uint64_t)thread_count * s_iterations;
+  LOG_ERROR_STREAM << name << " threads=" << thread_count << " used_ms=" << used / 1000
+                   << " ops/s=" << ops * 1000000 / (used ? used : 1) << " sum=" << sum;
+}
+
+int main(int argc, char* argv[]) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  test_shared_read();
+  test_exclusive_write();
+
+  for (int n : {1, 4, 16, 64}) {
+    bench<RWMutex>("pthread_rwlock", n);
+    bench<ShardedRWMutex>("sharded_rwlock", n);
+    bench<Mutex>("mutex", n);
+  }
+  LOG_ERROR_STREAM << "test_mutex ok";
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <exception>
 #include <iostream>
 
@@ -5,6 +6,23 @@
 
 using namespace Basic;
 
+static std::atomic<uint64_t> s_allocs{0};
+
+void* operator new(size_t size) {
+  ++s_allocs;
+  void* p = malloc(size);
+  if (!p) { throw std::bad_alloc(); }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
 void test_fiber_switch() {
   Scheduler sc(3, "test");
 
@@ -53,10 +71,59 @@ void test_basic() {
   LOG_INFO("over");
 }
 
+// 只能移动的任务
+void test_move_only() {
+  IOManager                iom(1, "move_only", false);
+  std::unique_ptr<int>     value(new int(42));
+  std::atomic<int>         result{0};
+  iom.schedule([value = std::move(value), &result]() { result = *value; });
+  iom.stop();
+  ASSERT(result == 42);
+}
+
+// 稳态下每个任务的内存分配次数与吞吐
+void test_bench() {
+  // 每批不超过 scheduler.task_pool_size, 空闲节点足够复用
+  static const int      s_rounds = 500;
+  static const int      s_batch  = 2000;
+  IOManager             iom(2, "bench", false);
+  std::shared_ptr<int>  shared(new int(1));
+  std::atomic<uint64_t> done{0};
+
+  auto run_round = [&]() {
+    uint64_t target = done + s_batch;
+    for (int i = 0; i < s_batch; ++i) {
+      // 捕获shared_ptr, 与 std::bind(&TcpServer::handleClient, shared_from_this(), client) 相当
+      iom.schedule([shared, &done]() { done += *shared; });
+    }
+    while (done < target) {
+      usleep(100);
+    }
+  };
+
+  run_round();  // 预热, 填充空闲节点
+  uint64_t allocs = s_allocs;
+  uint64_t begin  = get_current_us();
+  for (int i = 0; i < s_rounds; ++i) {
+    run_round();
+  }
+  uint64_t used  = get_current_us() - begin;
+  uint64_t tasks = (uint64_t)s_rounds * s_batch;
+  allocs         = s_allocs - allocs;
+  LOG_ERROR_STREAM << "schedule bench: tasks=" << tasks << " used_ms=" << used / 1000
+                   << " tasks/s=" << tasks * 1000000 / (used ? used : 1)
+                   << " allocs/task=" << (double)allocs / tasks;
+  ASSERT(allocs < tasks / 100);
+  iom.stop();
+}
+
 int main() {
   Config::LoadFromDir("");
   try {
     // test_fiber_switch();
     test_basic();
+    LOG_ROOT->setLevel(LogLevel::ERROR);
+    test_move_only();
+    test_bench();
   } catch (std::exception e) { LOG_ERROR("报错%s", e.what()); }
 }
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include <netinet/tcp.h>
+
+#include <algorithm>
+
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/tcp_server.h"
+#include "basic/utils.h"
+
+using namespace Basic;
+
+static const size_t   s_pingpong = 5000;
+static const size_t   s_split    = 50;
+static const size_t   s_connects = 1000;
+static const uint64_t s_bulk     = 256 << 20;
+static const size_t   s_message  = 64;
+
+static bool recv_all(Socket::ptr sock, char* buf, size_t len) {
+  while (len > 0) {
+    int rt = sock->recv(buf, len);
+    if (rt <= 0) { return false; }
+    buf += rt;
+    len -= rt;
+  }
+  return true;
+}
+
+// 第一个字节为模式: 'e' 收齐 s_message 字节后回显, 's' 读取8字节长度和对应的数据后回复1字节
+class BenchServer : public TcpServer {
+public:
+  typedef std::shared_ptr<BenchServer> ptr;
+  BenchServer() : TcpServer() {}
+
+  int m_nodelay = -1;
+
+protected:
+  void handleClient(Socket::ptr client) override {
+    if (m_nodelay == -1) { client->getOption(IPPROTO_TCP, TCP_NODELAY, m_nodelay); }
+    char mode;
+    if (client->recv(&mode, 1) != 1) { return; }
+    std::vector<char> buf(64 * 1024);
+    if (mode == 'e') {
+      while (recv_all(client, &buf[0], s_message)) {
+        client->send(&buf[0], s_message);
+      }
+    } else {
+      uint64_t total = 0;
+      if (!recv_all(client, (char*)&total, sizeof(total))) { return; }
+      while (total > 0) {
+        int rt = client->recv(&buf[0], std::min<uint64_t>(total, buf.size()));
+        if (rt <= 0) { return; }
+        total -= rt;
+      }
+      client->send("k", 1);
+    }
+  }
+};
+
+static Socket::ptr connect_to(Address::ptr addr, const SocketOptions& opts, char mode) {
+  Socket::ptr sock = Socket::CreateTCP(addr);
+  ASSERT(sock->connect(addr));
+  sock->applyOptions(opts);
+  ASSERT(sock->send(&mode, 1) == 1);
+  return sock;
+}
+
+static void bench(const char* name, const SocketOptions& opts) {
+  BenchServer::ptr server(new BenchServer);
+  server->setSocketOptions(opts);
+  ASSERT(server->bind(IPv4Address::Create("127.0.0.1", 0), false));
+  server->start();
+  Address::ptr addr = server->getSocks()[0]->getLocalAddress();
+  char         buf[s_message] = {0};
+
+  // 一问一答的往返延迟
+  std::vector<uint64_t> rtts;
+  Socket::ptr           sock = connect_to(addr, opts, 'e');
+  for (size_t i = 0; i < s_pingpong; ++i) {
+    uint64_t begin = get_current_us();
+    sock->send(buf, sizeof(buf));
+    ASSERT(recv_all(sock, buf, sizeof(buf)));
+    rtts.push_back(get_current_us() - begin);
+  }
+  std::sort(rtts.begin(), rtts.end());
+  uint64_t sum = 0;
+  for (auto i : rtts) {
+    sum += i;
+  }
+
+  // 请求分两次写出, Nagle 与延迟ACK叠加时每次往返多等待一个延迟ACK的时间
+  uint64_t begin = get_current_us();
+  for (size_t i = 0; i < s_split; ++i) {
+    sock->send(buf, sizeof(buf) / 2);
+    sock->send(buf + sizeof(buf) / 2, sizeof(buf) / 2);
+    ASSERT(recv_all(sock, buf, sizeof(buf)));
+  }
+  uint64_t split = (get_current_us() - begin) / s_split;
+  sock->close();
+
+  // 单连接吞吐
+  std::vector<char> data(64 * 1024);
+  sock  = connect_to(addr, opts, 's');
+  begin = get_current_us();
+  sock->send(&s_bulk, sizeof(s_bulk));
+  for (uint64_t sent = 0; sent < s_bulk;) {
+    int rt = sock->send(&data[0], std::min<uint64_t>(data.size(), s_bulk - sent));
+    ASSERT(rt > 0);
+    sent += rt;
+  }
+  ASSERT(recv_all(sock, buf, 1));
+  uint64_t bulk = get_current_us() - begin;
+  sock->close();
+
+  // 建立连接并完成一次往返
+  begin = get_current_us();
+  for (size_t i = 0; i < s_connects; ++i) {
+    sock = connect_to(addr, opts, 'e');
+    sock->send(buf, sizeof(buf));
+    ASSERT(recv_all(sock, buf, sizeof(buf)));
+    sock->close();
+  }
+  uint64_t conn = get_current_us() - begin;
+
+  server->stop();
+  ASSERT(server->m_nodelay == (int)opts.tcp_nodelay);
+  LOG_ERROR("%-14s rtt avg=%3luus p99=%3luus | split rtt=%6luus | bulk=%5luMB/s | connect=%4luus",
+            name, sum / rtts.size(), rtts[rtts.size() * 99 / 100], split,
+            s_bulk * 1000000 / (bulk + 1) >> 20, conn / s_connects);
+}
+
+int main(int argc, char** argv) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  IOManager iom(1, "test_socket_options", false);
+  iom.schedule([]() {
+    SocketOptions opts;
+    bench("default", opts);
+
+    opts             = SocketOptions();
+    opts.tcp_nodelay = false;
+    bench("nagle", opts);
+
+    opts              = SocketOptions();
+    opts.tcp_quickack = true;
+    bench("quickack", opts);
+
+    opts           = SocketOptions();
+    opts.busy_poll = 50;
+    bench("busy_poll=50", opts);
+
+    opts        = SocketOptions();
+    opts.rcvbuf = 4 << 20;
+    opts.sndbuf = 4 << 20;
+    bench("buf=4M", opts);
+
+    opts               = SocketOptions();
+    opts.notsent_lowat = 128 << 10;
+    bench("lowat=128K", opts);
+
+    opts              = SocketOptions();
+    opts.defer_accept = 1;
+    opts.fastopen     = 256;
+    bench("defer+tfo", opts);
+  });
+  return 0;
+}
@@ -0,0 +1,149 @@
+#include <fcntl.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/socket.h"
+
+using namespace Basic;
+
+static const int      s_handshakes = 300;
+static const uint64_t s_bulk_size  = 64 * 1024 * 1024;
+
+static const std::string s_cert_file = "/tmp/basic_test_ssl_cert.pem";
+static const std::string s_key_file  = "/tmp/basic_test_ssl_key.pem";
+static const std::string s_bulk_file = "/tmp/basic_test_ssl_bulk.dat";
+
+static Address::ptr s_addr;
+static Socket::ptr  s_server;
+
+// 生成自签名证书
+static bool gen_cert() {
+  EVP_PKEY* pkey = EVP_EC_gen("P-256");
+  X509*     x509 = X509_new();
+  ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+  X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+  X509_gmtime_adj(X509_getm_notAfter(x509), 3600);
+  X509_set_pubkey(x509, pkey);
+  X509_NAME* name = X509_get_subject_name(x509);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1,
+                             0);
+  X509_set_issuer_name(x509, name);
+  bool ok = X509_sign(x509, pkey, EVP_sha256()) > 0;
+
+  FILE* key = fopen(s_key_file.c_str(), "w");
+  FILE* crt = fopen(s_cert_file.c_str(), "w");
+  ok        = ok && key && crt && PEM_write_PrivateKey(key, pkey, nullptr, nullptr, 0, 0, nullptr);
+  ok        = ok && PEM_write_X509(crt, x509);
+  if (key) { fclose(key); }
+  if (crt) { fclose(crt); }
+  X509_free(x509);
+  EVP_PKEY_free(pkey);
+  return ok;
+}
+
+// 'h': 回一个字节; 'w': SSL_write 发送 s_bulk_size 字节; 'f': sendFile 发送 s_bulk_size 字节
+void handle_client(Socket::ptr client) {
+  std::string buff(16 * 1024, 'x');
+  char        cmd;
+  while (client->recv(&cmd, 1) == 1) {
+    if (cmd == 'h') {
+      client->send("h", 1);
+    } else if (cmd == 'w') {
+      for (uint64_t sent = 0; sent < s_bulk_size;) {
+        int rt = client->send(buff.c_str(), std::min(buff.size(), s_bulk_size - sent));
+        if (rt <= 0) { break; }
+        sent += rt;
+      }
+    } else if (cmd == 'f') {
+      int fd = open(s_bulk_file.c_str(), O_RDONLY);
+      for (uint64_t sent = 0; sent < s_bulk_size;) {
+        int64_t rt = client->sendFile(fd, sent, s_bulk_size - sent);
+        if (rt <= 0) { break; }
+        sent += rt;
+      }
+      close(fd);
+    }
+  }
+  client->close();
+}
+
+void run_server() {
+  s_server = SSLSocket::CreateTCP(s_addr);
+  ASSERT(s_server->bind(s_addr));
+  ASSERT(std::dynamic_pointer_cast<SSLSocket>(s_server)->loadCertificates(s_cert_file, s_key_file));
+  ASSERT(s_server->listen());
+  while (true) {
+    Socket::ptr client = s_server->accept();
+    if (!client) { break; }
+    IOManager::GetThis()->schedule(std::bind(handle_client, client));
+  }
+}
+
+void bench_handshake(bool resume) {
+  std::shared_ptr<SSL_SESSION> session;
+  int                          resumed = 0;
+  uint64_t                     begin   = get_current_us();
+  for (int i = 0; i < s_handshakes; ++i) {
+    SSLSocket::ptr sock = SSLSocket::CreateTCP(s_addr);
+    if (resume) { sock->setSession(session); }
+    ASSERT(sock->connect(s_addr));
+    char c = 'h';
+    ASSERT(sock->send(&c, 1) == 1);
+    ASSERT(sock->recv(&c, 1) == 1);
+    if (sock->isSessionReused()) { ++resumed; }
+    if (sock->getSession()) { session = sock->getSession(); }
+    sock->close();
+  }
+  uint64_t used = get_current_us() - begin;
+  LOG_ERROR_STREAM << (resume ? "resumed" : "full") << " handshake: count=" << s_handshakes
+                   << " resumed=" << resumed << " used_ms=" << used / 1000
+                   << " rate=" << s_handshakes * 1000000 / (used ? used : 1) << "/s";
+  if (resume) { ASSERT(resumed == s_handshakes - 1); }
+}
+
+void bench_bulk(char cmd) {
+  SSLSocket::ptr sock = SSLSocket::CreateTCP(s_addr);
+  ASSERT(sock->connect(s_addr));
+  uint64_t begin = get_current_us();
+  ASSERT(sock->send(&cmd, 1) == 1);
+  std::string buff(64 * 1024, '\0');
+  uint64_t    total = 0;
+  while (total < s_bulk_size) {
+    int rt = sock->recv(&buff[0], buff.size());
+    ASSERT(rt > 0);
+    total += rt;
+  }
+  uint64_t used = get_current_us() - begin;
+  LOG_ERROR_STREAM << (cmd == 'f' ? "sendfile" : "ssl_write") << " bulk: bytes=" << total
+                   << " used_ms=" << used / 1000
+                   << " MB/s=" << total * 1000000 / (used ? used : 1) / 1024 / 1024
+                   << " client_ktls_send=" << sock->isKtlsSend()
+                   << " client_ktls_recv=" << sock->isKtlsRecv();
+  sock->close();
+}
+
+void run_client() {
+  bench_handshake(false);
+  bench_handshake(true);
+  bench_bulk('w');
+  bench_bulk('f');
+  s_server->close();
+  LOG_ERROR_STREAM << "test_ssl ok";
+}
+
+int main(int argc, char* argv[]) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  ASSERT(gen_cert());
+  int fd = open(s_bulk_file.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT(fd >= 0 && ftruncate(fd, s_bulk_size) == 0);
+  close(fd);
+
+  s_addr = Address::LookupAnyIPAddress("127.0.0.1:8443");
+  IOManager iom(2);
+  iom.schedule(run_server);
+  iom.addTimer(100, run_client);
+  return 0;
+}
@@ -5,10 +5,10 @@ using namespace Basic;
 
 void run() {
   auto addr = Address::LookupAny("0.0.0.0:8033");
-  // auto addr2 = UnixAddress::ptr(new UnixAddress("/tmp/unix_addr"));
+  auto addr2 = UnixAddress::ptr(new UnixAddress("/tmp/unix_addr"));
   std::vector<Address::ptr> addrs;
   addrs.push_back(addr);
-  // addrs.push_back(addr2);
+  addrs.push_back(addr2);
 
   TcpServer::ptr tcp_server(new TcpServer);
 
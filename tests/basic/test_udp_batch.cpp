@@ -0,0 +1,123 @@
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/socket.h"
+#include "basic/utils.h"
+
+using namespace Basic;
+
+static const size_t s_packets = 200000;
+static const size_t s_window  = 64;
+static const size_t s_size    = 64;
+
+enum Mode { SINGLE, BATCH, GSO };
+
+static const char* mode_name(Mode mode) {
+  return mode == SINGLE ? "single" : (mode == BATCH ? "batch" : "gso/gro");
+}
+
+// 逐个 recvFrom/sendTo 回显
+static void echo_single(Socket::ptr sock) {
+  Address::ptr from(new IPv4Address);
+  char         buf[2048];
+  while (true) {
+    int rt = sock->recvFrom(buf, sizeof(buf), from);
+    if (rt < 0) { break; }
+    sock->sendTo(buf, rt, from);
+  }
+}
+
+// recvmmsg 收一批后原样 sendmmsg 回去, GRO 合并的数据报按原来的大小用 GSO 发回
+static void echo_batch(Socket::ptr sock) {
+  DatagramBatch batch(s_window, 65536);
+  while (true) {
+    int rt = sock->recvBatch(batch);
+    if (rt < 0) { break; }
+    batch.reflect();
+    sock->sendBatch(batch);
+  }
+}
+
+// 每次发送一个窗口的报文并等待全部回显, 返回收到的报文个数
+static size_t run_client(Socket::ptr sock, Address::ptr server, Mode mode) {
+  std::string   payload(s_size, 'x');
+  DatagramBatch send(s_window, s_size * s_window);
+  DatagramBatch recv(s_window, 65536);
+  Address::ptr  from(new IPv4Address);
+  size_t        received = 0;
+  char          buf[2048];
+  for (size_t sent = 0; sent < s_packets; sent += s_window) {
+    if (mode == SINGLE) {
+      for (size_t i = 0; i < s_window; ++i) {
+        sock->sendTo(payload.c_str(), payload.size(), server);
+      }
+    } else if (mode == BATCH) {
+      send.clear();
+      for (size_t i = 0; i < s_window; ++i) {
+        send.add(payload.c_str(), payload.size(), server->getAddr(), server->getAddrLen());
+      }
+      ASSERT(sock->sendBatch(send) == (int)s_window);
+    } else {
+      // 一个数据报由内核切分成 s_window 个报文
+      send.clear();
+      memset(send.getData(0), 'x', s_size * s_window);
+      send.commit(s_size * s_window, server->getAddr(), server->getAddrLen(), s_size);
+      ASSERT(sock->sendBatch(send) == 1);
+    }
+
+    size_t window = 0;
+    while (window < s_window) {
+      if (mode == SINGLE) {
+        int rt = sock->recvFrom(buf, sizeof(buf), from);
+        if (rt < 0) { break; }
+        ASSERT(rt == (int)s_size);
+        ++window;
+      } else {
+        int rt = sock->recvBatch(recv);
+        if (rt < 0) { break; }
+        for (size_t i = 0; i < recv.size(); ++i) {
+          uint16_t seg = recv.getSegmentSize(i);
+          ASSERT(seg == 0 || seg == s_size);
+          window += recv.getLength(i) / s_size;
+        }
+      }
+    }
+    received += window;
+  }
+  return received;
+}
+
+void bench(Mode mode) {
+  IOManager iom(1, "test_udp_batch", false);
+  iom.schedule([&iom, mode]() {
+    Socket::ptr server = Socket::CreateUDPSocket();
+    ASSERT(server->bind(IPv4Address::Create("127.0.0.1", 0)));
+    Socket::ptr client = Socket::CreateUDPSocket();
+    ASSERT(client->bind(IPv4Address::Create("127.0.0.1", 0)));
+    // 丢包时不会一直等待
+    client->setRecvTimeout(1000);
+    if (mode == GSO && (!server->setUdpGro(true) || !client->setUdpGro(true))) {
+      LOG_ERROR("UDP_GRO not supported, skip");
+      return;
+    }
+
+    iom.schedule(std::bind(mode == SINGLE ? echo_single : echo_batch, server));
+    uint64_t begin    = get_current_us();
+    size_t   received = run_client(client, server->getLocalAddress(), mode);
+    uint64_t used     = get_current_us() - begin;
+    // 关闭后回显协程的 recv 返回 -1
+    server->close();
+    LOG_ERROR("%-8s packets=%lu received=%lu used=%luus pps=%lu", mode_name(mode), s_packets,
+              received, used, received * 1000000 / (used + 1));
+    ASSERT(received >= s_packets * 9 / 10);
+  });
+}
+
+int main(int argc, char** argv) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  bench(SINGLE);
+  bench(BATCH);
+  bench(GSO);
+  LOG_ERROR("test_udp_batch ok");
+  return 0;
+}
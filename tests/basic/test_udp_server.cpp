@@ -0,0 +1,81 @@
+#include <atomic>
+
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/udp_server.h"
+
+using namespace Basic;
+
+static const size_t s_clients = 4;
+static const size_t s_packets = 1000;
+
+// 每个客户端发送带编号的报文, 检查回显的内容
+static void run_client(Address::ptr server, size_t id) {
+  Socket::ptr client = Socket::CreateUDPSocket();
+  ASSERT(client->bind(IPv4Address::Create("127.0.0.1", 0)));
+  client->setRecvTimeout(1000);
+  Address::ptr from(new IPv4Address);
+  size_t       received = 0;
+  char         buf[256];
+  for (size_t i = 0; i < s_packets; ++i) {
+    std::string payload = std::to_string(id) + ":" + std::to_string(i);
+    client->sendTo(payload.c_str(), payload.size(), server);
+    // 跳过之前超时的报文迟到的回显
+    int rt = 0;
+    while ((rt = client->recvFrom(buf, sizeof(buf), from)) > 0 &&
+           std::string(buf, rt) != payload) {
+      ASSERT(std::string(buf, rt).find(std::to_string(id) + ":") == 0);
+    }
+    if (rt < 0) { continue; }
+    ++received;
+  }
+  LOG_ERROR("client=%lu packets=%lu received=%lu", id, s_packets, received);
+  ASSERT(received >= s_packets * 9 / 10);
+}
+
+// 空报文同样被处理并回显
+static void run_empty_client(Address::ptr server) {
+  Socket::ptr client = Socket::CreateUDPSocket();
+  ASSERT(client->bind(IPv4Address::Create("127.0.0.1", 0)));
+  client->setRecvTimeout(1000);
+  Address::ptr from(new IPv4Address);
+  char         buf[256];
+  int          rt = -1;
+  for (int i = 0; i < 3 && rt != 0; ++i) {
+    ASSERT(client->sendTo(buf, 0, server) == 0);
+    rt = client->recvFrom(buf, sizeof(buf), from);
+  }
+  ASSERT(rt == 0);
+}
+
+int main(int argc, char** argv) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  {
+    IOManager iom(2, "test_udp_server", false);
+    iom.schedule([&iom]() {
+      UdpServer::ptr server(new UdpServer);
+      server->setHandler([](const UdpServer::Packet& packet, UdpServer::Reply& reply) {
+        ASSERT(reply.send(packet.data, packet.size));
+      });
+      ASSERT(server->bind(IPv4Address::Create("127.0.0.1", 0)));
+      ASSERT(server->getSocks().size() == iom.getThreadCount());
+      server->start();
+
+      Address::ptr addr  = server->getSocks()[0]->getLocalAddress();
+      auto         count = std::make_shared<std::atomic<size_t>>(0);
+      for (size_t i = 0; i < s_clients; ++i) {
+        iom.schedule([addr, i, count, server]() {
+          run_client(addr, i);
+          if (++*count == s_clients + 1) { server->stop(); }
+        });
+      }
+      iom.schedule([addr, count, server]() {
+        run_empty_client(addr);
+        if (++*count == s_clients + 1) { server->stop(); }
+      });
+    });
+  }
+  LOG_ERROR("test_udp_server ok");
+  return 0;
+}
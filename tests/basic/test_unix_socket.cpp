@@ -0,0 +1,82 @@
+#include <sys/stat.h>
+
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/tcp_server.h"
+
+using namespace Basic;
+
+static const char* s_path = "/tmp/test_unix_socket.sock";
+
+// 回显收到的数据
+class EchoServer : public TcpServer {
+protected:
+  void handleClient(Socket::ptr client) override {
+    char buf[1024];
+    while (true) {
+      int rt = client->recv(buf, sizeof(buf));
+      if (rt <= 0) { break; }
+      client->send(buf, rt);
+    }
+  }
+};
+
+static void echo(Socket::ptr sock, const std::string& msg) {
+  ASSERT(sock->send(msg.c_str(), msg.size()) == (int)msg.size());
+  char buf[1024];
+  int  rt = sock->recv(buf, sizeof(buf));
+  ASSERT(rt > 0 && std::string(buf, rt) == msg);
+}
+
+void test_pair() {
+  auto pair = Socket::CreateUnixPair();
+  ASSERT(pair.first && pair.second);
+  pair.first->send("ping", 4);
+  char buf[16];
+  ASSERT(pair.second->recv(buf, sizeof(buf)) == 4 && memcmp(buf, "ping", 4) == 0);
+}
+
+void test_server() {
+  // 上次异常退出留下的 socket 文件
+  unlink(s_path);
+  Socket::ptr stale = Socket::CreateUnixTCPSocket();
+  ASSERT(stale->bind(std::make_shared<UnixAddress>(s_path)));
+  stale->close();
+
+  TcpServer::ptr server(new EchoServer);
+  ASSERT(server->bind(std::make_shared<UnixAddress>(s_path), false));
+  server->start();
+
+  Socket::ptr client = Socket::CreateUnixTCPSocket();
+  ASSERT(client->connect(std::make_shared<UnixAddress>(s_path)));
+  echo(client, "hello unix");
+
+  // 已连接的socket交给另一端继续使用
+  auto pair = Socket::CreateUnixPair();
+  ASSERT(pair.first->sendFds("x", 1, {client->getSocket()}) == 1);
+  client->close();
+  std::vector<int> fds;
+  char             c;
+  ASSERT(pair.second->recvFds(&c, 1, fds) == 1 && c == 'x');
+  ASSERT(fds.size() == 1);
+  Socket::ptr passed = Socket::Attach(fds[0]);
+  ASSERT(passed && passed->getFamily() == AF_UNIX);
+  echo(passed, "hello passed fd");
+  passed->close();
+
+  server->stop();
+}
+
+int main(int argc, char** argv) {
+  {
+    IOManager iom(1, "test_unix_socket", false);
+    iom.schedule(test_pair);
+    iom.schedule(test_server);
+  }
+  // 服务器停止后删除 socket 文件
+  struct stat st;
+  ASSERT(stat(s_path, &st) == -1);
+  LOG_INFO("test_unix_socket ok");
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include "basic/config.h"
+#include "basic/fiber_sync.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "basic/watchdog.h"
+
+using namespace Basic;
+
+// 不让出地计算 ms 毫秒, yield 时周期性调用 MaybeYield
+static int busy(uint64_t ms, bool yield) {
+  int      yields = 0;
+  uint64_t end    = get_current_ms() + ms;
+  while (get_current_ms() < end) {
+    if (yield && Fiber::MaybeYield()) { ++yields; }
+  }
+  return yields;
+}
+
+// 单线程上长计算调用 MaybeYield 后, 后面的任务不用等它算完
+void test_maybe_yield() {
+  IOManager         iom(1, "yield", false);
+  std::atomic<bool> busy_done{false};
+  std::atomic<bool> other_before{false};
+  std::atomic<int>  yields{0};
+  iom.schedule([&]() {
+    yields    = busy(200, true);
+    busy_done = true;
+  });
+  iom.schedule([&]() { other_before = !busy_done; });
+  iom.stop();
+  ASSERT(other_before);
+  ASSERT(yields > 0);
+}
+
+// IO调度器上超出预算的协程转移到cpu池
+void test_cpu_pool() {
+  IOManager cpu(1, "cpu_pool", false);
+  IOManager io(1, "io", false);
+  io.setCpuPool(&cpu);
+
+  WaitGroup        wg;
+  std::atomic<int> io_name{0};
+  std::atomic<int> cpu_name{0};
+  std::atomic<int> after_io{0};
+  wg.add();
+  io.schedule([&]() {
+    io_name = Scheduler::GetThis() == &io;
+    busy(100, true);
+    cpu_name = Scheduler::GetThis() == &cpu;
+    // 转移后调用hook的函数, 在cpu池的定时器上挂起
+    usleep(1000);
+    after_io = Scheduler::GetThis() == &cpu;
+    wg.done();
+  });
+  wg.wait();
+  ASSERT(io_name && cpu_name && after_io);
+  io.stop();
+  cpu.stop();
+}
+
+// 看门狗报告不让出的协程
+void test_watchdog() {
+  Config::Lookup("fiber.watchdog_ms", (uint32_t)0)->setValue(50);
+  {
+    IOManager iom(1, "watchdog", false);
+    iom.schedule([]() { busy(200, false); });
+    iom.stop();
+  }
+  ASSERT(FiberWatchdogMgr::GetInstance()->getReportCount() == 1);
+  Config::Lookup("fiber.watchdog_ms", (uint32_t)0)->setValue(0);
+}
+
+int main(int argc, char* argv[]) {
+  test_maybe_yield();
+  test_cpu_pool();
+  test_watchdog();
+  LOG_INFO("test_watchdog ok");
+  return 0;
+}
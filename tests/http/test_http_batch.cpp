@@ -0,0 +1,117 @@
+#include <atomic>
+
+#include "basic/cancel.h"
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "http/http_connection.h"
+
+using namespace http;
+
+// 模拟耗时为 delay_ms 的请求
+static HttpConnectionPool::BatchJob make_job(uint64_t delay_ms, int result = 0,
+                                             std::atomic<int>* calls = nullptr) {
+  return [delay_ms, result, calls](uint64_t timeout_ms) {
+    if (calls) { ++*calls; }
+    if (delay_ms > timeout_ms) {
+      usleep(timeout_ms * 1000);
+      return std::make_shared<HttpResult>((int)HttpResult::Error::TIMEOUT, nullptr, "timeout");
+    }
+    usleep(delay_ms * 1000);
+    return std::make_shared<HttpResult>(result, nullptr, std::to_string(delay_ms));
+  };
+}
+
+void test_batch() {
+  // 并发执行, 结果按提交顺序返回
+  uint64_t begin = get_current_ms();
+  auto     results =
+      HttpConnectionPool::DoBatch({make_job(300), make_job(100), make_job(200)}, 1000);
+  uint64_t used = get_current_ms() - begin;
+  ASSERT(results.size() == 3);
+  ASSERT(results[0]->error == "300" && results[1]->error == "100" && results[2]->error == "200");
+  ASSERT(used < 500);
+  LOG_INFO_STREAM << "all used=" << used;
+
+  // 单个请求超时
+  results = HttpConnectionPool::DoBatch({make_job(50), make_job(500)}, 100);
+  ASSERT(results[0]->result == (int)HttpResult::Error::OK);
+  ASSERT(results[1]->result == (int)HttpResult::Error::TIMEOUT);
+
+  // 整体超时
+  HttpBatchOptions opts;
+  opts.timeout_ms = 150;
+  begin           = get_current_ms();
+  results         = HttpConnectionPool::DoBatch({make_job(50), make_job(1000)}, 5000, opts);
+  used            = get_current_ms() - begin;
+  ASSERT(results[0]->result == (int)HttpResult::Error::OK);
+  ASSERT(results[1]->result == (int)HttpResult::Error::TIMEOUT);
+  ASSERT(used < 400);
+  LOG_INFO_STREAM << "deadline used=" << used;
+
+  // first_n: 两个成功即返回, 失败不计数
+  opts         = HttpBatchOptions();
+  opts.first_n = 2;
+  begin        = get_current_ms();
+  results      = HttpConnectionPool::DoBatch({make_job(20, (int)HttpResult::Error::CONNECT_FAIL),
+                                              make_job(50), make_job(100), make_job(1000)},
+                                             5000, opts);
+  used         = get_current_ms() - begin;
+  ASSERT(results[0]->result == (int)HttpResult::Error::CONNECT_FAIL);
+  ASSERT(results[1]->result == (int)HttpResult::Error::OK);
+  ASSERT(results[2]->result == (int)HttpResult::Error::OK);
+  ASSERT(results[3]->result == (int)HttpResult::Error::CANCELLED);
+  ASSERT(used < 400);
+  LOG_INFO_STREAM << "first_n used=" << used;
+
+  // hedge: 第一次慢, 第二次快, 取先完成的
+  std::atomic<int>             calls{0};
+  HttpConnectionPool::BatchJob hedged = [&calls](uint64_t timeout_ms) {
+    usleep(calls++ == 0 ? 1000 * 1000 : 10 * 1000);
+    return std::make_shared<HttpResult>(0, nullptr, "ok");
+  };
+  opts          = HttpBatchOptions();
+  opts.hedge_ms = 50;
+  begin         = get_current_ms();
+  results       = HttpConnectionPool::DoBatch({hedged}, 5000, opts);
+  used          = get_current_ms() - begin;
+  ASSERT(results[0]->result == (int)HttpResult::Error::OK);
+  ASSERT(calls == 2);
+  ASSERT(used < 500);
+  LOG_INFO_STREAM << "hedge used=" << used;
+
+  // 未超过 hedge_ms 的请求不会重发
+  calls   = 0;
+  results = HttpConnectionPool::DoBatch({make_job(10, 0, &calls), make_job(10, 0, &calls)}, 5000,
+                                        opts);
+  ASSERT(calls == 2);
+
+  // 继承调用方协程的截止时间, 结束时取消未完成的请求
+  auto cancelled = std::make_shared<std::atomic<int>>(0);
+  begin          = get_current_ms();
+  {
+    CancelScope scope(100);
+    HttpConnectionPool::BatchJob slow = [cancelled](uint64_t timeout_ms) {
+      ASSERT(timeout_ms <= 100 && CancelToken::Remaining() <= 100);
+      if (usleep(1000 * 1000) == -1) { ++*cancelled; }
+      return std::make_shared<HttpResult>((int)HttpResult::Error::TIMEOUT, nullptr, "timeout");
+    };
+    results = HttpConnectionPool::DoBatch({slow, slow}, 5000);
+  }
+  used = get_current_ms() - begin;
+  ASSERT(results[0]->result == (int)HttpResult::Error::TIMEOUT);
+  ASSERT(used < 300);
+  for (int i = 0; i < 20 && *cancelled < 2; ++i) {
+    usleep(10 * 1000);
+  }
+  ASSERT(*cancelled == 2);
+  LOG_INFO_STREAM << "inherit deadline used=" << used;
+
+  LOG_INFO("test_batch ok");
+}
+
+int main(int argc, char* argv[]) {
+  IOManager iom(2);
+  iom.schedule(test_batch);
+  return 0;
+}
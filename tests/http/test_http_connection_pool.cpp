@@ -0,0 +1,122 @@
+#include <atomic>
+
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "http/http_connection.h"
+#include "http/http_server.h"
+
+using namespace http;
+
+static const int s_fibers   = 16;
+static const int s_requests = 1000;
+
+static HttpServer::ptr s_server;
+
+void start_server() {
+  s_server.reset(new HttpServer(true));
+  Address::ptr addr = Address::LookupAnyIPAddress("127.0.0.1:8021");
+  while (!s_server->bind(addr, false)) {
+    sleep(1);
+  }
+  s_server->getServletDispatch()->addServlet(
+      "/bench", [](HttpRequest::ptr req, HttpResponse::ptr rsp, HttpSession::ptr session) {
+        rsp->setBody("ok");
+        return 0;
+      });
+  s_server->start();
+}
+
+// s_fibers 个协程并发请求, 返回失败数, max_total 记录请求过程中连接总数的最大值
+static int bench(const std::string& name, HttpConnectionPool::ptr pool, uint32_t& max_total) {
+  std::atomic<int>      done{0};
+  std::atomic<int>      fails{0};
+  std::atomic<uint32_t> max{0};
+  uint64_t              begin = get_current_us();
+  for (int i = 0; i < s_fibers; ++i) {
+    IOManager::GetThis()->schedule([pool, &done, &fails, &max]() {
+      for (int j = 0; j < s_requests; ++j) {
+        auto r = pool->doGet("/bench", 1000);
+        if (r->result != (int)HttpResult::Error::OK) { ++fails; }
+        for (uint32_t total = pool->getTotal(), old = max;
+             old < total && !max.compare_exchange_weak(old, total);) {}
+      }
+      ++done;
+    });
+  }
+  while (done < s_fibers) {
+    usleep(10 * 1000);
+  }
+  uint64_t used  = get_current_us() - begin;
+  uint64_t total = (uint64_t)s_fibers * s_requests;
+  max_total      = max;
+  LOG_ERROR_STREAM << name << ": requests=" << total << " fails=" << fails
+                   << " used_ms=" << used / 1000 << " qps=" << total * 1000000 / (used ? used : 1)
+                   << " created=" << pool->getCreated() << " reused=" << pool->getReused()
+                   << " max_total=" << max_total;
+  return fails;
+}
+
+// 连接数不超过上限, 连接被复用
+void test_bounded() {
+  HttpConnectionPool::ptr pool(
+      new HttpConnectionPool("127.0.0.1", "", 8021, 8, 1000 * 30, 10000));
+  uint32_t max_total = 0;
+  ASSERT(bench("bounded(8)", pool, max_total) == 0);
+  ASSERT(max_total <= 8 && pool->getCreated() <= 8);
+  ASSERT(pool->getReused() > 0);
+  ASSERT(pool->getCreated() + pool->getReused() == (uint64_t)s_fibers * s_requests);
+}
+
+// 每个连接只发一个请求, 用完即关闭
+void test_max_request() {
+  HttpConnectionPool::ptr pool(new HttpConnectionPool("127.0.0.1", "", 8021, 4, 1000 * 30, 1));
+  for (int i = 0; i < 10; ++i) {
+    ASSERT(pool->doGet("/bench", 1000)->result == (int)HttpResult::Error::OK);
+  }
+  ASSERT(pool->getCreated() == 10 && pool->getReused() == 0);
+  ASSERT(pool->getTotal() == 0 && pool->getIdle() == 0);
+}
+
+// 超过存活时间的连接不再复用
+void test_max_alive_time() {
+  HttpConnectionPool::ptr pool(new HttpConnectionPool("127.0.0.1", "", 8021, 4, 100, 0));
+  ASSERT(pool->doGet("/bench", 1000)->result == (int)HttpResult::Error::OK);
+  ASSERT(pool->doGet("/bench", 1000)->result == (int)HttpResult::Error::OK);
+  ASSERT(pool->getCreated() == 1 && pool->getReused() == 1);
+  usleep(150 * 1000);
+  ASSERT(pool->doGet("/bench", 1000)->result == (int)HttpResult::Error::OK);
+  ASSERT(pool->getCreated() == 2 && pool->getTotal() == 1);
+}
+
+// 空闲超时的连接被定时器回收
+void test_idle_check() {
+  HttpConnectionPool::ptr pool(new HttpConnectionPool("127.0.0.1", "", 8021, 4, 1000 * 30, 0));
+  pool->startIdleCheck(100, 50);
+  ASSERT(pool->doGet("/bench", 1000)->result == (int)HttpResult::Error::OK);
+  ASSERT(pool->getIdle() == 1 && pool->getTotal() == 1);
+  usleep(300 * 1000);
+  ASSERT(pool->getIdle() == 0 && pool->getTotal() == 0);
+  pool->stopIdleCheck();
+}
+
+void test_pool() {
+  test_bounded();
+  test_max_request();
+  test_max_alive_time();
+  test_idle_check();
+
+  auto r = HttpConnectionPoolMgr::GetInstance()->doGet("http://127.0.0.1:8021/bench", 1000);
+  ASSERT(r->result == (int)HttpResult::Error::OK);
+  HttpConnectionPoolMgr::GetInstance()->clear();
+  s_server->stop();
+  LOG_ERROR("test_http_connection_pool ok");
+}
+
+int main(int argc, char* argv[]) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  IOManager iom(2);
+  iom.schedule(start_server);
+  iom.addTimer(500, test_pool);
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "http/http_connection.h"
+#include "http/http_parser.h"
+
+using namespace http;
+
+static const size_t s_big_chunk = 1024 * 1024;
+static const size_t s_big_body  = 8 * 1024 * 1024;
+
+static Socket::ptr s_server;
+
+static bool read_request(Socket::ptr client) {
+  std::string req;
+  char        buff[1024];
+  while (req.find("\r\n\r\n") == std::string::npos) {
+    int rt = client->recv(buff, sizeof(buff));
+    if (rt <= 0) { return false; }
+    req.append(buff, rt);
+  }
+  return true;
+}
+
+// 分多次小段写出, 让 chunk 头和 chunk 数据跨越多次 read
+static void send_slowly(Socket::ptr client, const std::string& data, size_t step) {
+  for (size_t i = 0; i < data.size();) {
+    int rt = client->send(data.c_str() + i, std::min(step, data.size() - i));
+    ASSERT(rt > 0);
+    i += rt;
+  }
+}
+
+static std::string make_chunk(size_t size, char c) {
+  char head[32];
+  snprintf(head, sizeof(head), "%zx\r\n", size);
+  return head + std::string(size, c) + "\r\n";
+}
+
+void run_server() {
+  s_server = Socket::CreateTCPSocket();
+  s_server->setOption(SOL_SOCKET, SO_REUSEADDR, 1);
+  ASSERT(s_server->bind(Address::LookupAnyIPAddress("127.0.0.1:8022")));
+  ASSERT(s_server->listen());
+  Socket::ptr client = s_server->accept();
+  ASSERT(client);
+  s_server->close();
+
+  // 1. chunked, 含一个大于缓冲区的chunk, 带扩展和trailer
+  ASSERT(read_request(client));
+  std::string rsp = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+  rsp += make_chunk(5, 'a');
+  rsp += "3;ext=1\r\nbbb\r\n";
+  rsp += make_chunk(s_big_chunk, 'c');
+  rsp += "0\r\nX-Trailer: t\r\n\r\n";
+  send_slowly(client, rsp.substr(0, 64), 1);
+  send_slowly(client, rsp.substr(64), 4000);
+
+  // 2. 同一连接上的 content-length 大响应
+  ASSERT(read_request(client));
+  std::string head = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(s_big_body) + "\r\n\r\n";
+  send_slowly(client, head, head.size());
+  std::string body(64 * 1024, 'd');
+  for (size_t i = 0; i < s_big_body; i += body.size()) {
+    send_slowly(client, body, body.size());
+  }
+
+  // 3. 非流式接收 chunked
+  ASSERT(read_request(client));
+  rsp = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" + make_chunk(3, 'e') +
+        make_chunk(4, 'f') + "0\r\n\r\n";
+  send_slowly(client, rsp, 7);
+
+  read_request(client);
+  client->close();
+}
+
+void run_client() {
+  Address::ptr addr = Address::LookupAnyIPAddress("127.0.0.1:8022");
+  Socket::ptr  sock = Socket::CreateTCP(addr);
+  ASSERT(sock->connect(addr));
+  sock->setRecvTimeout(5000);
+  HttpConnection::ptr conn(new HttpConnection(sock));
+
+  HttpRequest::ptr req(new HttpRequest);
+  req->setPath("/stream");
+  req->setClose(false);
+
+  uint64_t total   = 0;
+  uint64_t max_seg = 0;
+  uint64_t count_c = 0;
+  auto     cb      = [&](const char* data, size_t len) {
+    total   += len;
+    max_seg = std::max(max_seg, (uint64_t)len);
+    count_c += std::count(data, data + len, 'c');
+    return true;
+  };
+
+  conn->sendRequest(req);
+  auto rsp = conn->recvResponse(cb);
+  ASSERT(rsp && rsp->getBody().empty());
+  ASSERT(total == 5 + 3 + s_big_chunk);
+  ASSERT(count_c == s_big_chunk);
+  LOG_INFO_STREAM << "chunked total=" << total << " max_segment=" << max_seg;
+
+  total = max_seg = 0;
+  conn->sendRequest(req);
+  rsp = conn->recvResponse(cb);
+  ASSERT(rsp);
+  ASSERT(total == s_big_body);
+  ASSERT(max_seg <= HttpResponseParser::GetHttpResponseBufferSize());
+  LOG_INFO_STREAM << "content-length total=" << total << " max_segment=" << max_seg;
+
+  conn->sendRequest(req);
+  rsp = conn->recvResponse();
+  ASSERT(rsp && rsp->getBody() == "eeeffff");
+
+  conn->sendRequest(req);
+  LOG_INFO("test_http_stream_response ok");
+}
+
+int main(int argc, char* argv[]) {
+  IOManager iom(2);
+  iom.schedule(run_server);
+  iom.addTimer(100, run_client);
+  return 0;
+}
@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "basic/iomanager.h"
+#include "basic/log.h"
+#include "basic/macro.h"
+#include "http/http_connection.h"
+#include "http/http_server.h"
+
+using namespace http;
+
+static const size_t s_requests = 5000;
+static const char*  s_path     = "/tmp/test_http_unix.sock";
+
+static HttpServer::ptr start_server(Address::ptr addr) {
+  HttpServer::ptr server(new HttpServer(true));
+  ASSERT(server->bind(addr, false));
+  server->getServletDispatch()->addServlet(
+      "/bench", [](HttpRequest::ptr req, HttpResponse::ptr rsp, HttpSession::ptr session) {
+        rsp->setBody("ok");
+        return 0;
+      });
+  server->start();
+  return server;
+}
+
+// 单个协程顺序请求, 统计每个请求的延迟
+static void bench(const std::string& name, HttpConnectionPool::ptr pool) {
+  std::vector<uint64_t> used;
+  for (size_t i = 0; i < s_requests; ++i) {
+    uint64_t begin = get_current_us();
+    auto     r     = pool->doGet("/bench", 1000);
+    used.push_back(get_current_us() - begin);
+    ASSERT(r->result == (int)HttpResult::Error::OK);
+  }
+  std::sort(used.begin(), used.end());
+  uint64_t sum = 0;
+  for (auto i : used) {
+    sum += i;
+  }
+  LOG_ERROR("%-4s requests=%lu avg=%luus p50=%luus p99=%luus created=%lu", name.c_str(),
+            s_requests, sum / used.size(), used[used.size() / 2], used[used.size() * 99 / 100],
+            pool->getCreated());
+}
+
+void run() {
+  auto tcp_server  = start_server(Address::LookupAnyIPAddress("127.0.0.1:8023"));
+  auto unix_server = start_server(std::make_shared<UnixAddress>(s_path));
+
+  bench("tcp", std::make_shared<HttpConnectionPool>("127.0.0.1", "", 8023, 1, 60 * 1000, 0));
+  bench("uds", HttpConnectionPool::CreateUnix(s_path, "", 1, 60 * 1000, 0));
+
+  tcp_server->stop();
+  unix_server->stop();
+}
+
+int main(int argc, char** argv) {
+  LOG_ROOT->setLevel(LogLevel::ERROR);
+  IOManager iom(1, "test_http_unix", false);
+  iom.schedule(run);
+  return 0;
+}